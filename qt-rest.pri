@@ -1,28 +1,83 @@
-CONFIG += c++17 exceptions
-
-HEADERS += \
-	$$PWD/src/cborcontenthandler.h \
-	$$PWD/src/contenthandler.h \
-	$$PWD/src/irestextender.h \
-	$$PWD/src/jsoncontenthandler.h \
-	$$PWD/src/qtrest_exceptions.h \
-	$$PWD/src/qtrest_global.h \
-	$$PWD/src/restbuilder.h \
-	$$PWD/src/restbuilder_data.h \
-	$$PWD/src/restbuilder_decl.h \
-	$$PWD/src/restbuilder_impl.h \
-	$$PWD/src/restreply.h
-
-SOURCES += \
-	$$PWD/src/cborcontenthandler.cpp \
-    $$PWD/src/irestextender.cpp \
-	$$PWD/src/jsoncontenthandler.cpp \
-	$$PWD/src/qtrest_exceptions.cpp \
-	$$PWD/src/restbuilder.cpp \
-	$$PWD/src/restreply.cpp
-
-INCLUDEPATH += $$PWD/src
-
-QDEP_PACKAGE_EXPORTS += QTREST_EXPORT
-!qdep_build: DEFINES += "QTREST_EXPORT="
-QDEP_DEPENDS += Skycoder42/qt-json@1.0.0
+CONFIG += c++17 exceptions
+
+HEADERS += \
+	$$PWD/src/bodypipe.h \
+	$$PWD/src/bodystreamreader.h \
+	$$PWD/src/bufferednetworkreply.h \
+	$$PWD/src/cborcontenthandler.h \
+	$$PWD/src/compression.h \
+	$$PWD/src/contenthandler.h \
+	$$PWD/src/deliveryqueue.h \
+	$$PWD/src/eventsource.h \
+	$$PWD/src/filedownload.h \
+	$$PWD/src/irestextender.h \
+	$$PWD/src/jsoncontenthandler.h \
+	$$PWD/src/jsonstreamreader.h \
+	$$PWD/src/ndjsonbodystream.h \
+	$$PWD/src/qtrest_exceptions.h \
+	$$PWD/src/qtrest_global.h \
+	$$PWD/src/requestcoalescer.h \
+	$$PWD/src/requesttiming.h \
+	$$PWD/src/restbatch.h \
+	$$PWD/src/restbuilder.h \
+	$$PWD/src/restbuilder_data.h \
+	$$PWD/src/restbuilder_decl.h \
+	$$PWD/src/restbuilder_impl.h \
+	$$PWD/src/restcache.h \
+	$$PWD/src/restengine.h \
+	$$PWD/src/restmetrics.h \
+	$$PWD/src/restpaginator.h \
+	$$PWD/src/restreply.h \
+	$$PWD/src/restscheduler.h \
+	$$PWD/src/resttracer.h \
+	$$PWD/src/retrypolicy.h \
+	$$PWD/src/serializingdevice.h
+
+SOURCES += \
+	$$PWD/src/bodypipe.cpp \
+	$$PWD/src/bodystreamreader.cpp \
+	$$PWD/src/bufferednetworkreply.cpp \
+	$$PWD/src/cborcontenthandler.cpp \
+	$$PWD/src/compression.cpp \
+	$$PWD/src/deliveryqueue.cpp \
+	$$PWD/src/eventsource.cpp \
+	$$PWD/src/filedownload.cpp \
+    $$PWD/src/irestextender.cpp \
+	$$PWD/src/jsoncontenthandler.cpp \
+	$$PWD/src/jsonstreamreader.cpp \
+	$$PWD/src/ndjsonbodystream.cpp \
+	$$PWD/src/qtrest_exceptions.cpp \
+	$$PWD/src/requestcoalescer.cpp \
+	$$PWD/src/requesttiming.cpp \
+	$$PWD/src/restbatch.cpp \
+	$$PWD/src/restbuilder.cpp \
+	$$PWD/src/restcache.cpp \
+	$$PWD/src/restengine.cpp \
+	$$PWD/src/restmetrics.cpp \
+	$$PWD/src/restpaginator.cpp \
+	$$PWD/src/restreply.cpp \
+	$$PWD/src/restscheduler.cpp \
+	$$PWD/src/resttracer.cpp \
+	$$PWD/src/retrypolicy.cpp \
+	$$PWD/src/serializingdevice.cpp
+
+INCLUDEPATH += $$PWD/src
+
+qtConfig(system-zlib) {
+	DEFINES += QT_REST_SYSTEM_ZLIB
+	QMAKE_USE_PRIVATE += zlib
+} else: QT_PRIVATE += zlib-private
+
+qtrest_brotli {
+	DEFINES += QT_REST_USE_BROTLI
+	LIBS += -lbrotlienc -lbrotlidec
+}
+
+qtrest_zstd {
+	DEFINES += QT_REST_USE_ZSTD
+	LIBS += -lzstd
+}
+
+QDEP_PACKAGE_EXPORTS += QTREST_EXPORT
+!qdep_build: DEFINES += "QTREST_EXPORT="
+QDEP_DEPENDS += Skycoder42/qt-json@1.0.0
@@ -1,10 +1,11 @@
-TEMPLATE = subdirs
-
-SUBDIRS += \
-    lib
-
-OTHER_FILES += \
-    qt-rest.pri \
-    README.md \
-    LICENSE \
-    .github/workflows/build.yml
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    lib \
+    tests
+
+OTHER_FILES += \
+    qt-rest.pri \
+    README.md \
+    LICENSE \
+    .github/workflows/build.yml
@@ -0,0 +1,141 @@
+#include "bodypipe.h"
+#include <algorithm>
+#include <cstring>
+using namespace QtRest;
+using namespace QtRest::__private;
+
+BodyPipeReader::BodyPipeReader(qint64 capacity, QObject *parent) :
+	QIODevice{parent},
+	_capacity{std::max<qint64>(capacity, 1)}
+{
+	open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+qint64 BodyPipeReader::capacity() const
+{
+	return _capacity;
+}
+
+qint64 BodyPipeReader::buffered() const
+{
+	return _buffer.size() - _offset;
+}
+
+bool BodyPipeReader::isSequential() const
+{
+	return true;
+}
+
+bool BodyPipeReader::atEnd() const
+{
+	return _closed && buffered() == 0;
+}
+
+qint64 BodyPipeReader::bytesAvailable() const
+{
+	return buffered() + QIODevice::bytesAvailable();
+}
+
+qint64 BodyPipeReader::readData(char *data, qint64 maxSize)
+{
+	const auto size = std::min(maxSize, buffered());
+	if (size == 0)
+		return _closed ? -1 : 0;
+
+	std::memcpy(data, _buffer.constData() + _offset, static_cast<size_t>(size));
+	_offset += size;
+	if (_offset == _buffer.size()) {
+		_buffer.clear();
+		_offset = 0;
+	}
+	if (_writer)
+		_writer->consumed(size);
+	return size;
+}
+
+qint64 BodyPipeReader::writeData(const char *, qint64)
+{
+	return -1;
+}
+
+qint64 BodyPipeReader::push(const char *data, qint64 size)
+{
+	// writes beyond the capacity are rejected, the producer continues after bytesWritten
+	const auto accepted = std::min(size, _capacity - buffered());
+	if (accepted <= 0)
+		return 0;
+
+	if (_offset > 0 && _offset > _buffer.size() / 2) {
+		_buffer.remove(0, static_cast<int>(_offset));
+		_offset = 0;
+	}
+	_buffer.append(data, static_cast<int>(accepted));
+	emit readyRead();
+	return accepted;
+}
+
+void BodyPipeReader::closeWrite()
+{
+	if (_closed)
+		return;
+	_closed = true;
+	emit readyRead();
+	emit readChannelFinished();
+}
+
+
+
+BodyPipeWriter::BodyPipeWriter(BodyPipeReader *reader, QObject *parent) :
+	QIODevice{parent},
+	_reader{reader}
+{
+	_reader->_writer = this;
+	open(QIODevice::WriteOnly | QIODevice::Unbuffered);
+}
+
+BodyPipeWriter::~BodyPipeWriter()
+{
+	if (_reader)
+		_reader->closeWrite();
+}
+
+bool BodyPipeWriter::canWrite() const
+{
+	return _reader && _reader->buffered() < _reader->capacity();
+}
+
+qint64 BodyPipeWriter::bytesToWrite() const
+{
+	return _reader ? _reader->buffered() : 0;
+}
+
+bool BodyPipeWriter::isSequential() const
+{
+	return true;
+}
+
+void BodyPipeWriter::close()
+{
+	if (_reader)
+		_reader->closeWrite();
+	QIODevice::close();
+}
+
+qint64 BodyPipeWriter::readData(char *, qint64)
+{
+	return -1;
+}
+
+qint64 BodyPipeWriter::writeData(const char *data, qint64 maxSize)
+{
+	if (!_reader) {
+		setErrorString(tr("The upload was closed by the receiver"));
+		return -1;
+	}
+	return _reader->push(data, maxSize);
+}
+
+void BodyPipeWriter::consumed(qint64 size)
+{
+	emit bytesWritten(size);
+}
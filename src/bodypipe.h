@@ -0,0 +1,72 @@
+#pragma once
+
+#include "qtrest_global.h"
+
+#include <QtCore/QIODevice>
+#include <QtCore/QPointer>
+
+namespace QtRest {
+
+class BodyPipeWriter;
+
+namespace __private {
+
+class QTREST_EXPORT BodyPipeReader : public QIODevice
+{
+	Q_OBJECT
+	friend class QtRest::BodyPipeWriter;
+
+public:
+	explicit BodyPipeReader(qint64 capacity, QObject *parent = nullptr);
+
+	qint64 capacity() const;
+	qint64 buffered() const;
+
+	bool isSequential() const override;
+	bool atEnd() const override;
+	qint64 bytesAvailable() const override;
+
+protected:
+	qint64 readData(char *data, qint64 maxSize) override;
+	qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+	QPointer<BodyPipeWriter> _writer;
+	QByteArray _buffer;
+	qint64 _offset = 0;
+	qint64 _capacity;
+	bool _closed = false;
+
+	qint64 push(const char *data, qint64 size);
+	void closeWrite();
+};
+
+}
+
+// write() accepts only what fits into the pipe and returns 0 while it is full,
+// producers have to wait for bytesWritten() or canWrite() and write the remainder in a loop
+class QTREST_EXPORT BodyPipeWriter : public QIODevice
+{
+	Q_OBJECT
+	friend class __private::BodyPipeReader;
+
+public:
+	explicit BodyPipeWriter(__private::BodyPipeReader *reader, QObject *parent = nullptr);
+	~BodyPipeWriter() override;
+
+	bool canWrite() const;
+	qint64 bytesToWrite() const override;
+	bool isSequential() const override;
+	void close() override;
+
+protected:
+	qint64 readData(char *data, qint64 maxSize) override;
+	qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+	QPointer<__private::BodyPipeReader> _reader;
+
+	void consumed(qint64 size);
+};
+
+}
@@ -0,0 +1,75 @@
+#include "bodystreamreader.h"
+#include <algorithm>
+using namespace QtRest::__private;
+
+BodyStreamReader::BodyStreamReader(QNetworkReply *reply) :
+	QObject{reply},
+	_reply{reply}
+{
+	connect(_reply, &QNetworkReply::readyRead,
+			this, &BodyStreamReader::readChunk);
+	connect(_reply, &QNetworkReply::finished,
+			this, &BodyStreamReader::replyFinished);
+}
+
+QNetworkReply *BodyStreamReader::reply() const
+{
+	return _reply;
+}
+
+BodyStreamReader::State BodyStreamReader::state() const
+{
+	return _state;
+}
+
+bool BodyStreamReader::hasConsumed(QNetworkReply *reply)
+{
+	if (!reply)
+		return false;
+	const auto readers = reply->findChildren<BodyStreamReader*>(QString{}, Qt::FindDirectChildrenOnly);
+	return std::any_of(readers.begin(), readers.end(), [](BodyStreamReader *reader) {
+		return reader->state() == State::Active || reader->state() == State::Finished;
+	});
+}
+
+void BodyStreamReader::readChunk()
+{
+	if (_state == State::Pending && !activate())
+		return;
+	if (_state != State::Active)
+		return;
+
+	if (const auto available = _reply->bytesAvailable(); available > 0)
+		consume(_reply->read(available));
+}
+
+void BodyStreamReader::replyFinished()
+{
+	readChunk();
+	if (_state == State::Active) {
+		finish();
+		_state = State::Finished;
+	}
+}
+
+bool BodyStreamReader::activate()
+{
+	const auto header = _reply->header(QNetworkRequest::ContentTypeHeader).toByteArray();
+	const auto cList = header.split(';');
+	auto accepted = acceptsContentType(cList.first().trimmed());
+	for (auto i = 1; accepted && i < cList.size(); ++i) {
+		// only UTF-8 can be streamed, everything else goes through the codec path
+		const auto args = cList[i].trimmed().split('=');
+		if (args.size() == 2 && args[0] == "charset")
+			accepted = args[1].trimmed().toLower() == "utf-8";
+	}
+
+	if (accepted)
+		_state = State::Active;
+	else {
+		_state = State::Passive;
+		disconnect(_reply, &QNetworkReply::readyRead,
+				   this, &BodyStreamReader::readChunk);
+	}
+	return accepted;
+}
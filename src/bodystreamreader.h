@@ -0,0 +1,54 @@
+#pragma once
+
+#include "qtrest_global.h"
+
+#include <QtCore/QObject>
+#include <QtCore/QByteArray>
+
+#include <QtNetwork/QNetworkReply>
+
+namespace QtRest::__private {
+
+class QTREST_EXPORT BodyStreamReader : public QObject
+{
+	Q_OBJECT
+
+public:
+	enum class State {
+		Pending,
+		Active,
+		Passive,
+		Finished
+	};
+	Q_ENUM(State)
+
+	explicit BodyStreamReader(QNetworkReply *reply);
+
+	QNetworkReply *reply() const;
+	State state() const;
+
+	template <typename TReader>
+	static TReader *find(QNetworkReply *reply) {
+		return reply ?
+			reply->findChild<TReader*>(QString{}, Qt::FindDirectChildrenOnly) :
+			nullptr;
+	}
+	static bool hasConsumed(QNetworkReply *reply);
+
+protected:
+	virtual bool acceptsContentType(const QByteArray &contentType) const = 0;
+	virtual void consume(const QByteArray &chunk) = 0;
+	virtual void finish() = 0;
+
+private Q_SLOTS:
+	void readChunk();
+	void replyFinished();
+
+private:
+	QNetworkReply *_reply;
+	State _state = State::Pending;
+
+	bool activate();
+};
+
+}
@@ -0,0 +1,185 @@
+#include "bufferednetworkreply.h"
+#include <QtCore/QHash>
+#include <algorithm>
+#include <cstring>
+#include <utility>
+using namespace QtRest::__private;
+
+BufferedNetworkReply::BufferedNetworkReply(const QNetworkRequest &request, QObject *parent) :
+	BufferedNetworkReply{request, QtRest::Verbs::GET, parent}
+{}
+
+BufferedNetworkReply::BufferedNetworkReply(const QNetworkRequest &request, const QByteArray &verb, QObject *parent) :
+	QNetworkReply{parent}
+{
+	// proxies report the operation of the request they stand for, even before a source is known
+	static const QHash<QByteArray, QNetworkAccessManager::Operation> operations {
+		{QtRest::Verbs::GET, QNetworkAccessManager::GetOperation},
+		{QtRest::Verbs::HEAD, QNetworkAccessManager::HeadOperation},
+		{QtRest::Verbs::POST, QNetworkAccessManager::PostOperation},
+		{QtRest::Verbs::PUT, QNetworkAccessManager::PutOperation},
+		{QtRest::Verbs::DELETE, QNetworkAccessManager::DeleteOperation}
+	};
+	auto proxyRequest = request;
+	const auto operation = operations.value(verb, QNetworkAccessManager::CustomOperation);
+	if (operation == QNetworkAccessManager::CustomOperation)
+		proxyRequest.setAttribute(QNetworkRequest::CustomVerbAttribute, verb);
+	setRequest(proxyRequest);
+	setUrl(request.url());
+	setOperation(operation);
+	setOpenMode(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+BufferedNetworkReply::MetaData BufferedNetworkReply::readMetaData(const QNetworkReply *source)
+{
+	MetaData metaData;
+	metaData.url = source->url();
+	metaData.headers = source->rawHeaderPairs();
+	for (const auto attribute : {
+			 QNetworkRequest::HttpStatusCodeAttribute,
+			 QNetworkRequest::HttpReasonPhraseAttribute,
+			 QNetworkRequest::RedirectionTargetAttribute,
+			 QNetworkRequest::ConnectionEncryptedAttribute,
+			 QNetworkRequest::SourceIsFromCacheAttribute,
+			 QNetworkRequest::Http2WasUsedAttribute
+		 }) {
+		if (const auto value = source->attribute(attribute); value.isValid())
+			metaData.attributes.insert(attribute, value);
+	}
+	metaData.error = source->error();
+	metaData.errorString = source->errorString();
+	metaData.operation = source->operation();
+	return metaData;
+}
+
+void BufferedNetworkReply::setSource(QNetworkReply *source)
+{
+	_source = source;
+	setRequest(source->request());
+	setOperation(source->operation());
+}
+
+void BufferedNetworkReply::setAbortHandler(AbortHandler abortHandler)
+{
+	_abortHandler = std::move(abortHandler);
+}
+
+void BufferedNetworkReply::setMetaData(const MetaData &metaData, bool notify)
+{
+	setUrl(metaData.url);
+	for (const auto &header : metaData.headers)
+		setRawHeader(header.first, header.second);
+	for (auto it = metaData.attributes.constBegin(); it != metaData.attributes.constEnd(); ++it)
+		setAttribute(it.key(), it.value());
+	if (metaData.error != QNetworkReply::NoError)
+		setError(metaData.error, metaData.errorString);
+	if (metaData.operation != QNetworkAccessManager::UnknownOperation)
+		setOperation(metaData.operation);
+	if (notify)
+		emit metaDataChanged();
+}
+
+void BufferedNetworkReply::copyMetaData(const QNetworkReply *source)
+{
+	setMetaData(readMetaData(source));
+}
+
+void BufferedNetworkReply::setResponse(int statusCode, const QByteArray &reasonPhrase, const QList<RawHeaderPair> &headers)
+{
+	setAttribute(QNetworkRequest::HttpStatusCodeAttribute, statusCode);
+	setAttribute(QNetworkRequest::HttpReasonPhraseAttribute, reasonPhrase);
+	for (const auto &header : headers)
+		setRawHeader(header.first, header.second);
+}
+
+void BufferedNetworkReply::appendData(const QByteArray &data)
+{
+	if (isFinished() || _completing || data.isEmpty())
+		return;
+
+	if (_offset == _body.size()) {
+		_body = data;
+		_offset = 0;
+	} else {
+		if (_offset > _body.size() / 2) {
+			_body.remove(0, static_cast<int>(_offset));
+			_offset = 0;
+		}
+		_body.append(data);
+	}
+	emit readyRead();
+}
+
+void BufferedNetworkReply::finish(QByteArray body)
+{
+	if (isFinished() || _completing)
+		return;
+
+	_body = std::move(body);
+	_offset = 0;
+	finish();
+}
+
+void BufferedNetworkReply::finish()
+{
+	if (isFinished() || _completing)
+		return;
+
+	_completing = true;
+	// signals are delivered queued, so callers can connect to the reply after it was completed
+	QMetaObject::invokeMethod(this, &BufferedNetworkReply::emitFinished, Qt::QueuedConnection);
+}
+
+void BufferedNetworkReply::abort()
+{
+	// sources on other threads cannot be aborted directly, they provide a handler instead
+	if (_abortHandler)
+		std::exchange(_abortHandler, {})();
+	if (_source)
+		_source->abort();
+	if (isFinished())
+		return;
+
+	_body.clear();
+	_completing = true;
+	setError(QNetworkReply::OperationCanceledError, tr("Operation canceled"));
+	emitFinished();
+}
+
+qint64 BufferedNetworkReply::bytesAvailable() const
+{
+	return QNetworkReply::bytesAvailable() + (_body.size() - _offset);
+}
+
+bool BufferedNetworkReply::isSequential() const
+{
+	return true;
+}
+
+qint64 BufferedNetworkReply::readData(char *data, qint64 maxSize)
+{
+	const auto available = _body.size() - _offset;
+	if (available <= 0)
+		return isFinished() ? -1 : 0;
+
+	const auto size = std::min(available, maxSize);
+	std::memcpy(data, _body.constData() + _offset, static_cast<size_t>(size));
+	_offset += size;
+	return size;
+}
+
+void BufferedNetworkReply::emitFinished()
+{
+	if (isFinished())
+		return;
+
+	emit metaDataChanged();
+	if (error() != QNetworkReply::NoError)
+		emit errorOccurred(error());
+	if (_offset < _body.size()) {
+		emit downloadProgress(_body.size(), _body.size());
+		emit readyRead();
+	}
+	setFinished(true);
+	emit finished();
+}
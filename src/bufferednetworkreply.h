@@ -0,0 +1,64 @@
+#pragma once
+
+#include "qtrest_global.h"
+
+#include <functional>
+
+#include <QtCore/QPointer>
+
+#include <QtNetwork/QNetworkReply>
+#include <QtNetwork/QNetworkAccessManager>
+
+namespace QtRest::__private {
+
+class QTREST_EXPORT BufferedNetworkReply : public QNetworkReply
+{
+	Q_OBJECT
+
+public:
+	struct MetaData {
+		QUrl url;
+		QList<RawHeaderPair> headers;
+		AttributeMap attributes;
+		NetworkError error = NoError;
+		QString errorString;
+		// unknown keeps the operation of the reply
+		QNetworkAccessManager::Operation operation = QNetworkAccessManager::UnknownOperation;
+	};
+
+	using AbortHandler = std::function<void()>;
+
+	explicit BufferedNetworkReply(const QNetworkRequest &request, QObject *parent = nullptr);
+	BufferedNetworkReply(const QNetworkRequest &request, const QByteArray &verb, QObject *parent = nullptr);
+
+	static MetaData readMetaData(const QNetworkReply *source);
+
+	void setSource(QNetworkReply *source);
+	void setAbortHandler(AbortHandler abortHandler);
+	void setMetaData(const MetaData &metaData, bool notify = false);
+	void copyMetaData(const QNetworkReply *source);
+	void setResponse(int statusCode,
+					 const QByteArray &reasonPhrase,
+					 const QList<RawHeaderPair> &headers);
+	void appendData(const QByteArray &data);
+	void finish(QByteArray body);
+	void finish();
+
+	void abort() override;
+	qint64 bytesAvailable() const override;
+	bool isSequential() const override;
+
+protected:
+	qint64 readData(char *data, qint64 maxSize) override;
+
+private:
+	QPointer<QNetworkReply> _source;
+	AbortHandler _abortHandler;
+	QByteArray _body;
+	qint64 _offset = 0;
+	bool _completing = false;
+
+	void emitFinished();
+};
+
+}
@@ -1,96 +1,120 @@
-#pragma once
-
-#include "contenthandler.h"
-#include <qtjson.h>
-
-namespace QtRest {
-
-template <typename T>
-class CborContentHandler;
-
-template <>
-struct QTREST_EXPORT ContentHandlerArgs<CborContentHandler> {
-    static const QByteArray ContentType;
-
-    QtJson::Configuration config = {};
-    QCborValue::EncodingOptions options = QCborValue::NoTransformation;
-};
-
-template <typename T>
-class CborContentHandler : public IByteArrayContentHandler<T>
-{
-public:
-    using WriteResult = typename IByteArrayContentHandler<T>::WriteResult;
-
-    CborContentHandler(ContentHandlerArgs<CborContentHandler> args) :
-        _config{std::move(args)}
-    {}
-
-    QByteArrayList contentTypes() const override {
-        return {ContentHandlerArgs<CborContentHandler>::ContentType};
-    }
-
-    WriteResult write(const T &data) override {
-        return std::make_pair(QtJson::binarify(data, _config.config, _config.options),
-                              ContentHandlerArgs<CborContentHandler>::ContentType);
-    }
-
-    T read(const QByteArray &data, const QByteArray &contentType, QTextCodec *) override {
-        Q_UNUSED(contentType)
-        return QtJson::parseBinary<T>(data, _config.config);
-    }
-
-private:
-    ContentHandlerArgs<CborContentHandler> _config;
-};
-
-template <>
-class QTREST_EXPORT CborContentHandler<QCborValue> : public IByteArrayContentHandler<QCborValue>
-{
-public:
-    using WriteResult = typename IByteArrayContentHandler<QCborValue>::WriteResult;
-
-    CborContentHandler(ContentHandlerArgs<CborContentHandler> args);
-
-    QByteArrayList contentTypes() const override;
-    WriteResult write(const QCborValue &data) override;
-    QCborValue read(const QByteArray &data, const QByteArray &contentType, QTextCodec *) override;
-
-private:
-    QCborValue::EncodingOptions _options;
-};
-
-template <>
-class QTREST_EXPORT CborContentHandler<QCborMap> : public IByteArrayContentHandler<QCborMap>
-{
-public:
-    using WriteResult = typename IByteArrayContentHandler<QCborMap>::WriteResult;
-
-    CborContentHandler(ContentHandlerArgs<CborContentHandler> args);
-
-    QByteArrayList contentTypes() const override;
-    WriteResult write(const QCborMap &data) override;
-    QCborMap read(const QByteArray &data, const QByteArray &contentType, QTextCodec *) override;
-
-private:
-    QCborValue::EncodingOptions _options;
-};
-
-template <>
-class QTREST_EXPORT CborContentHandler<QCborArray> : public IByteArrayContentHandler<QCborArray>
-{
-public:
-    using WriteResult = typename IByteArrayContentHandler<QCborArray>::WriteResult;
-
-    CborContentHandler(ContentHandlerArgs<CborContentHandler> args);
-
-    QByteArrayList contentTypes() const override;
-    WriteResult write(const QCborArray &data) override;
-    QCborArray read(const QByteArray &data, const QByteArray &contentType, QTextCodec *) override;
-
-private:
-    QCborValue::EncodingOptions _options;
-};
-
-}
-
+#pragma once
+
+#include "contenthandler.h"
+#include "serializingdevice.h"
+#include <qtjson.h>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QCborStreamWriter>
+
+namespace QtRest {
+
+template <typename T>
+class CborContentHandler;
+
+template <>
+struct QTREST_EXPORT ContentHandlerArgs<CborContentHandler> {
+    static const QByteArray ContentType;
+
+    QtJson::Configuration config = {};
+    QCborValue::EncodingOptions options = QCborValue::NoTransformation;
+};
+
+template <typename T>
+class CborContentHandler : public IByteArrayContentHandler<T>
+{
+public:
+    static constexpr bool IsStreamingHandler = true;
+
+    using WriteResult = typename IByteArrayContentHandler<T>::WriteResult;
+
+    CborContentHandler(ContentHandlerArgs<CborContentHandler> args) :
+        _config{std::move(args)}
+    {}
+
+    QByteArrayList contentTypes() const override {
+        return {ContentHandlerArgs<CborContentHandler>::ContentType};
+    }
+
+    WriteResult write(const T &data) override {
+        return std::make_pair(QtJson::binarify(data, _config.config, _config.options),
+                              ContentHandlerArgs<CborContentHandler>::ContentType);
+    }
+
+    T read(const QByteArray &data, const QByteArray &contentType, QTextCodec *) override {
+        Q_UNUSED(contentType)
+        return QtJson::parseBinary<T>(data, _config.config);
+    }
+
+    template <typename TContainer>
+    std::pair<__private::SerializingDevice*, QByteArray> writeStream(TContainer data) {
+        static_assert(std::is_same_v<typename TContainer::value_type, T>, "TContainer must contain elements of type T");
+        const auto shared = QSharedPointer<const TContainer>::create(std::move(data));
+        return std::make_pair(new __private::SerializingDevice{[shared, config = _config]() -> __private::SerializingDevice::Generator {
+                                  return [shared, config, it = shared->cbegin(), started = false](QByteArray &out) mutable {
+                                      if (!started) {
+                                          QCborStreamWriter{&out}.startArray(static_cast<quint64>(shared->size()));
+                                          started = true;
+                                      }
+                                      if (it == shared->cend())
+                                          return false;
+                                      out.append(QtJson::binarify(*it, config.config, config.options));
+                                      return ++it != shared->cend();
+                                  };
+                              }},
+                              ContentHandlerArgs<CborContentHandler>::ContentType);
+    }
+
+private:
+    ContentHandlerArgs<CborContentHandler> _config;
+};
+
+template <>
+class QTREST_EXPORT CborContentHandler<QCborValue> : public IByteArrayContentHandler<QCborValue>
+{
+public:
+    using WriteResult = typename IByteArrayContentHandler<QCborValue>::WriteResult;
+
+    CborContentHandler(ContentHandlerArgs<CborContentHandler> args);
+
+    QByteArrayList contentTypes() const override;
+    WriteResult write(const QCborValue &data) override;
+    QCborValue read(const QByteArray &data, const QByteArray &contentType, QTextCodec *) override;
+
+private:
+    QCborValue::EncodingOptions _options;
+};
+
+template <>
+class QTREST_EXPORT CborContentHandler<QCborMap> : public IByteArrayContentHandler<QCborMap>
+{
+public:
+    using WriteResult = typename IByteArrayContentHandler<QCborMap>::WriteResult;
+
+    CborContentHandler(ContentHandlerArgs<CborContentHandler> args);
+
+    QByteArrayList contentTypes() const override;
+    WriteResult write(const QCborMap &data) override;
+    QCborMap read(const QByteArray &data, const QByteArray &contentType, QTextCodec *) override;
+
+private:
+    QCborValue::EncodingOptions _options;
+};
+
+template <>
+class QTREST_EXPORT CborContentHandler<QCborArray> : public IByteArrayContentHandler<QCborArray>
+{
+public:
+    using WriteResult = typename IByteArrayContentHandler<QCborArray>::WriteResult;
+
+    CborContentHandler(ContentHandlerArgs<CborContentHandler> args);
+
+    QByteArrayList contentTypes() const override;
+    WriteResult write(const QCborArray &data) override;
+    QCborArray read(const QByteArray &data, const QByteArray &contentType, QTextCodec *) override;
+
+private:
+    QCborValue::EncodingOptions _options;
+};
+
+}
+
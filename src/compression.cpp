@@ -0,0 +1,599 @@
+#include "compression.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#ifdef QT_REST_SYSTEM_ZLIB
+#include <zlib.h>
+#else
+#include <QtZlib/zlib.h>
+#endif
+#ifdef QT_REST_USE_BROTLI
+#include <brotli/encode.h>
+#include <brotli/decode.h>
+#endif
+#ifdef QT_REST_USE_ZSTD
+#include <zstd.h>
+#endif
+using namespace QtRest;
+using namespace QtRest::__private;
+
+namespace {
+
+constexpr auto ChunkSize = 16 * 1024;
+
+class ZlibCodec : public Codec
+{
+public:
+	ZlibCodec(bool encode, Compression::Encoding encoding, int level) :
+		_encode{encode}
+	{
+		std::memset(&_stream, 0, sizeof(_stream));
+		int result;
+		if (_encode) {
+			result = deflateInit2(&_stream,
+								  level < 0 ? Z_DEFAULT_COMPRESSION : level,
+								  Z_DEFLATED,
+								  encoding == Compression::Encoding::Gzip ? MAX_WBITS + 16 : MAX_WBITS,
+								  8,
+								  Z_DEFAULT_STRATEGY);
+		} else
+			result = inflateInit2(&_stream, MAX_WBITS + 32);  // detects gzip and zlib headers
+		_initialized = result == Z_OK;
+		if (!_initialized)
+			_errorString = QString::fromUtf8(_stream.msg ? _stream.msg : "Failed to initialize zlib stream");
+	}
+
+	~ZlibCodec() override {
+		if (!_initialized)
+			return;
+		else if (_encode)
+			deflateEnd(&_stream);
+		else
+			inflateEnd(&_stream);
+	}
+
+	bool process(const char *data, qint64 size, QByteArray &out) override {
+		return run(data, size, out, Z_NO_FLUSH);
+	}
+
+	bool finish(QByteArray &out) override {
+		if (!_initialized)
+			return false;
+		else if (_encode)
+			return run(nullptr, 0, out, Z_FINISH);
+		else if (!_ended) {
+			_errorString = QStringLiteral("Compressed stream ended prematurely");
+			return false;
+		} else
+			return true;
+	}
+
+private:
+	z_stream _stream;
+	bool _encode;
+	bool _initialized = false;
+	bool _ended = false;
+
+	bool run(const char *data, qint64 size, QByteArray &out, int flush) {
+		if (!_initialized)
+			return false;
+		else if (_ended)
+			return true;
+
+		std::array<char, ChunkSize> buffer;
+		_stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+		_stream.avail_in = static_cast<uInt>(size);
+		do {
+			_stream.next_out = reinterpret_cast<Bytef*>(buffer.data());
+			_stream.avail_out = static_cast<uInt>(buffer.size());
+			const auto result = _encode ? deflate(&_stream, flush) : inflate(&_stream, Z_NO_FLUSH);
+			if (result == Z_STREAM_ERROR || result == Z_DATA_ERROR || result == Z_MEM_ERROR || result == Z_NEED_DICT) {
+				_errorString = QString::fromUtf8(_stream.msg ? _stream.msg : "zlib stream error");
+				return false;
+			}
+			out.append(buffer.data(), static_cast<int>(buffer.size() - _stream.avail_out));
+			if (result == Z_STREAM_END) {
+				_ended = true;
+				break;
+			}
+		} while (_stream.avail_out == 0);
+		return true;
+	}
+};
+
+#ifdef QT_REST_USE_BROTLI
+class BrotliEncoder : public Codec
+{
+public:
+	BrotliEncoder(int level) :
+		_state{BrotliEncoderCreateInstance(nullptr, nullptr, nullptr)}
+	{
+		if (!_state)
+			_errorString = QStringLiteral("Failed to create brotli encoder");
+		else if (level >= 0)
+			BrotliEncoderSetParameter(_state, BROTLI_PARAM_QUALITY, static_cast<uint32_t>(level));
+	}
+
+	~BrotliEncoder() override {
+		if (_state)
+			BrotliEncoderDestroyInstance(_state);
+	}
+
+	bool process(const char *data, qint64 size, QByteArray &out) override {
+		return _state && run(BROTLI_OPERATION_PROCESS, data, size, out);
+	}
+
+	bool finish(QByteArray &out) override {
+		return _state && run(BROTLI_OPERATION_FINISH, nullptr, 0, out);
+	}
+
+private:
+	BrotliEncoderState *_state;
+
+	bool run(BrotliEncoderOperation operation, const char *data, qint64 size, QByteArray &out) {
+		std::array<uint8_t, ChunkSize> buffer;
+		auto availableIn = static_cast<size_t>(size);
+		auto nextIn = reinterpret_cast<const uint8_t*>(data);
+		do {
+			auto availableOut = buffer.size();
+			auto nextOut = buffer.data();
+			if (!BrotliEncoderCompressStream(_state, operation, &availableIn, &nextIn, &availableOut, &nextOut, nullptr)) {
+				_errorString = QStringLiteral("Brotli encoder error");
+				return false;
+			}
+			out.append(reinterpret_cast<const char*>(buffer.data()), static_cast<int>(buffer.size() - availableOut));
+		} while (availableIn > 0 ||
+				 BrotliEncoderHasMoreOutput(_state) ||
+				 (operation == BROTLI_OPERATION_FINISH && !BrotliEncoderIsFinished(_state)));
+		return true;
+	}
+};
+
+class BrotliDecoder : public Codec
+{
+public:
+	BrotliDecoder() :
+		_state{BrotliDecoderCreateInstance(nullptr, nullptr, nullptr)}
+	{
+		if (!_state)
+			_errorString = QStringLiteral("Failed to create brotli decoder");
+	}
+
+	~BrotliDecoder() override {
+		if (_state)
+			BrotliDecoderDestroyInstance(_state);
+	}
+
+	bool process(const char *data, qint64 size, QByteArray &out) override {
+		if (!_state)
+			return false;
+		std::array<uint8_t, ChunkSize> buffer;
+		auto availableIn = static_cast<size_t>(size);
+		auto nextIn = reinterpret_cast<const uint8_t*>(data);
+		BrotliDecoderResult result;
+		do {
+			auto availableOut = buffer.size();
+			auto nextOut = buffer.data();
+			result = BrotliDecoderDecompressStream(_state, &availableIn, &nextIn, &availableOut, &nextOut, nullptr);
+			if (result == BROTLI_DECODER_RESULT_ERROR) {
+				_errorString = QString::fromUtf8(BrotliDecoderErrorString(BrotliDecoderGetErrorCode(_state)));
+				return false;
+			}
+			out.append(reinterpret_cast<const char*>(buffer.data()), static_cast<int>(buffer.size() - availableOut));
+		} while (result == BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT);
+		return true;
+	}
+
+	bool finish(QByteArray &) override {
+		if (_state && BrotliDecoderIsFinished(_state))
+			return true;
+		_errorString = QStringLiteral("Compressed stream ended prematurely");
+		return false;
+	}
+
+private:
+	BrotliDecoderState *_state;
+};
+#endif
+
+#ifdef QT_REST_USE_ZSTD
+class ZstdEncoder : public Codec
+{
+public:
+	ZstdEncoder(int level) :
+		_context{ZSTD_createCCtx()}
+	{
+		if (!_context)
+			_errorString = QStringLiteral("Failed to create zstd encoder");
+		else if (level >= 0)
+			ZSTD_CCtx_setParameter(_context, ZSTD_c_compressionLevel, level);
+	}
+
+	~ZstdEncoder() override {
+		ZSTD_freeCCtx(_context);
+	}
+
+	bool process(const char *data, qint64 size, QByteArray &out) override {
+		return _context && run(ZSTD_e_continue, data, size, out);
+	}
+
+	bool finish(QByteArray &out) override {
+		return _context && run(ZSTD_e_end, nullptr, 0, out);
+	}
+
+private:
+	ZSTD_CCtx *_context;
+
+	bool run(ZSTD_EndDirective directive, const char *data, qint64 size, QByteArray &out) {
+		std::array<char, ChunkSize> buffer;
+		ZSTD_inBuffer input {data, static_cast<size_t>(size), 0};
+		size_t remaining;
+		do {
+			ZSTD_outBuffer output {buffer.data(), buffer.size(), 0};
+			remaining = ZSTD_compressStream2(_context, &output, &input, directive);
+			if (ZSTD_isError(remaining)) {
+				_errorString = QString::fromUtf8(ZSTD_getErrorName(remaining));
+				return false;
+			}
+			out.append(buffer.data(), static_cast<int>(output.pos));
+		} while (directive == ZSTD_e_end ? remaining != 0 : input.pos < input.size);
+		return true;
+	}
+};
+
+class ZstdDecoder : public Codec
+{
+public:
+	ZstdDecoder() :
+		_context{ZSTD_createDCtx()}
+	{
+		if (!_context)
+			_errorString = QStringLiteral("Failed to create zstd decoder");
+	}
+
+	~ZstdDecoder() override {
+		ZSTD_freeDCtx(_context);
+	}
+
+	bool process(const char *data, qint64 size, QByteArray &out) override {
+		if (!_context)
+			return false;
+		std::array<char, ChunkSize> buffer;
+		ZSTD_inBuffer input {data, static_cast<size_t>(size), 0};
+		ZSTD_outBuffer output {buffer.data(), buffer.size(), 0};
+		do {
+			output.pos = 0;
+			_pending = ZSTD_decompressStream(_context, &output, &input);
+			if (ZSTD_isError(_pending)) {
+				_errorString = QString::fromUtf8(ZSTD_getErrorName(_pending));
+				return false;
+			}
+			out.append(buffer.data(), static_cast<int>(output.pos));
+		} while (input.pos < input.size || output.pos == output.size);
+		return true;
+	}
+
+	bool finish(QByteArray &) override {
+		if (_context && _pending == 0)
+			return true;
+		_errorString = QStringLiteral("Compressed stream ended prematurely");
+		return false;
+	}
+
+private:
+	ZSTD_DCtx *_context;
+	size_t _pending = 0;
+};
+#endif
+
+}
+
+
+
+QList<Compression::Encoding> Compression::supportedEncodings()
+{
+	return {
+#ifdef QT_REST_USE_ZSTD
+		Encoding::Zstd,
+#endif
+#ifdef QT_REST_USE_BROTLI
+		Encoding::Brotli,
+#endif
+		Encoding::Gzip,
+		Encoding::Deflate
+	};
+}
+
+QByteArray Compression::encodingName(Encoding encoding)
+{
+	switch (encoding) {
+	case Encoding::Identity:
+		return QByteArrayLiteral("identity");
+	case Encoding::Gzip:
+		return QByteArrayLiteral("gzip");
+	case Encoding::Deflate:
+		return QByteArrayLiteral("deflate");
+	case Encoding::Brotli:
+		return QByteArrayLiteral("br");
+	case Encoding::Zstd:
+		return QByteArrayLiteral("zstd");
+	default:
+		Q_UNREACHABLE();
+	}
+}
+
+std::optional<Compression::Encoding> Compression::encodingFromName(const QByteArray &name)
+{
+	const auto encoding = name.trimmed().toLower();
+	if (encoding.isEmpty() || encoding == "identity")
+		return Encoding::Identity;
+	else if (encoding == "gzip" || encoding == "x-gzip")
+		return Encoding::Gzip;
+	else if (encoding == "deflate")
+		return Encoding::Deflate;
+#ifdef QT_REST_USE_BROTLI
+	else if (encoding == "br")
+		return Encoding::Brotli;
+#endif
+#ifdef QT_REST_USE_ZSTD
+	else if (encoding == "zstd")
+		return Encoding::Zstd;
+#endif
+	else
+		return std::nullopt;
+}
+
+QByteArray Compression::acceptEncoding()
+{
+	static const auto header = []() {
+		QByteArrayList names;
+		for (const auto encoding : supportedEncodings())
+			names.append(encodingName(encoding));
+		return names.join(", ");
+	}();
+	return header;
+}
+
+
+
+Codec::~Codec() = default;
+
+std::unique_ptr<Codec> Codec::createEncoder(Compression::Encoding encoding, int level)
+{
+	switch (encoding) {
+	case Compression::Encoding::Gzip:
+	case Compression::Encoding::Deflate:
+		return std::make_unique<ZlibCodec>(true, encoding, level);
+#ifdef QT_REST_USE_BROTLI
+	case Compression::Encoding::Brotli:
+		return std::make_unique<BrotliEncoder>(level);
+#endif
+#ifdef QT_REST_USE_ZSTD
+	case Compression::Encoding::Zstd:
+		return std::make_unique<ZstdEncoder>(level);
+#endif
+	default:
+		return nullptr;
+	}
+}
+
+std::unique_ptr<Codec> Codec::createDecoder(Compression::Encoding encoding)
+{
+	switch (encoding) {
+	case Compression::Encoding::Gzip:
+	case Compression::Encoding::Deflate:
+		return std::make_unique<ZlibCodec>(false, encoding, -1);
+#ifdef QT_REST_USE_BROTLI
+	case Compression::Encoding::Brotli:
+		return std::make_unique<BrotliDecoder>();
+#endif
+#ifdef QT_REST_USE_ZSTD
+	case Compression::Encoding::Zstd:
+		return std::make_unique<ZstdDecoder>();
+#endif
+	default:
+		return nullptr;
+	}
+}
+
+QString Codec::errorString() const
+{
+	return _errorString;
+}
+
+bool Codec::hasError() const
+{
+	return !_errorString.isNull();
+}
+
+
+
+EncodingDevice::EncodingDevice(QIODevice *source, std::unique_ptr<Codec> codec, QObject *parent) :
+	QIODevice{parent},
+	_source{source},
+	_codec{std::move(codec)}
+{
+	if (!_source->parent())
+		_source->setParent(this);
+	connect(_source, &QIODevice::readyRead,
+			this, &QIODevice::readyRead);
+	// the encoder still holds the tail of the stream, so readers get another chance to read before the end
+	connect(_source, &QIODevice::readChannelFinished,
+			this, [this]() {
+				emit readyRead();
+				emit readChannelFinished();
+			});
+	open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+bool EncodingDevice::isSequential() const
+{
+	return true;
+}
+
+bool EncodingDevice::atEnd() const
+{
+	return _finished && _buffer.isEmpty();
+}
+
+qint64 EncodingDevice::bytesAvailable() const
+{
+	return _buffer.size() + QIODevice::bytesAvailable();
+}
+
+qint64 EncodingDevice::readData(char *data, qint64 maxSize)
+{
+	fill(maxSize);
+	if (_buffer.isEmpty())
+		return _finished ? -1 : 0;
+
+	const auto size = std::min<qint64>(maxSize, _buffer.size());
+	std::memcpy(data, _buffer.constData(), static_cast<size_t>(size));
+	_buffer.remove(0, static_cast<int>(size));
+	return size;
+}
+
+qint64 EncodingDevice::writeData(const char *, qint64)
+{
+	return -1;
+}
+
+void EncodingDevice::fill(qint64 size)
+{
+	std::array<char, ChunkSize> chunk;
+	while (!_finished && _buffer.size() < size) {
+		const auto read = _source->read(chunk.data(), chunk.size());
+		if (read > 0) {
+			if (!_codec->process(chunk.data(), read, _buffer)) {
+				setErrorString(_codec->errorString());
+				_finished = true;
+			}
+		} else if (read < 0 || (!_source->isSequential() && _source->atEnd())) {
+			if (!_codec->finish(_buffer))
+				setErrorString(_codec->errorString());
+			_finished = true;
+		} else
+			break;  // a sequential source has no data right now
+	}
+}
+
+
+
+QNetworkReply *ContentDecoder::wrap(QNetworkReply *source)
+{
+	const auto target = new BufferedNetworkReply{source->request()};
+	target->setSource(source);
+	source->setParent(target);
+	new ContentDecoder{source, target};
+	return target;
+}
+
+ContentDecoder::ContentDecoder(QNetworkReply *source, BufferedNetworkReply *target) :
+	QObject{target},
+	_source{source},
+	_target{target}
+{
+	connect(_source, &QNetworkReply::metaDataChanged,
+			this, &ContentDecoder::readMetaData);
+	connect(_source, &QNetworkReply::readyRead,
+			this, &ContentDecoder::readData);
+	connect(_source, &QNetworkReply::finished,
+			this, &ContentDecoder::sourceFinished);
+	connect(_source, &QNetworkReply::uploadProgress,
+			_target, &QNetworkReply::uploadProgress);
+}
+
+BufferedNetworkReply::MetaData ContentDecoder::decodedMetaData() const
+{
+	auto metaData = BufferedNetworkReply::readMetaData(_source);
+	if (_codec) {
+		// the decoded body has neither the original encoding nor its length
+		metaData.headers.erase(std::remove_if(metaData.headers.begin(), metaData.headers.end(), [](const QNetworkReply::RawHeaderPair &header) {
+			return header.first.compare("Content-Encoding", Qt::CaseInsensitive) == 0 ||
+				   header.first.compare("Content-Length", Qt::CaseInsensitive) == 0;
+		}), metaData.headers.end());
+	}
+	if (!_errorString.isNull()) {
+		metaData.error = QNetworkReply::UnknownContentError;
+		metaData.errorString = _errorString;
+	}
+	return metaData;
+}
+
+void ContentDecoder::readMetaData()
+{
+	if (!_hasMetaData) {
+		_hasMetaData = true;
+		if (const auto encoding = Compression::encodingFromName(_source->rawHeader("Content-Encoding")); encoding)
+			_codec = Codec::createDecoder(*encoding);
+		// a decoder that cannot start fails the reply instead of passing the encoded body on
+		if (_codec && _codec->hasError())
+			_errorString = _codec->errorString();
+	}
+	_target->setMetaData(decodedMetaData(), true);
+}
+
+void ContentDecoder::readData()
+{
+	if (!_hasMetaData)
+		readMetaData();
+
+	const auto data = _source->readAll();
+	if (!_codec || !_errorString.isNull()) {
+		_target->appendData(data);
+		return;
+	}
+
+	QByteArray decoded;
+	if (!_codec->process(data.constData(), data.size(), decoded))
+		_errorString = _codec->errorString();
+	_target->appendData(decoded);
+}
+
+void ContentDecoder::sourceFinished()
+{
+	readData();
+	if (_codec && _errorString.isNull()) {
+		QByteArray decoded;
+		if (!_codec->finish(decoded) && _source->error() == QNetworkReply::NoError)
+			_errorString = _codec->errorString();
+		_target->appendData(decoded);
+	}
+	_target->setMetaData(decodedMetaData());
+	_target->finish();
+}
+
+
+
+void QtRest::__private::encodeBody(const Compression &compression, QNetworkRequest &request, std::variant<QByteArray, QIODevice*, QUrlQuery> &body)
+{
+	if (compression.decodeResponses && !request.hasRawHeader("Accept-Encoding"))
+		request.setRawHeader("Accept-Encoding", Compression::acceptEncoding());
+	if (compression.requestEncoding == Compression::Encoding::Identity ||
+		request.hasRawHeader("Content-Encoding"))
+		return;
+
+	if (std::holds_alternative<QByteArray>(body)) {
+		const auto &data = std::get<QByteArray>(body);
+		if (data.size() < compression.threshold)
+			return;
+		const auto codec = Codec::createEncoder(compression.requestEncoding, compression.level);
+		if (!codec || codec->hasError())
+			return;
+		QByteArray encoded;
+		if (!codec->process(data.constData(), data.size(), encoded) || !codec->finish(encoded))
+			return;
+		body = std::move(encoded);
+		request.setRawHeader("Content-Encoding", Compression::encodingName(compression.requestEncoding));
+	} else if (std::holds_alternative<QIODevice*>(body) && compression.compressDevices) {
+		const auto device = std::get<QIODevice*>(body);
+		if (!device->isSequential() && device->size() < compression.threshold)
+			return;
+		auto codec = Codec::createEncoder(compression.requestEncoding, compression.level);
+		if (!codec || codec->hasError())
+			return;
+		body = new EncodingDevice{device, std::move(codec)};
+		request.setHeader(QNetworkRequest::ContentLengthHeader, QVariant{});
+		request.setRawHeader("Content-Encoding", Compression::encodingName(compression.requestEncoding));
+	}
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "qtrest_global.h"
+#include "bufferednetworkreply.h"
+
+#include <memory>
+#include <optional>
+#include <variant>
+
+#include <QtCore/QObject>
+#include <QtCore/QIODevice>
+#include <QtCore/QUrlQuery>
+
+#include <QtNetwork/QNetworkReply>
+
+namespace QtRest {
+
+struct QTREST_EXPORT Compression
+{
+	enum class Encoding {
+		Identity,
+		Gzip,
+		Deflate,
+		Brotli,
+		Zstd
+	};
+
+	// request bodies are only compressed on request, not every server accepts encoded uploads
+	Encoding requestEncoding = Encoding::Identity;
+	qint64 threshold = 1024;
+	int level = -1;
+	bool compressDevices = false;
+	bool decodeResponses = true;
+
+	static QList<Encoding> supportedEncodings();
+	static QByteArray encodingName(Encoding encoding);
+	static std::optional<Encoding> encodingFromName(const QByteArray &name);
+	static QByteArray acceptEncoding();
+};
+
+namespace __private {
+
+class QTREST_EXPORT Codec
+{
+	Q_DISABLE_COPY(Codec)
+
+public:
+	Codec() = default;
+	virtual ~Codec();
+
+	static std::unique_ptr<Codec> createEncoder(Compression::Encoding encoding, int level = -1);
+	static std::unique_ptr<Codec> createDecoder(Compression::Encoding encoding);
+
+	virtual bool process(const char *data, qint64 size, QByteArray &out) = 0;
+	virtual bool finish(QByteArray &out) = 0;
+
+	QString errorString() const;
+	// set when the codec could not be initialized or failed on its input
+	bool hasError() const;
+
+protected:
+	QString _errorString;
+};
+
+class QTREST_EXPORT EncodingDevice : public QIODevice
+{
+	Q_OBJECT
+
+public:
+	EncodingDevice(QIODevice *source, std::unique_ptr<Codec> codec, QObject *parent = nullptr);
+
+	bool isSequential() const override;
+	bool atEnd() const override;
+	qint64 bytesAvailable() const override;
+
+protected:
+	qint64 readData(char *data, qint64 maxSize) override;
+	qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+	QIODevice *_source;
+	std::unique_ptr<Codec> _codec;
+	QByteArray _buffer;
+	bool _finished = false;
+
+	void fill(qint64 size);
+};
+
+class QTREST_EXPORT ContentDecoder : public QObject
+{
+	Q_OBJECT
+
+public:
+	static QNetworkReply *wrap(QNetworkReply *source);
+
+private:
+	QNetworkReply *_source;
+	BufferedNetworkReply *_target;
+	std::unique_ptr<Codec> _codec;
+	bool _hasMetaData = false;
+	QString _errorString;
+
+	ContentDecoder(QNetworkReply *source, BufferedNetworkReply *target);
+
+	BufferedNetworkReply::MetaData decodedMetaData() const;
+	void readMetaData();
+	void readData();
+	void sourceFinished();
+};
+
+void QTREST_EXPORT encodeBody(const Compression &compression,
+							  QNetworkRequest &request,
+							  std::variant<QByteArray, QIODevice*, QUrlQuery> &body);
+
+}
+
+}
@@ -0,0 +1,108 @@
+#include "deliveryqueue.h"
+#ifdef QT_REST_USE_ASYNC
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+using namespace QtRest::__private;
+
+namespace {
+
+QMutex registryMutex;
+QHash<QThread*, QWeakPointer<DeliveryQueue>> registry;
+
+}
+
+DeliveryQueue::DeliveryQueue() :
+	_head{&_stub},
+	_tail{&_stub}
+{}
+
+DeliveryQueue::~DeliveryQueue()
+{
+	while (const auto node = pop())
+		delete node;
+}
+
+QSharedPointer<DeliveryQueue> DeliveryQueue::forThread(QThread *thread)
+{
+	QMutexLocker lock{&registryMutex};
+	if (auto queue = registry.value(thread).toStrongRef(); queue)
+		return queue;
+
+	QSharedPointer<DeliveryQueue> queue{new DeliveryQueue{}, [](DeliveryQueue *queue) {
+		// deferred deletes are never processed once the event loop of the thread has exited
+		if (const auto thread = queue->thread(); !thread || thread->isFinished())
+			delete queue;
+		else
+			queue->deleteLater();
+	}};
+	queue->moveToThread(thread);
+	registry.insert(thread, queue);
+	// the connection is bound to the queue, so every queue only cleans up after itself
+	QObject::connect(thread, &QThread::finished,
+					 queue.data(), [thread]() {
+						 QMutexLocker lock{&registryMutex};
+						 registry.remove(thread);
+					 }, Qt::DirectConnection);
+	return queue;
+}
+
+void DeliveryQueue::post(QPointer<QObject> target, Task task)
+{
+	push(new Node{nullptr, std::move(target), std::move(task)});
+	// only the first item after a drain wakes the target thread, later ones are batched into the same drain
+	if (_scheduled.testAndSetOrdered(0, 1))
+		QMetaObject::invokeMethod(this, &DeliveryQueue::drain, Qt::QueuedConnection);
+}
+
+void DeliveryQueue::push(Node *node)
+{
+	node->next.storeRelaxed(nullptr);
+	const auto previous = _head.fetchAndStoreAcquireRelease(node);
+	previous->next.storeRelease(node);
+}
+
+DeliveryQueue::Node *DeliveryQueue::pop()
+{
+	auto tail = _tail;
+	auto next = tail->next.loadAcquire();
+	if (tail == &_stub) {
+		if (!next)
+			return nullptr;
+		_tail = next;
+		tail = next;
+		next = next->next.loadAcquire();
+	}
+
+	if (next) {
+		_tail = next;
+		return tail;
+	}
+
+	// a producer is between swapping the head and linking its node, the next drain picks it up
+	if (tail != _head.loadAcquire())
+		return nullptr;
+
+	push(&_stub);
+	next = tail->next.loadAcquire();
+	if (next) {
+		_tail = next;
+		return tail;
+	}
+	return nullptr;
+}
+
+void DeliveryQueue::drain()
+{
+	_scheduled.storeRelease(0);
+	while (const auto node = pop()) {
+		if (const auto target = node->target; target) {
+			// the target was moved after the item was posted, so it is passed on to its new thread
+			if (target->thread() != thread())
+				forThread(target->thread())->post(std::move(node->target), std::move(node->task));
+			else
+				node->task();
+		}
+		delete node;
+	}
+}
+#endif
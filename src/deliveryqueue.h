@@ -0,0 +1,51 @@
+#pragma once
+
+#include "qtrest_global.h"
+
+#ifdef QT_REST_USE_ASYNC
+#include <functional>
+
+#include <QtCore/QObject>
+#include <QtCore/QPointer>
+#include <QtCore/QAtomicInteger>
+#include <QtCore/QAtomicPointer>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QThread>
+
+namespace QtRest::__private {
+
+class QTREST_EXPORT DeliveryQueue : public QObject
+{
+	Q_OBJECT
+
+public:
+	using Task = std::function<void()>;
+
+	~DeliveryQueue() override;
+
+	static QSharedPointer<DeliveryQueue> forThread(QThread *thread);
+
+	// the target is passed as a guard, so posting threads never create one for an object they do not own
+	void post(QPointer<QObject> target, Task task);
+
+private:
+	struct Node {
+		QAtomicPointer<Node> next;
+		QPointer<QObject> target;
+		Task task;
+	};
+
+	QAtomicPointer<Node> _head;
+	Node *_tail;
+	Node _stub;
+	QAtomicInt _scheduled = 0;
+
+	DeliveryQueue();
+
+	void push(Node *node);
+	Node *pop();
+	void drain();
+};
+
+}
+#endif
@@ -0,0 +1,299 @@
+#include "eventsource.h"
+#include <cstring>
+using namespace QtRest;
+using namespace std::chrono;
+
+EventStreamParser::EventStreamParser(Handler handler) :
+	_handler{std::move(handler)}
+{}
+
+void EventStreamParser::addData(const QByteArray &data)
+{
+	const auto chunk = data.constData();
+	const auto size = data.size();
+	const auto generation = _generation;
+	qsizetype pos = 0;
+	// a CR at the end of the previous chunk may be the first half of a CRLF
+	if (_skipLf && size > 0) {
+		if (chunk[0] == '\n')
+			pos = 1;
+		_skipLf = false;
+	}
+
+	while (pos < size) {
+		auto end = pos;
+		while (end < size && chunk[end] != '\n' && chunk[end] != '\r')
+			++end;
+		if (end == size)
+			break;
+
+		// only the new chunk is scanned, a partial line is carried over until its terminator arrives
+		if (_partial.isEmpty())
+			processLine(chunk + pos, end - pos);
+		else {
+			_partial.append(chunk + pos, static_cast<int>(end - pos));
+			const auto line = std::exchange(_partial, {});
+			processLine(line.constData(), line.size());
+		}
+		// the rest of the chunk belongs to a connection that was closed or reopened by the handler
+		if (_generation != generation)
+			return;
+
+		if (chunk[end] == '\r') {
+			if (end + 1 == size)
+				_skipLf = true;
+			else if (chunk[end + 1] == '\n')
+				++end;
+		}
+		pos = end + 1;
+	}
+	if (pos < size)
+		_partial.append(chunk + pos, static_cast<int>(size - pos));
+}
+
+void EventStreamParser::reset()
+{
+	// the last event id survives reconnects, everything else belongs to the old connection
+	_partial.clear();
+	_event = {};
+	_hasData = false;
+	_atStart = true;
+	_skipLf = false;
+	++_generation;
+}
+
+QByteArray EventStreamParser::lastEventId() const
+{
+	return _lastEventId;
+}
+
+std::optional<milliseconds> EventStreamParser::retry() const
+{
+	return _retry;
+}
+
+void EventStreamParser::processLine(const char *line, qsizetype size)
+{
+	if (_atStart) {
+		_atStart = false;
+		if (size >= 3 && std::memcmp(line, "\xEF\xBB\xBF", 3) == 0) {
+			line += 3;
+			size -= 3;
+		}
+	}
+
+	if (size == 0) {
+		dispatch();
+		return;
+	} else if (line[0] == ':')
+		return;
+
+	const auto colon = static_cast<const char*>(std::memchr(line, ':', static_cast<size_t>(size)));
+	const auto field = QByteArray::fromRawData(line, static_cast<int>(colon ? colon - line : size));
+	auto valueBegin = colon ? colon + 1 : line + size;
+	if (valueBegin < line + size && *valueBegin == ' ')
+		++valueBegin;
+	const auto valueSize = static_cast<int>(line + size - valueBegin);
+
+	if (field == "data") {
+		if (_hasData)
+			_event.data.append('\n');
+		_event.data.append(valueBegin, valueSize);
+		_hasData = true;
+	} else if (field == "event")
+		_event.event = QByteArray{valueBegin, valueSize};
+	else if (field == "id") {
+		if (!std::memchr(valueBegin, '\0', static_cast<size_t>(valueSize)))
+			_lastEventId = QByteArray{valueBegin, valueSize};
+	} else if (field == "retry") {
+		auto ok = false;
+		const auto retry = QByteArray::fromRawData(valueBegin, valueSize).toLongLong(&ok);
+		if (ok && retry >= 0)
+			_retry = milliseconds{retry};
+	}
+}
+
+void EventStreamParser::dispatch()
+{
+	// events without data, including a bare "data" line, only reset the buffers
+	_hasData = false;
+	if (_event.data.isEmpty()) {
+		_event = {};
+		return;
+	}
+
+	_event.id = _lastEventId;
+	if (_event.event.isEmpty())
+		_event.event = QByteArrayLiteral("message");
+	_handler(std::exchange(_event, {}));
+}
+
+
+
+const QByteArray EventSource::ContentType = "text/event-stream";
+
+EventSource::EventSource(Launcher launcher, QObject *parent) :
+	QObject{parent},
+	_launcher{std::move(launcher)},
+	_parser{[this](const ServerSentEvent &event) {
+		emit eventReceived(event);
+	}},
+	_reconnectTimer{new QTimer{this}}
+{
+	_reconnectTimer->setSingleShot(true);
+	connect(_reconnectTimer, &QTimer::timeout,
+			this, &EventSource::open);
+}
+
+EventSource::~EventSource()
+{
+	disconnectReply();
+}
+
+EventSource::ReadyState EventSource::readyState() const
+{
+	return _readyState;
+}
+
+QByteArray EventSource::lastEventId() const
+{
+	return _parser.lastEventId();
+}
+
+milliseconds EventSource::retryInterval() const
+{
+	return _parser.retry().value_or(_retryInterval);
+}
+
+int EventSource::maxReconnectAttempts() const
+{
+	return _maxReconnectAttempts;
+}
+
+void EventSource::setRetryInterval(milliseconds retryInterval)
+{
+	_retryInterval = retryInterval;
+}
+
+void EventSource::setMaxReconnectAttempts(int maxReconnectAttempts)
+{
+	_maxReconnectAttempts = maxReconnectAttempts;
+}
+
+void EventSource::open()
+{
+	_reconnectTimer->stop();
+	disconnectReply();
+	_parser.reset();
+	_accepted.reset();
+	setReadyState(ReadyState::Connecting);
+
+	HeaderMap headers;
+	headers.insert("Accept", ContentType);
+	headers.insert("Cache-Control", "no-cache");
+	if (const auto lastEventId = _parser.lastEventId(); !lastEventId.isEmpty())
+		headers.insert("Last-Event-ID", lastEventId);
+
+	_reply = _launcher(headers);
+	_reply->setParent(this);
+	connect(_reply, &QNetworkReply::metaDataChanged,
+			this, &EventSource::readMetaData);
+	connect(_reply, &QNetworkReply::readyRead,
+			this, &EventSource::readData);
+	connect(_reply, &QNetworkReply::finished,
+			this, &EventSource::replyFinished);
+}
+
+void EventSource::close()
+{
+	_reconnectTimer->stop();
+	disconnectReply();
+	// stops delivering the events that were already received with the current chunk
+	_parser.reset();
+	setReadyState(ReadyState::Closed);
+}
+
+void EventSource::readMetaData()
+{
+	if (_accepted)
+		return;
+
+	const auto status = _reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+	if (status == 0)
+		return;
+	const auto contentType = _reply->header(QNetworkRequest::ContentTypeHeader).toByteArray();
+	_accepted = status == 200 && contentType.split(';').first().trimmed() == ContentType;
+	if (*_accepted) {
+		_attempt = 0;
+		setReadyState(ReadyState::Open);
+		emit opened();
+	}
+}
+
+void EventSource::readData()
+{
+	// the stream may be closed from within an event handler
+	if (!_reply)
+		return;
+	if (!_accepted)
+		readMetaData();
+	if (!_accepted.value_or(false))
+		return;
+
+	if (const auto available = _reply->bytesAvailable(); available > 0)
+		_parser.addData(_reply->read(available));
+}
+
+void EventSource::replyFinished()
+{
+	readData();
+	if (!_reply)
+		return;
+	const auto reply = _reply.data();
+	_reply.clear();
+	reply->deleteLater();
+
+	const auto status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+	if (_accepted && !*_accepted) {
+		// a rejected stream is not retried, a 204 is the server asking to stop
+		setReadyState(ReadyState::Closed);
+		if (status != 204) {
+			emit errorOccurred(reply->error() != QNetworkReply::NoError ? reply->error() : QNetworkReply::ProtocolInvalidOperationError,
+							   reply->error() != QNetworkReply::NoError ?
+								   reply->errorString() :
+								   tr("Server did not respond with an event stream (status %1)").arg(status));
+		}
+		return;
+	}
+
+	if (reply->error() != QNetworkReply::NoError)
+		emit errorOccurred(reply->error(), reply->errorString());
+	if (_maxReconnectAttempts >= 0 && _attempt >= _maxReconnectAttempts) {
+		setReadyState(ReadyState::Closed);
+		return;
+	}
+
+	++_attempt;
+	setReadyState(ReadyState::Connecting);
+	_reconnectTimer->start(retryInterval());
+}
+
+void EventSource::setReadyState(ReadyState readyState)
+{
+	if (_readyState == readyState)
+		return;
+	_readyState = readyState;
+	emit readyStateChanged(_readyState);
+}
+
+void EventSource::disconnectReply()
+{
+	if (!_reply)
+		return;
+
+	const auto reply = _reply.data();
+	_reply.clear();
+	reply->disconnect(this);
+	reply->abort();
+	reply->deleteLater();
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "qtrest_global.h"
+
+#include <chrono>
+#include <optional>
+#include <functional>
+
+#include <QtCore/QObject>
+#include <QtCore/QByteArray>
+#include <QtCore/QPointer>
+#include <QtCore/QTimer>
+
+#include <QtNetwork/QNetworkReply>
+
+namespace QtRest {
+
+struct QTREST_EXPORT ServerSentEvent
+{
+	QByteArray event;
+	QByteArray data;
+	QByteArray id;
+};
+
+class QTREST_EXPORT EventStreamParser
+{
+public:
+	using Handler = std::function<void(const ServerSentEvent &)>;
+
+	explicit EventStreamParser(Handler handler);
+
+	// stops at the current line if the handler resets the parser
+	void addData(const QByteArray &data);
+	void reset();
+
+	QByteArray lastEventId() const;
+	std::optional<std::chrono::milliseconds> retry() const;
+
+private:
+	Handler _handler;
+	QByteArray _partial;
+	ServerSentEvent _event;
+	bool _hasData = false;
+	bool _atStart = true;
+	bool _skipLf = false;
+	quint64 _generation = 0;
+	QByteArray _lastEventId;
+	std::optional<std::chrono::milliseconds> _retry;
+
+	void processLine(const char *line, qsizetype size);
+	void dispatch();
+};
+
+class QTREST_EXPORT EventSource : public QObject
+{
+	Q_OBJECT
+
+	Q_PROPERTY(ReadyState readyState READ readyState NOTIFY readyStateChanged)
+	Q_PROPERTY(QByteArray lastEventId READ lastEventId STORED false)
+	Q_PROPERTY(int maxReconnectAttempts READ maxReconnectAttempts WRITE setMaxReconnectAttempts)
+
+public:
+	enum class ReadyState {
+		Connecting,
+		Open,
+		Closed
+	};
+	Q_ENUM(ReadyState)
+
+	using Launcher = std::function<QNetworkReply*(const HeaderMap &)>;
+
+	static const QByteArray ContentType;
+
+	explicit EventSource(Launcher launcher, QObject *parent = nullptr);
+	~EventSource() override;
+
+	ReadyState readyState() const;
+	QByteArray lastEventId() const;
+	std::chrono::milliseconds retryInterval() const;
+	int maxReconnectAttempts() const;
+
+	void setRetryInterval(std::chrono::milliseconds retryInterval);
+	void setMaxReconnectAttempts(int maxReconnectAttempts);
+
+public Q_SLOTS:
+	void open();
+	void close();
+
+Q_SIGNALS:
+	void readyStateChanged(QtRest::EventSource::ReadyState readyState);
+	void opened();
+	void eventReceived(const QtRest::ServerSentEvent &event);
+	void errorOccurred(QNetworkReply::NetworkError error, const QString &errorString);
+
+private:
+	Launcher _launcher;
+	EventStreamParser _parser;
+	QPointer<QNetworkReply> _reply;
+	QTimer *_reconnectTimer;
+	ReadyState _readyState = ReadyState::Closed;
+	std::chrono::milliseconds _retryInterval {3000};
+	int _maxReconnectAttempts = -1;
+	int _attempt = 0;
+	std::optional<bool> _accepted;
+
+	void readMetaData();
+	void readData();
+	void replyFinished();
+	void setReadyState(ReadyState readyState);
+	void disconnectReply();
+};
+
+}
+
+Q_DECLARE_METATYPE(QtRest::ServerSentEvent)
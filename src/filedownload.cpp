@@ -0,0 +1,238 @@
+#include "filedownload.h"
+#include <QtCore/QFileInfo>
+#include <QtCore/QRegularExpression>
+using namespace QtRest;
+using namespace QtRest::__private;
+
+QString FileDownload::partFilePath() const
+{
+	return filePath + QStringLiteral(".part");
+}
+
+QString FileDownload::checkpointFilePath() const
+{
+	return filePath + QStringLiteral(".part.checkpoint");
+}
+
+
+
+FileDownloader::FileDownloader(FileDownload download, BufferedNetworkReply *target) :
+	QObject{target},
+	_download{std::move(download)},
+	_target{target},
+	_file{_download.partFilePath()},
+	_hash{_download.hashAlgorithm}
+{}
+
+void FileDownloader::start(Launcher launcher)
+{
+	_launcher = std::move(launcher);
+	if (!_download.resume || !restore())
+		reset();
+	if (!_file.isOpen() && !_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+		fail(QNetworkReply::UnknownContentError, _file.errorString());
+		return;
+	}
+	launch();
+}
+
+bool FileDownloader::restore()
+{
+	QFile checkpoint{_download.checkpointFilePath()};
+	if (!_file.exists() || !checkpoint.open(QIODevice::ReadOnly))
+		return false;
+	_validator = checkpoint.readAll().trimmed();
+	if (_validator.isEmpty() || !_file.open(QIODevice::ReadWrite | QIODevice::Append))
+		return false;
+
+	// the hash has to cover the part that was downloaded before
+	if (!_download.expectedHash.isEmpty()) {
+		_file.seek(0);
+		if (!_hash.addData(&_file))
+			return false;
+	}
+	_offset = _file.size();
+	return true;
+}
+
+void FileDownloader::reset()
+{
+	if (_file.isOpen())
+		_file.resize(0);
+	else
+		QFile::remove(_file.fileName());
+	QFile::remove(_download.checkpointFilePath());
+	_hash.reset();
+	_validator.clear();
+	_offset = 0;
+	_total = -1;
+}
+
+void FileDownloader::launch()
+{
+	++_attempt;
+	_hasMetaData = false;
+	_writing = false;
+
+	HeaderMap headers;
+	// ranges refer to the encoded representation, so the body is requested as is
+	headers.insert("Accept-Encoding", "identity");
+	if (_offset > 0 && !_validator.isEmpty()) {
+		headers.insert("Range", "bytes=" + QByteArray::number(_offset) + '-');
+		headers.insert("If-Range", _validator);
+	}
+
+	_reply = _launcher(headers);
+	_reply->setParent(this);
+	_target->setSource(_reply);
+	connect(_reply, &QNetworkReply::metaDataChanged,
+			this, &FileDownloader::readMetaData);
+	connect(_reply, &QNetworkReply::readyRead,
+			this, &FileDownloader::readData);
+	connect(_reply, &QNetworkReply::finished,
+			this, &FileDownloader::replyFinished);
+}
+
+void FileDownloader::readMetaData()
+{
+	if (_hasMetaData)
+		return;
+	_hasMetaData = true;
+
+	const auto status = _reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+	if (status == 206) {
+		static const QRegularExpression rangeRegex{QStringLiteral(R"__(^bytes\s+(\d+)-\d+/(\d+|\*)$)__")};
+		const auto match = rangeRegex.match(QString::fromLatin1(_reply->rawHeader("Content-Range").trimmed()));
+		if (!match.hasMatch() || match.captured(1).toLongLong() != _offset) {
+			// the server answered a different range than requested, start over
+			reset();
+			_reply->abort();
+			return;
+		}
+		if (match.captured(2) != QStringLiteral("*"))
+			_total = match.captured(2).toLongLong();
+		_writing = true;
+	} else if (status == 200) {
+		if (_offset > 0)
+			reset();
+		_total = _reply->header(QNetworkRequest::ContentLengthHeader).isValid() ?
+			_reply->header(QNetworkRequest::ContentLengthHeader).toLongLong() :
+			-1;
+		_writing = true;
+	} else
+		return;
+
+	// only strong validators can be used to resume a transfer
+	if (const auto etag = _reply->rawHeader("ETag"); !etag.isEmpty() && !etag.startsWith("W/"))
+		_validator = etag;
+	else
+		_validator = _reply->rawHeader("Last-Modified");
+	QFile checkpoint{_download.checkpointFilePath()};
+	if (!_validator.isEmpty() && checkpoint.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		checkpoint.write(_validator);
+}
+
+void FileDownloader::readData()
+{
+	if (!_hasMetaData)
+		readMetaData();
+
+	const auto data = _reply->readAll();
+	if (!_writing) {
+		// error bodies are small and passed on to the caller
+		_target->appendData(data);
+		return;
+	}
+
+	if (_file.write(data) != data.size()) {
+		_writing = false;
+		_reply->abort();
+		fail(QNetworkReply::UnknownContentError, _file.errorString());
+		return;
+	}
+	if (!_download.expectedHash.isEmpty())
+		_hash.addData(data);
+	_offset += data.size();
+	emit downloadProgress(_offset, _total);
+}
+
+void FileDownloader::replyFinished()
+{
+	readData();
+	_file.flush();
+	const auto reply = _reply.data();
+	reply->deleteLater();
+
+	const auto status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+	const auto canResume = _attempt <= _download.maxResumeAttempts;
+	if (reply->error() == QNetworkReply::OperationCanceledError && _hasMetaData && !_writing && _offset == 0 && canResume) {
+		// aborted after an unexpected range, retry from the beginning
+		launch();
+		return;
+	} else if (status == 416 && _offset > 0 && canResume) {
+		reset();
+		launch();
+		return;
+	} else if (reply->error() != QNetworkReply::NoError &&
+			   reply->error() != QNetworkReply::OperationCanceledError &&
+			   status < 400 &&
+			   _writing &&
+			   !_validator.isEmpty() &&
+			   canResume) {
+		launch();
+		return;
+	}
+
+	_target->copyMetaData(reply);
+	if (reply->error() != QNetworkReply::NoError || !_writing) {
+		_target->finish();
+		return;
+	}
+
+	QString errorString;
+	if (!verify(errorString)) {
+		_file.close();
+		reset();
+		fail(QNetworkReply::UnknownContentError, errorString);
+		return;
+	}
+	complete();
+}
+
+bool FileDownloader::verify(QString &errorString)
+{
+	if (_total >= 0 && _offset != _total) {
+		errorString = tr("Downloaded %1 bytes, but expected %2").arg(_offset).arg(_total);
+		return false;
+	} else if (_download.expectedSize >= 0 && _offset != _download.expectedSize) {
+		errorString = tr("Downloaded %1 bytes, but expected %2").arg(_offset).arg(_download.expectedSize);
+		return false;
+	} else if (!_download.expectedHash.isEmpty() && _hash.result() != _download.expectedHash) {
+		errorString = tr("Downloaded file does not match the expected hash");
+		return false;
+	} else
+		return true;
+}
+
+void FileDownloader::complete()
+{
+	_file.close();
+	QFile::remove(_download.filePath);
+	if (!_file.rename(_download.filePath)) {
+		fail(QNetworkReply::UnknownContentError, _file.errorString());
+		return;
+	}
+	QFile::remove(_download.checkpointFilePath());
+	_target->finish();
+}
+
+void FileDownloader::fail(QNetworkReply::NetworkError error, const QString &errorString)
+{
+	auto metaData = _reply ?
+		BufferedNetworkReply::readMetaData(_reply) :
+		BufferedNetworkReply::MetaData{};
+	metaData.error = error;
+	metaData.errorString = errorString;
+	_target->setMetaData(metaData);
+	_target->finish();
+}
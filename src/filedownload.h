@@ -0,0 +1,76 @@
+#pragma once
+
+#include "qtrest_global.h"
+#include "bufferednetworkreply.h"
+
+#include <functional>
+
+#include <QtCore/QObject>
+#include <QtCore/QFile>
+#include <QtCore/QPointer>
+#include <QtCore/QCryptographicHash>
+
+#include <QtNetwork/QNetworkReply>
+
+namespace QtRest {
+
+struct QTREST_EXPORT FileDownload
+{
+	QString filePath;
+	qint64 readBufferSize = 64 * 1024;
+	qint64 expectedSize = -1;
+	// the raw digest as returned by QCryptographicHash::result(), not its hex or base64 encoding
+	QByteArray expectedHash;
+	QCryptographicHash::Algorithm hashAlgorithm = QCryptographicHash::Sha256;
+	bool resume = true;
+	int maxResumeAttempts = 3;
+
+	QString partFilePath() const;
+	QString checkpointFilePath() const;
+};
+
+namespace __private {
+
+class QTREST_EXPORT FileDownloader : public QObject
+{
+	Q_OBJECT
+
+public:
+	using Launcher = std::function<QNetworkReply*(const HeaderMap &)>;
+
+	FileDownloader(FileDownload download, BufferedNetworkReply *target);
+
+	void start(Launcher launcher);
+
+Q_SIGNALS:
+	// counts the bytes of the whole file, including those of earlier attempts
+	void downloadProgress(qint64 bytesReceived, qint64 bytesTotal);
+
+private:
+	FileDownload _download;
+	BufferedNetworkReply *_target;
+	Launcher _launcher;
+	QFile _file;
+	QCryptographicHash _hash;
+	QPointer<QNetworkReply> _reply;
+	QByteArray _validator;
+	qint64 _offset = 0;
+	qint64 _total = -1;
+	int _attempt = 0;
+	bool _hasMetaData = false;
+	bool _writing = false;
+
+	bool restore();
+	void reset();
+	void launch();
+	void readMetaData();
+	void readData();
+	void replyFinished();
+	bool verify(QString &errorString);
+	void complete();
+	void fail(QNetworkReply::NetworkError error, const QString &errorString);
+};
+
+}
+
+}
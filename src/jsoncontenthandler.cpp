@@ -1,77 +1,134 @@
-#include "jsoncontenthandler.h"
-using namespace QtRest;
-
-const QByteArray ContentHandlerArgs<JsonContentHandler>::ContentType = "application/json";
-
-
-
-JsonContentHandler<QJsonValue>::JsonContentHandler(ContentHandlerArgs<JsonContentHandler> args) :
-    _format{std::move(args.format)}
-{}
-
-QByteArrayList JsonContentHandler<QJsonValue>::contentTypes() const
-{
-    return {ContentHandlerArgs<JsonContentHandler>::ContentType};
-}
-
-JsonContentHandler<QJsonValue>::WriteResult JsonContentHandler<QJsonValue>::write(const QJsonValue &data)
-{
-    return std::make_pair(QtJson::writeJson(data, _format),
-                          ContentHandlerArgs<JsonContentHandler>::ContentType);
-}
-
-QJsonValue JsonContentHandler<QJsonValue>::read(const QString &data, const QByteArray &contentType)
-{
-    Q_UNUSED(contentType)
-    return QtJson::readJson(data);
-}
-
-
-
-JsonContentHandler<QJsonObject>::JsonContentHandler(ContentHandlerArgs<JsonContentHandler> args) :
-    _format{std::move(args.format)}
-{}
-
-QByteArrayList JsonContentHandler<QJsonObject>::contentTypes() const
-{
-    return {ContentHandlerArgs<JsonContentHandler>::ContentType};
-}
-
-JsonContentHandler<QJsonObject>::WriteResult JsonContentHandler<QJsonObject>::write(const QJsonObject &data)
-{
-    return std::make_pair(QtJson::writeJson(data, _format), ContentHandlerArgs<JsonContentHandler>::ContentType);
-}
-
-QJsonObject JsonContentHandler<QJsonObject>::read(const QString &data, const QByteArray &contentType)
-{
-    Q_UNUSED(contentType)
-    const auto json = QtJson::readJson(data);
-    if (!json.isObject())
-        throw QtJson::InvalidValueTypeException{json.type(), {QJsonValue::Object}};
-    return json.toObject();
-}
-
-
-
-JsonContentHandler<QJsonArray>::JsonContentHandler(ContentHandlerArgs<JsonContentHandler> args) :
-    _format{std::move(args.format)}
-{}
-
-QByteArrayList JsonContentHandler<QJsonArray>::contentTypes() const
-{
-    return {ContentHandlerArgs<JsonContentHandler>::ContentType};
-}
-
-JsonContentHandler<QJsonArray>::WriteResult JsonContentHandler<QJsonArray>::write(const QJsonArray &data)
-{
-    return std::make_pair(QtJson::writeJson(data, _format), ContentHandlerArgs<JsonContentHandler>::ContentType);
-}
-
-QJsonArray JsonContentHandler<QJsonArray>::read(const QString &data, const QByteArray &contentType)
-{
-    Q_UNUSED(contentType)
-    const auto json = QtJson::readJson(data);
-    if (!json.isArray())
-        throw QtJson::InvalidValueTypeException{json.type(), {QJsonValue::Array}};
-    return json.toArray();
-}
+#include "jsoncontenthandler.h"
+#include "jsonstreamreader.h"
+#include "qtrest_exceptions.h"
+using namespace QtRest;
+
+const QByteArray ContentHandlerArgs<JsonContentHandler>::ContentType = "application/json";
+
+QJsonValue QtRest::__private::readJsonData(const QByteArray &data, const QByteArray &contentType, QTextCodec *codec)
+{
+    // JSON is UTF-8 by default, only foreign charsets need the round trip through QString
+    static const auto utf8Codec = QTextCodec::codecForName("UTF-8");
+    if (codec && codec != utf8Codec)
+        return QtJson::readJson(codec->toUnicode(data));
+
+    // QJsonDocument only accepts objects and arrays as top level values
+    for (const auto c : data) {
+        if (c == '{' || c == '[') {
+            QJsonParseError error;
+            const auto doc = QJsonDocument::fromJson(data, &error);
+            if (error.error != QJsonParseError::NoError)
+                throw InvalidBodyException{contentType, error.errorString()};
+            return doc.isObject() ? QJsonValue{doc.object()} : QJsonValue{doc.array()};
+        } else if (c != ' ' && c != '\n' && c != '\r' && c != '\t')
+            break;
+    }
+
+    JsonStreamReader reader;
+    reader.addData(data);
+    reader.finish();
+    if (reader.hasError())
+        throw InvalidBodyException{contentType, reader.errorString()};
+    return reader.result();
+}
+
+QByteArray QtRest::__private::writeJsonData(const QJsonValue &value, QJsonDocument::JsonFormat format)
+{
+    switch (value.type()) {
+    case QJsonValue::Object:
+        return QJsonDocument{value.toObject()}.toJson(format);
+    case QJsonValue::Array:
+        return QJsonDocument{value.toArray()}.toJson(format);
+    default:
+        return QtJson::writeJson(value, format).toUtf8();
+    }
+}
+
+
+
+JsonContentHandler<QJsonValue>::JsonContentHandler(ContentHandlerArgs<JsonContentHandler> args) :
+    _format{std::move(args.format)}
+{}
+
+QByteArrayList JsonContentHandler<QJsonValue>::contentTypes() const
+{
+    return {ContentHandlerArgs<JsonContentHandler>::ContentType};
+}
+
+JsonContentHandler<QJsonValue>::WriteResult JsonContentHandler<QJsonValue>::write(const QJsonValue &data)
+{
+    return std::make_pair(__private::writeJsonData(data, _format),
+                          ContentHandlerArgs<JsonContentHandler>::ContentType);
+}
+
+QJsonValue JsonContentHandler<QJsonValue>::read(const QByteArray &data, const QByteArray &contentType, QTextCodec *codec)
+{
+    return __private::readJsonData(data, contentType, codec);
+}
+
+QJsonValue JsonContentHandler<QJsonValue>::readValue(const QJsonValue &value)
+{
+    return value;
+}
+
+
+
+JsonContentHandler<QJsonObject>::JsonContentHandler(ContentHandlerArgs<JsonContentHandler> args) :
+    _format{std::move(args.format)}
+{}
+
+QByteArrayList JsonContentHandler<QJsonObject>::contentTypes() const
+{
+    return {ContentHandlerArgs<JsonContentHandler>::ContentType};
+}
+
+JsonContentHandler<QJsonObject>::WriteResult JsonContentHandler<QJsonObject>::write(const QJsonObject &data)
+{
+    return std::make_pair(__private::writeJsonData(data, _format), ContentHandlerArgs<JsonContentHandler>::ContentType);
+}
+
+QJsonObject JsonContentHandler<QJsonObject>::read(const QByteArray &data, const QByteArray &contentType, QTextCodec *codec)
+{
+    const auto json = __private::readJsonData(data, contentType, codec);
+    if (!json.isObject())
+        throw QtJson::InvalidValueTypeException{json.type(), {QJsonValue::Object}};
+    return json.toObject();
+}
+
+QJsonObject JsonContentHandler<QJsonObject>::readValue(const QJsonValue &value)
+{
+    if (!value.isObject())
+        throw QtJson::InvalidValueTypeException{value.type(), {QJsonValue::Object}};
+    return value.toObject();
+}
+
+
+
+JsonContentHandler<QJsonArray>::JsonContentHandler(ContentHandlerArgs<JsonContentHandler> args) :
+    _format{std::move(args.format)}
+{}
+
+QByteArrayList JsonContentHandler<QJsonArray>::contentTypes() const
+{
+    return {ContentHandlerArgs<JsonContentHandler>::ContentType};
+}
+
+JsonContentHandler<QJsonArray>::WriteResult JsonContentHandler<QJsonArray>::write(const QJsonArray &data)
+{
+    return std::make_pair(__private::writeJsonData(data, _format), ContentHandlerArgs<JsonContentHandler>::ContentType);
+}
+
+QJsonArray JsonContentHandler<QJsonArray>::read(const QByteArray &data, const QByteArray &contentType, QTextCodec *codec)
+{
+    const auto json = __private::readJsonData(data, contentType, codec);
+    if (!json.isArray())
+        throw QtJson::InvalidValueTypeException{json.type(), {QJsonValue::Array}};
+    return json.toArray();
+}
+
+QJsonArray JsonContentHandler<QJsonArray>::readValue(const QJsonValue &value)
+{
+    if (!value.isArray())
+        throw QtJson::InvalidValueTypeException{value.type(), {QJsonValue::Array}};
+    return value.toArray();
+}
@@ -1,95 +1,139 @@
-#pragma once
-
-#include "contenthandler.h"
-#include <qtjson.h>
-
-namespace QtRest {
-
-template <typename T>
-class JsonContentHandler;
-
-template <>
-struct QTREST_EXPORT ContentHandlerArgs<JsonContentHandler> {
-    static const QByteArray ContentType;
-
-    QtJson::Configuration config = {};
-    QJsonDocument::JsonFormat format = QJsonDocument::Indented;
-};
-
-template <typename T>
-class JsonContentHandler : public IStringContentHandler<T>
-{
-public:
-    using WriteResult = typename IStringContentHandler<T>::WriteResult;
-
-    JsonContentHandler(ContentHandlerArgs<JsonContentHandler> args) :
-        _config{std::move(args)}
-    {}
-
-    QByteArrayList contentTypes() const override {
-        return {ContentHandlerArgs<JsonContentHandler>::ContentType};
-    }
-
-    WriteResult write(const T &data) override {
-        return std::make_pair(QtJson::stringify(data, _config.config, _config.format),
-                              ContentHandlerArgs<JsonContentHandler>::ContentType);
-    }
-
-    T read(const QString &data, const QByteArray &contentType) override {
-        Q_UNUSED(contentType)
-        return QtJson::parseString<T>(data, _config.config);
-    }
-
-private:
-    ContentHandlerArgs<JsonContentHandler> _config;
-};
-
-template <>
-class QTREST_EXPORT JsonContentHandler<QJsonValue> : public IStringContentHandler<QJsonValue>
-{
-public:
-    using WriteResult = typename IStringContentHandler<QJsonValue>::WriteResult;
-
-    JsonContentHandler(ContentHandlerArgs<JsonContentHandler> args);
-
-    QByteArrayList contentTypes() const override;
-    WriteResult write(const QJsonValue &data) override;
-    QJsonValue read(const QString &data, const QByteArray &contentType) override;
-
-private:
-    QJsonDocument::JsonFormat _format;
-};
-
-template <>
-class QTREST_EXPORT JsonContentHandler<QJsonObject> : public IStringContentHandler<QJsonObject>
-{
-public:
-    using WriteResult = typename IStringContentHandler<QJsonObject>::WriteResult;
-
-    JsonContentHandler(ContentHandlerArgs<JsonContentHandler> args);
-
-    QByteArrayList contentTypes() const override;
-    WriteResult write(const QJsonObject &data) override;
-    QJsonObject read(const QString &data, const QByteArray &contentType) override;
-
-private:
-    QJsonDocument::JsonFormat _format;
-};
-
-template <>
-class QTREST_EXPORT JsonContentHandler<QJsonArray> : public IStringContentHandler<QJsonArray>
-{
-public:
-    using WriteResult = typename IStringContentHandler<QJsonArray>::WriteResult;
-
-    JsonContentHandler(ContentHandlerArgs<JsonContentHandler> args);
-
-    QByteArrayList contentTypes() const override;
-    WriteResult write(const QJsonArray &data) override;
-    QJsonArray read(const QString &data, const QByteArray &contentType) override;
-
-private:
-    QJsonDocument::JsonFormat _format;
-};
-
-}
+#pragma once
+
+#include "contenthandler.h"
+#include "serializingdevice.h"
+#include <qtjson.h>
+#include <QtCore/QSharedPointer>
+
+namespace QtRest {
+
+template <typename T>
+class JsonContentHandler;
+
+namespace __private {
+
+QTREST_EXPORT QJsonValue readJsonData(const QByteArray &data, const QByteArray &contentType, QTextCodec *codec);
+QTREST_EXPORT QByteArray writeJsonData(const QJsonValue &value, QJsonDocument::JsonFormat format);
+
+}
+
+template <>
+struct QTREST_EXPORT ContentHandlerArgs<JsonContentHandler> {
+    static const QByteArray ContentType;
+
+    QtJson::Configuration config = {};
+    QJsonDocument::JsonFormat format = QJsonDocument::Indented;
+};
+
+template <typename T>
+class JsonContentHandler : public IByteArrayContentHandler<T>
+{
+public:
+    static constexpr bool IsJsonValueHandler = true;
+    static constexpr bool IsStreamingHandler = true;
+
+    using WriteResult = typename IByteArrayContentHandler<T>::WriteResult;
+
+    JsonContentHandler(ContentHandlerArgs<JsonContentHandler> args) :
+        _config{std::move(args)}
+    {}
+
+    QByteArrayList contentTypes() const override {
+        return {ContentHandlerArgs<JsonContentHandler>::ContentType};
+    }
+
+    WriteResult write(const T &data) override {
+        return std::make_pair(__private::writeJsonData(QtJson::serialize(data, _config.config), _config.format),
+                              ContentHandlerArgs<JsonContentHandler>::ContentType);
+    }
+
+    T read(const QByteArray &data, const QByteArray &contentType, QTextCodec *codec) override {
+        return readValue(__private::readJsonData(data, contentType, codec));
+    }
+
+    T readValue(const QJsonValue &value) {
+        return QtJson::parse<T>(value, _config.config);
+    }
+
+    template <typename TContainer>
+    std::pair<__private::SerializingDevice*, QByteArray> writeStream(TContainer data) {
+        static_assert(std::is_same_v<typename TContainer::value_type, T>, "TContainer must contain elements of type T");
+        const auto shared = QSharedPointer<const TContainer>::create(std::move(data));
+        return std::make_pair(new __private::SerializingDevice{[shared, config = _config.config]() -> __private::SerializingDevice::Generator {
+                                  return [shared, config, it = shared->cbegin()](QByteArray &out) mutable {
+                                      const auto first = it == shared->cbegin();
+                                      if (it == shared->cend()) {
+                                          out.append(first ? "[]" : "]");
+                                          return false;
+                                      }
+                                      out.append(first ? '[' : ',');
+                                      out.append(__private::writeJsonData(QtJson::serialize(*it, config), QJsonDocument::Compact));
+                                      ++it;
+                                      return true;
+                                  };
+                              }},
+                              ContentHandlerArgs<JsonContentHandler>::ContentType);
+    }
+
+private:
+    ContentHandlerArgs<JsonContentHandler> _config;
+};
+
+template <>
+class QTREST_EXPORT JsonContentHandler<QJsonValue> : public IByteArrayContentHandler<QJsonValue>
+{
+public:
+    static constexpr bool IsJsonValueHandler = true;
+
+    using WriteResult = typename IByteArrayContentHandler<QJsonValue>::WriteResult;
+
+    JsonContentHandler(ContentHandlerArgs<JsonContentHandler> args);
+
+    QByteArrayList contentTypes() const override;
+    WriteResult write(const QJsonValue &data) override;
+    QJsonValue read(const QByteArray &data, const QByteArray &contentType, QTextCodec *codec) override;
+    QJsonValue readValue(const QJsonValue &value);
+
+private:
+    QJsonDocument::JsonFormat _format;
+};
+
+template <>
+class QTREST_EXPORT JsonContentHandler<QJsonObject> : public IByteArrayContentHandler<QJsonObject>
+{
+public:
+    static constexpr bool IsJsonValueHandler = true;
+
+    using WriteResult = typename IByteArrayContentHandler<QJsonObject>::WriteResult;
+
+    JsonContentHandler(ContentHandlerArgs<JsonContentHandler> args);
+
+    QByteArrayList contentTypes() const override;
+    WriteResult write(const QJsonObject &data) override;
+    QJsonObject read(const QByteArray &data, const QByteArray &contentType, QTextCodec *codec) override;
+    QJsonObject readValue(const QJsonValue &value);
+
+private:
+    QJsonDocument::JsonFormat _format;
+};
+
+template <>
+class QTREST_EXPORT JsonContentHandler<QJsonArray> : public IByteArrayContentHandler<QJsonArray>
+{
+public:
+    static constexpr bool IsJsonValueHandler = true;
+
+    using WriteResult = typename IByteArrayContentHandler<QJsonArray>::WriteResult;
+
+    JsonContentHandler(ContentHandlerArgs<JsonContentHandler> args);
+
+    QByteArrayList contentTypes() const override;
+    WriteResult write(const QJsonArray &data) override;
+    QJsonArray read(const QByteArray &data, const QByteArray &contentType, QTextCodec *codec) override;
+    QJsonArray readValue(const QJsonValue &value);
+
+private:
+    QJsonDocument::JsonFormat _format;
+};
+
+}
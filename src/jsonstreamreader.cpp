@@ -0,0 +1,505 @@
+#include "jsonstreamreader.h"
+#include "jsoncontenthandler.h"
+#include <algorithm>
+#include <cstring>
+using namespace QtRest;
+using namespace QtRest::__private;
+
+namespace {
+
+inline bool isWhitespace(char c)
+{
+	return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+inline bool isNumberChar(char c)
+{
+	return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+inline bool isDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+// checks the RFC 8259 grammar, -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?, which toDouble is more lenient about
+bool isValidNumber(const char *data, qsizetype size)
+{
+	qsizetype pos = 0;
+	const auto skipDigits = [&]() {
+		const auto begin = pos;
+		while (pos < size && isDigit(data[pos]))
+			++pos;
+		return pos > begin;
+	};
+
+	if (pos < size && data[pos] == '-')
+		++pos;
+	if (pos < size && data[pos] == '0')
+		++pos;
+	else if (!skipDigits())
+		return false;
+	if (pos < size && data[pos] == '.') {
+		++pos;
+		if (!skipDigits())
+			return false;
+	}
+	if (pos < size && (data[pos] == 'e' || data[pos] == 'E')) {
+		++pos;
+		if (pos < size && (data[pos] == '+' || data[pos] == '-'))
+			++pos;
+		if (!skipDigits())
+			return false;
+	}
+	return pos == size;
+}
+
+inline int hexValue(const char *data)
+{
+	auto value = 0;
+	for (auto i = 0; i < 4; ++i) {
+		const auto c = data[i];
+		value <<= 4;
+		if (c >= '0' && c <= '9')
+			value |= c - '0';
+		else if (c >= 'a' && c <= 'f')
+			value |= c - 'a' + 10;
+		else if (c >= 'A' && c <= 'F')
+			value |= c - 'A' + 10;
+		else
+			return -1;
+	}
+	return value;
+}
+
+// returns the offset of the first byte that is not allowed inside a JSON string, or -1
+qsizetype findInvalidStringByte(const char *data, qsizetype size, const char *&reason)
+{
+	qsizetype i = 0;
+	while (i < size) {
+		const auto c = static_cast<uchar>(data[i]);
+		if (c >= 0x20 && c < 0x80) {
+			++i;
+			continue;
+		} else if (c < 0x20) {
+			reason = "unescaped control character in string";
+			return i;
+		}
+
+		reason = "invalid UTF-8 sequence in string";
+		auto length = 0;
+		uint code = 0;
+		uint minimum = 0;
+		if ((c & 0xe0) == 0xc0) {
+			length = 2;
+			code = c & 0x1f;
+			minimum = 0x80;
+		} else if ((c & 0xf0) == 0xe0) {
+			length = 3;
+			code = c & 0x0f;
+			minimum = 0x800;
+		} else if ((c & 0xf8) == 0xf0) {
+			length = 4;
+			code = c & 0x07;
+			minimum = 0x10000;
+		} else
+			return i;
+		if (size - i < length)
+			return i;
+		for (auto j = 1; j < length; ++j) {
+			const auto cc = static_cast<uchar>(data[i + j]);
+			if ((cc & 0xc0) != 0x80)
+				return i;
+			code = (code << 6) | (cc & 0x3f);
+		}
+		if (code < minimum || code > 0x10ffff || (code >= 0xd800 && code <= 0xdfff))
+			return i;
+		i += length;
+	}
+	return -1;
+}
+
+}
+
+JsonStreamReader::JsonStreamReader() = default;
+
+void JsonStreamReader::addData(const QByteArray &data)
+{
+	if (_expect == Expect::Error)
+		return;
+
+	if (_pending.isEmpty()) {
+		const auto consumed = parseChunk(data, false);
+		_offset += consumed;
+		_pending = data.mid(consumed);
+	} else {
+		_pending.append(data);
+		const auto consumed = parseChunk(_pending, false);
+		_offset += consumed;
+		_pending.remove(0, consumed);
+	}
+}
+
+void JsonStreamReader::finish()
+{
+	if (_expect == Expect::Error)
+		return;
+
+	const auto consumed = parseChunk(_pending, true);
+	if (_expect != Expect::Done && _expect != Expect::Error)
+		setError(QStringLiteral("unexpected end of data"), consumed);
+	_offset += _pending.size();
+	_pending.clear();
+}
+
+void JsonStreamReader::reset()
+{
+	*this = JsonStreamReader{};
+}
+
+bool JsonStreamReader::isComplete() const
+{
+	return _expect == Expect::Done;
+}
+
+bool JsonStreamReader::hasError() const
+{
+	return _expect == Expect::Error;
+}
+
+QString JsonStreamReader::errorString() const
+{
+	return _error;
+}
+
+QJsonValue JsonStreamReader::result() const
+{
+	return _result;
+}
+
+qsizetype JsonStreamReader::parseChunk(const QByteArray &buffer, bool final)
+{
+	const auto data = buffer.constData();
+	const auto size = static_cast<qsizetype>(buffer.size());
+	qsizetype pos = 0;
+	while (_expect != Expect::Error) {
+		while (pos < size && isWhitespace(data[pos]))
+			++pos;
+		if (pos == size)
+			return pos;
+
+		const auto c = data[pos];
+		switch (_expect) {
+		case Expect::ArrayValueOrEnd:
+			if (c == ']') {
+				endContainer();
+				++pos;
+				break;
+			}
+			Q_FALLTHROUGH();
+		case Expect::Value: {
+			const auto next = parseValue(data, size, pos, final);
+			if (next < 0)
+				return pos;
+			pos = next;
+			break;
+		}
+		case Expect::ArrayCommaOrEnd:
+			if (c == ',')
+				_expect = Expect::Value;
+			else if (c == ']')
+				endContainer();
+			else
+				setError(QStringLiteral("expected ',' or ']'"), pos);
+			++pos;
+			break;
+		case Expect::ObjectKeyOrEnd:
+			if (c == '}') {
+				endContainer();
+				++pos;
+				break;
+			}
+			Q_FALLTHROUGH();
+		case Expect::ObjectKey: {
+			if (c != '"') {
+				setError(QStringLiteral("expected an object key"), pos);
+				break;
+			}
+			QString key;
+			const auto next = parseString(data, size, pos, key);
+			if (next < 0)
+				return pos;
+			_stack.last().key = std::move(key);
+			if (_expect != Expect::Error)
+				_expect = Expect::ObjectColon;
+			pos = next;
+			break;
+		}
+		case Expect::ObjectColon:
+			if (c == ':')
+				_expect = Expect::Value;
+			else
+				setError(QStringLiteral("expected ':'"), pos);
+			++pos;
+			break;
+		case Expect::ObjectCommaOrEnd:
+			if (c == ',')
+				_expect = Expect::ObjectKey;
+			else if (c == '}')
+				endContainer();
+			else
+				setError(QStringLiteral("expected ',' or '}'"), pos);
+			++pos;
+			break;
+		case Expect::Done:
+			setError(QStringLiteral("unexpected data after the JSON value"), pos);
+			break;
+		case Expect::Error:
+			Q_UNREACHABLE();
+		}
+	}
+	return size;
+}
+
+qsizetype JsonStreamReader::parseValue(const char *data, qsizetype size, qsizetype pos, bool final)
+{
+	switch (data[pos]) {
+	case '{':
+		beginContainer(true);
+		return pos + 1;
+	case '[':
+		beginContainer(false);
+		return pos + 1;
+	case '"': {
+		QString string;
+		const auto next = parseString(data, size, pos, string);
+		if (next >= 0 && _expect != Expect::Error)
+			pushValue(QJsonValue{std::move(string)});
+		return next;
+	}
+	case 't':
+		return parseLiteral(data, size, pos, final, "true", 4, QJsonValue{true});
+	case 'f':
+		return parseLiteral(data, size, pos, final, "false", 5, QJsonValue{false});
+	case 'n':
+		return parseLiteral(data, size, pos, final, "null", 4, QJsonValue{QJsonValue::Null});
+	default:
+		if (data[pos] == '-' || (data[pos] >= '0' && data[pos] <= '9'))
+			return parseNumber(data, size, pos, final);
+		setError(QStringLiteral("unexpected character '%1'").arg(QLatin1Char(data[pos])), pos);
+		return pos + 1;
+	}
+}
+
+qsizetype JsonStreamReader::parseString(const char *data, qsizetype size, qsizetype pos, QString &string)
+{
+	// resume scanning where the previous chunk ended instead of rescanning the whole token
+	auto end = pos + std::max<qsizetype>(_scanOffset, 1);
+	for (; end < size; ++end) {
+		if (data[end] == '"') {
+			_scanOffset = 0;
+			decodeString(data + pos + 1, data + end, pos + 1, string);
+			return end + 1;
+		} else if (data[end] == '\\') {
+			if (end + 1 == size)
+				break;
+			++end;
+		}
+	}
+
+	_scanOffset = end - pos;
+	return -1;
+}
+
+qsizetype JsonStreamReader::parseNumber(const char *data, qsizetype size, qsizetype pos, bool final)
+{
+	auto end = pos;
+	while (end < size && isNumberChar(data[end]))
+		++end;
+	if (end == size && !final)
+		return -1;
+
+	const auto token = QByteArray::fromRawData(data + pos, end - pos);
+	if (!isValidNumber(token.constData(), token.size())) {
+		setError(QStringLiteral("invalid number \"%1\"").arg(QString::fromLatin1(token)), pos);
+		return end;
+	}
+
+	auto ok = false;
+	if (!token.contains('.') && !token.contains('e') && !token.contains('E')) {
+		if (const auto value = token.toLongLong(&ok); ok) {
+			pushValue(QJsonValue{value});
+			return end;
+		}
+	}
+
+	if (const auto value = token.toDouble(&ok); ok)
+		pushValue(QJsonValue{value});
+	else
+		setError(QStringLiteral("invalid number \"%1\"").arg(QString::fromLatin1(token)), pos);
+	return end;
+}
+
+qsizetype JsonStreamReader::parseLiteral(const char *data, qsizetype size, qsizetype pos, bool final, const char *literal, qsizetype length, const QJsonValue &value)
+{
+	const auto available = std::min(size - pos, length);
+	if (std::memcmp(data + pos, literal, static_cast<size_t>(available)) != 0) {
+		setError(QStringLiteral("invalid literal, expected \"%1\"").arg(QLatin1String{literal}), pos);
+		return pos + 1;
+	} else if (available < length) {
+		if (final)
+			setError(QStringLiteral("unexpected end of data"), size);
+		return final ? size : -1;
+	} else {
+		pushValue(value);
+		return pos + length;
+	}
+}
+
+bool JsonStreamReader::decodeString(const char *begin, const char *end, qsizetype pos, QString &string)
+{
+	const char *reason = nullptr;
+	if (const auto invalid = findInvalidStringByte(begin, end - begin, reason); invalid >= 0) {
+		setError(QString::fromLatin1(reason), pos + invalid);
+		return false;
+	}
+
+	const auto escape = static_cast<const char*>(std::memchr(begin, '\\', static_cast<size_t>(end - begin)));
+	if (!escape) {
+		string = QString::fromUtf8(begin, static_cast<int>(end - begin));
+		return true;
+	}
+
+	QString result;
+	result.reserve(static_cast<int>(end - begin));
+	auto segment = begin;
+	for (auto it = escape; it < end; ++it) {
+		if (*it != '\\')
+			continue;
+
+		result.append(QString::fromUtf8(segment, static_cast<int>(it - segment)));
+		const auto escapePos = pos + (it - begin);
+		switch (*(++it)) {
+		case '"':
+			result.append(QLatin1Char('"'));
+			break;
+		case '\\':
+			result.append(QLatin1Char('\\'));
+			break;
+		case '/':
+			result.append(QLatin1Char('/'));
+			break;
+		case 'b':
+			result.append(QLatin1Char('\b'));
+			break;
+		case 'f':
+			result.append(QLatin1Char('\f'));
+			break;
+		case 'n':
+			result.append(QLatin1Char('\n'));
+			break;
+		case 'r':
+			result.append(QLatin1Char('\r'));
+			break;
+		case 't':
+			result.append(QLatin1Char('\t'));
+			break;
+		case 'u': {
+			const auto code = end - it > 4 ? hexValue(it + 1) : -1;
+			if (code < 0) {
+				setError(QStringLiteral("invalid unicode escape sequence"), escapePos);
+				return false;
+			}
+			it += 4;
+			if (QChar::isLowSurrogate(static_cast<uint>(code))) {
+				setError(QStringLiteral("unpaired low surrogate in unicode escape sequence"), escapePos);
+				return false;
+			} else if (QChar::isHighSurrogate(static_cast<uint>(code))) {
+				// a high surrogate is only valid when directly followed by an escaped low surrogate
+				const auto low = end - it > 6 && it[1] == '\\' && it[2] == 'u' ? hexValue(it + 3) : -1;
+				if (low < 0 || !QChar::isLowSurrogate(static_cast<uint>(low))) {
+					setError(QStringLiteral("unpaired high surrogate in unicode escape sequence"), escapePos);
+					return false;
+				}
+				result.append(QChar{static_cast<ushort>(code)});
+				result.append(QChar{static_cast<ushort>(low)});
+				it += 6;
+			} else
+				result.append(QChar{static_cast<ushort>(code)});
+			break;
+		}
+		default:
+			setError(QStringLiteral("invalid escape sequence \"\\%1\"").arg(QLatin1Char(*it)), escapePos);
+			return false;
+		}
+		segment = it + 1;
+	}
+	result.append(QString::fromUtf8(segment, static_cast<int>(end - segment)));
+	string = std::move(result);
+	return true;
+}
+
+void JsonStreamReader::beginContainer(bool isObject)
+{
+	Frame frame;
+	frame.isObject = isObject;
+	_stack.append(std::move(frame));
+	_expect = isObject ? Expect::ObjectKeyOrEnd : Expect::ArrayValueOrEnd;
+}
+
+void JsonStreamReader::endContainer()
+{
+	auto frame = _stack.takeLast();
+	if (frame.isObject)
+		pushValue(QJsonValue{std::move(frame.object)});
+	else
+		pushValue(QJsonValue{std::move(frame.array)});
+}
+
+void JsonStreamReader::pushValue(const QJsonValue &value)
+{
+	if (_stack.isEmpty()) {
+		_result = value;
+		_expect = Expect::Done;
+	} else if (auto &top = _stack.last(); top.isObject) {
+		top.object.insert(top.key, value);
+		_expect = Expect::ObjectCommaOrEnd;
+	} else {
+		top.array.append(value);
+		_expect = Expect::ArrayCommaOrEnd;
+	}
+}
+
+void JsonStreamReader::setError(const QString &error, qsizetype pos)
+{
+	_expect = Expect::Error;
+	_error = QStringLiteral("%1 at offset %2")
+				 .arg(error)
+				 .arg(_offset + pos);
+}
+
+
+
+JsonBodyStream::JsonBodyStream(QNetworkReply *reply) :
+	BodyStreamReader{reply}
+{}
+
+const JsonStreamReader &JsonBodyStream::reader() const
+{
+	return _reader;
+}
+
+bool JsonBodyStream::acceptsContentType(const QByteArray &contentType) const
+{
+	return contentType == ContentHandlerArgs<JsonContentHandler>::ContentType;
+}
+
+void JsonBodyStream::consume(const QByteArray &chunk)
+{
+	_reader.addData(chunk);
+}
+
+void JsonBodyStream::finish()
+{
+	_reader.finish();
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "qtrest_global.h"
+#include "bodystreamreader.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+#include <QtCore/QJsonValue>
+#include <QtCore/QJsonObject>
+#include <QtCore/QJsonArray>
+
+namespace QtRest {
+
+class QTREST_EXPORT JsonStreamReader
+{
+public:
+	JsonStreamReader();
+
+	void addData(const QByteArray &data);
+	void finish();
+	void reset();
+
+	bool isComplete() const;
+	bool hasError() const;
+	QString errorString() const;
+	QJsonValue result() const;
+
+private:
+	enum class Expect {
+		Value,
+		ArrayValueOrEnd,
+		ArrayCommaOrEnd,
+		ObjectKeyOrEnd,
+		ObjectKey,
+		ObjectColon,
+		ObjectCommaOrEnd,
+		Done,
+		Error
+	};
+
+	struct Frame {
+		bool isObject = false;
+		QJsonArray array;
+		QJsonObject object;
+		QString key;
+	};
+
+	Expect _expect = Expect::Value;
+	QVector<Frame> _stack;
+	QJsonValue _result;
+	QByteArray _pending;
+	qsizetype _scanOffset = 0;
+	qint64 _offset = 0;
+	QString _error;
+
+	qsizetype parseChunk(const QByteArray &buffer, bool final);
+	qsizetype parseValue(const char *data, qsizetype size, qsizetype pos, bool final);
+	qsizetype parseString(const char *data, qsizetype size, qsizetype pos, QString &string);
+	qsizetype parseNumber(const char *data, qsizetype size, qsizetype pos, bool final);
+	qsizetype parseLiteral(const char *data, qsizetype size, qsizetype pos, bool final,
+						   const char *literal, qsizetype length, const QJsonValue &value);
+	bool decodeString(const char *begin, const char *end, qsizetype pos, QString &string);
+
+	void beginContainer(bool isObject);
+	void endContainer();
+	void pushValue(const QJsonValue &value);
+	void setError(const QString &error, qsizetype pos);
+};
+
+namespace __private {
+
+class QTREST_EXPORT JsonBodyStream : public BodyStreamReader
+{
+	Q_OBJECT
+
+public:
+	explicit JsonBodyStream(QNetworkReply *reply);
+
+	const JsonStreamReader &reader() const;
+
+protected:
+	bool acceptsContentType(const QByteArray &contentType) const override;
+	void consume(const QByteArray &chunk) override;
+	void finish() override;
+
+private:
+	JsonStreamReader _reader;
+};
+
+}
+
+}
@@ -0,0 +1,83 @@
+#include "ndjsonbodystream.h"
+#include "jsoncontenthandler.h"
+#include "qtrest_exceptions.h"
+using namespace QtRest;
+using namespace QtRest::__private;
+
+const QByteArrayList NdjsonBodyStream::ContentTypes {
+	"application/x-ndjson",
+	"application/ndjson",
+	"application/jsonl",
+	"application/x-jsonlines",
+	"application/json-seq"
+};
+
+NdjsonBodyStream::NdjsonBodyStream(QNetworkReply *reply, ItemHandler handler) :
+	BodyStreamReader{reply},
+	_handler{std::move(handler)}
+{}
+
+qint64 NdjsonBodyStream::itemCount() const
+{
+	return _itemCount;
+}
+
+bool NdjsonBodyStream::hasError() const
+{
+	return !_errorString.isNull();
+}
+
+QString NdjsonBodyStream::errorString() const
+{
+	return _errorString;
+}
+
+bool NdjsonBodyStream::acceptsContentType(const QByteArray &contentType) const
+{
+	return ContentTypes.contains(contentType);
+}
+
+void NdjsonBodyStream::consume(const QByteArray &chunk)
+{
+	// only the new chunk is scanned, a partial line is carried over until its newline arrives
+	auto start = 0;
+	for (auto end = chunk.indexOf('\n'); end >= 0; end = chunk.indexOf('\n', start)) {
+		if (_partial.isEmpty())
+			processLine(QByteArray::fromRawData(chunk.constData() + start, end - start));
+		else {
+			_partial.append(chunk.constData() + start, end - start);
+			processLine(std::exchange(_partial, {}));
+		}
+		start = end + 1;
+	}
+	_partial.append(chunk.constData() + start, chunk.size() - start);
+}
+
+void NdjsonBodyStream::finish()
+{
+	if (!_partial.isEmpty())
+		processLine(std::exchange(_partial, {}));
+}
+
+void NdjsonBodyStream::processLine(QByteArray line)
+{
+	++_line;
+	// json-seq prefixes every record with a record separator
+	if (line.startsWith('\x1e'))
+		line.remove(0, 1);
+	if (line.trimmed().isEmpty())
+		return;
+
+	QJsonValue item;
+	try {
+		item = readJsonData(line, ContentTypes.first(), nullptr);
+	} catch (std::exception &e) {
+		// a broken record is skipped, the first error is kept for the caller
+		if (_errorString.isNull())
+			_errorString = QStringLiteral("Line %1: %2").arg(_line).arg(QString::fromUtf8(e.what()));
+		return;
+	}
+	// exceptions of the handler are not parse errors and reach the caller
+	++_itemCount;
+	_handler(item);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "bodystreamreader.h"
+
+#include <functional>
+
+#include <QtCore/QJsonValue>
+
+namespace QtRest::__private {
+
+class QTREST_EXPORT NdjsonBodyStream : public BodyStreamReader
+{
+	Q_OBJECT
+
+public:
+	using ItemHandler = std::function<void(const QJsonValue &)>;
+
+	static const QByteArrayList ContentTypes;
+
+	NdjsonBodyStream(QNetworkReply *reply, ItemHandler handler);
+
+	qint64 itemCount() const;
+	bool hasError() const;
+	QString errorString() const;
+
+protected:
+	bool acceptsContentType(const QByteArray &contentType) const override;
+	void consume(const QByteArray &chunk) override;
+	void finish() override;
+
+private:
+	ItemHandler _handler;
+	QByteArray _partial;
+	qint64 _itemCount = 0;
+	qint64 _line = 0;
+	QString _errorString;
+
+	void processLine(QByteArray line);
+};
+
+}
@@ -1,63 +1,101 @@
-#include "qtrest_exceptions.h"
-#include <QtCore/QMetaType>
-using namespace QtRest;
-
-#define DEFINE_EXCEPTION_METHODS(Type) \
-	void Type::raise() const \
-	{ \
-		throw *this; \
-	} \
-	 \
-	ExceptionBase *Type::clone() const \
-	{ \
-		return new Type{*this}; \
-	}
-
-const char *Exception::what() const noexcept
-{
-	return _what.constData();
-}
-
-DEFINE_EXCEPTION_METHODS(Exception)
-
-Exception::Exception(QByteArray what) :
-	_what{std::move(what)}
-{}
-
-
-
-MissingContentHandlerException::MissingContentHandlerException(const QByteArray &contentType) :
-	Exception {
-		QByteArrayLiteral("No content handler found that can handle the Content-Type \"") +
-		contentType +
-		'"'
-	}
-{}
-
-DEFINE_EXCEPTION_METHODS(MissingContentHandlerException)
-
-
-
-UnconvertibleVariantException::UnconvertibleVariantException(int oldType, int newType) :
-	Exception {
-		QByteArrayLiteral("Unable to convert QVariant of type \"") +
-		QMetaType::typeName(oldType) +
-		QByteArrayLiteral("\" to target type \"") +
-		QMetaType::typeName(newType) +
-		QByteArrayLiteral("\" - register QVariant conversions via QMetaType::registerConverter!")
-	}
-{}
-
-DEFINE_EXCEPTION_METHODS(UnconvertibleVariantException)
-
-
-
-UnsupportedCodecException::UnsupportedCodecException(const QByteArray &codec) :
-	Exception {
-		QByteArrayLiteral("Unsupported content type codec \"") +
-		codec +
-		'"'
-	}
-{}
-
-DEFINE_EXCEPTION_METHODS(UnsupportedCodecException)
+#include "qtrest_exceptions.h"
+#include <QtCore/QMetaType>
+using namespace QtRest;
+
+#define DEFINE_EXCEPTION_METHODS(Type) \
+	void Type::raise() const \
+	{ \
+		throw *this; \
+	} \
+	 \
+	ExceptionBase *Type::clone() const \
+	{ \
+		return new Type{*this}; \
+	}
+
+const char *Exception::what() const noexcept
+{
+	return _what.constData();
+}
+
+DEFINE_EXCEPTION_METHODS(Exception)
+
+Exception::Exception(QByteArray what) :
+	_what{std::move(what)}
+{}
+
+
+
+MissingContentHandlerException::MissingContentHandlerException(const QByteArray &contentType) :
+	Exception {
+		QByteArrayLiteral("No content handler found that can handle the Content-Type \"") +
+		contentType +
+		'"'
+	}
+{}
+
+DEFINE_EXCEPTION_METHODS(MissingContentHandlerException)
+
+
+
+UnconvertibleVariantException::UnconvertibleVariantException(int oldType, int newType) :
+	Exception {
+		QByteArrayLiteral("Unable to convert QVariant of type \"") +
+		QMetaType::typeName(oldType) +
+		QByteArrayLiteral("\" to target type \"") +
+		QMetaType::typeName(newType) +
+		QByteArrayLiteral("\" - register QVariant conversions via QMetaType::registerConverter!")
+	}
+{}
+
+DEFINE_EXCEPTION_METHODS(UnconvertibleVariantException)
+
+
+
+UnsupportedCodecException::UnsupportedCodecException(const QByteArray &codec) :
+	Exception {
+		QByteArrayLiteral("Unsupported content type codec \"") +
+		codec +
+		'"'
+	}
+{}
+
+DEFINE_EXCEPTION_METHODS(UnsupportedCodecException)
+
+
+
+InvalidBodyException::InvalidBodyException(const QByteArray &contentType, const QString &error) :
+	Exception {
+		QByteArrayLiteral("Failed to read body of Content-Type \"") +
+		contentType +
+		QByteArrayLiteral("\" with error: ") +
+		error.toUtf8()
+	}
+{}
+
+DEFINE_EXCEPTION_METHODS(InvalidBodyException)
+
+
+
+FileMappingException::FileMappingException(const QString &filePath, const QString &error) :
+	Exception {
+		QByteArrayLiteral("Failed to map file \"") +
+		filePath.toUtf8() +
+		QByteArrayLiteral("\" into memory with error: ") +
+		error.toUtf8()
+	}
+{}
+
+DEFINE_EXCEPTION_METHODS(FileMappingException)
+
+
+
+UnretryableBodyException::UnretryableBodyException(const QByteArray &verb) :
+	Exception {
+		QByteArrayLiteral("Cannot retry \"") +
+		verb +
+		QByteArrayLiteral("\" request with a sequential body device - buffer the body or disable retries for it")
+	}
+{}
+
+DEFINE_EXCEPTION_METHODS(UnretryableBodyException)
@@ -0,0 +1,105 @@
+#include "requestcoalescer.h"
+#include "bufferednetworkreply.h"
+using namespace QtRest;
+using namespace QtRest::__private;
+
+const QByteArrayList RequestCoalescer::ConditionalHeaders {
+	"Range",
+	"If-Range",
+	"If-Match",
+	"If-None-Match",
+	"If-Modified-Since",
+	"If-Unmodified-Since"
+};
+
+RequestCoalescer::RequestCoalescer(QObject *parent) :
+	QObject{parent}
+{}
+
+QByteArrayList RequestCoalescer::varyHeaders() const
+{
+	return _varyHeaders;
+}
+
+int RequestCoalescer::inFlightCount() const
+{
+	return _flights.size();
+}
+
+void RequestCoalescer::setVaryHeaders(QByteArrayList varyHeaders)
+{
+	_varyHeaders = std::move(varyHeaders);
+}
+
+QNetworkReply *RequestCoalescer::send(const QNetworkRequest &request, const QByteArray &verb, const Launcher &launcher)
+{
+	const auto key = coalesceKey(request, verb);
+	const auto reply = new BufferedNetworkReply{request};
+	// aborted or deleted replies leave the flight, the request is aborted once nobody waits for it anymore
+	connect(reply, &QNetworkReply::finished,
+			this, [this, key]() {
+				replyFinished(key);
+			});
+	connect(reply, &QObject::destroyed,
+			this, [this, key]() {
+				replyFinished(key);
+			});
+	if (const auto it = _flights.find(key); it != _flights.end()) {
+		it->waiting.append(reply);
+		return reply;
+	}
+
+	_flights.insert(key, Flight{nullptr, {reply}});
+	const auto network = launcher([self = QPointer<RequestCoalescer>{this}, key](RawRestReply leader) {
+		const auto network = leader.reply().toStrongRef();
+		if (!self || !network)
+			return;
+
+		// a flight that was given up might have been replaced by a new one for the same key
+		const auto it = self->_flights.find(key);
+		if (it == self->_flights.end() || (it->network && it->network != network.data()))
+			return;
+
+		// the body is read once and shared implicitly between all waiting replies
+		const auto flight = std::move(*it);
+		self->_flights.erase(it);
+		const auto body = leader.bodyData();
+		for (const auto &reply : flight.waiting) {
+			if (reply) {
+				reply->copyMetaData(network.data());
+				reply->finish(body);
+			}
+		}
+	});
+	if (const auto it = _flights.find(key); it != _flights.end())
+		it->network = network;
+	return reply;
+}
+
+QByteArray RequestCoalescer::coalesceKey(const QNetworkRequest &request, const QByteArray &verb) const
+{
+	auto key = verb + ' ' + request.url().toEncoded();
+	for (const auto &headers : {ConditionalHeaders, _varyHeaders}) {
+		for (const auto &header : headers) {
+			if (request.hasRawHeader(header))
+				key += '\n' + header.toLower() + ": " + request.rawHeader(header);
+		}
+	}
+	return key;
+}
+
+void RequestCoalescer::replyFinished(const QByteArray &key)
+{
+	const auto it = _flights.find(key);
+	if (it == _flights.end())
+		return;
+	for (const auto &reply : qAsConst(it->waiting)) {
+		if (reply && !reply->isFinished())
+			return;
+	}
+
+	const auto network = it->network;
+	_flights.erase(it);
+	if (network)
+		network->abort();
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "qtrest_global.h"
+#include "restreply.h"
+
+#include <functional>
+
+#include <QtCore/QObject>
+#include <QtCore/QHash>
+#include <QtCore/QPointer>
+
+#include <QtNetwork/QNetworkRequest>
+
+namespace QtRest {
+
+namespace __private {
+class BufferedNetworkReply;
+}
+
+class QTREST_EXPORT RequestCoalescer : public QObject
+{
+	Q_OBJECT
+
+	Q_PROPERTY(QByteArrayList varyHeaders READ varyHeaders WRITE setVaryHeaders)
+	Q_PROPERTY(int inFlightCount READ inFlightCount STORED false)
+
+public:
+	using Callback = std::function<void(RawRestReply)>;
+	using Launcher = std::function<QNetworkReply*(Callback)>;
+
+	explicit RequestCoalescer(QObject *parent = nullptr);
+
+	QByteArrayList varyHeaders() const;
+	int inFlightCount() const;
+
+	void setVaryHeaders(QByteArrayList varyHeaders);
+
+	QNetworkReply *send(const QNetworkRequest &request, const QByteArray &verb, const Launcher &launcher);
+	QByteArray coalesceKey(const QNetworkRequest &request, const QByteArray &verb) const;
+
+private:
+	struct Flight {
+		QPointer<QNetworkReply> network;
+		QList<QPointer<__private::BufferedNetworkReply>> waiting;
+	};
+
+	// conditional and partial requests expect different responses for the same URL
+	static const QByteArrayList ConditionalHeaders;
+
+	QByteArrayList _varyHeaders {
+		"Accept",
+		"Accept-Encoding",
+		"Accept-Language",
+		"Authorization",
+		"Cookie"
+	};
+	QHash<QByteArray, Flight> _flights;
+
+	void replyFinished(const QByteArray &key);
+};
+
+}
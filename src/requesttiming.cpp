@@ -0,0 +1,105 @@
+#include "requesttiming.h"
+#include <algorithm>
+using namespace QtRest;
+using namespace QtRest::__private;
+using namespace std::chrono;
+
+nanoseconds RequestTiming::between(TimePoint from, TimePoint to)
+{
+	if (from == TimePoint{} || to == TimePoint{})
+		return nanoseconds::zero();
+	else
+		return duration_cast<nanoseconds>(to - from);
+}
+
+nanoseconds RequestTiming::queueTime() const
+{
+	return between(sendStarted, buildStarted);
+}
+
+nanoseconds RequestTiming::buildTime() const
+{
+	return between(buildStarted, buildFinished);
+}
+
+nanoseconds RequestTiming::connectTime() const
+{
+	// Qt 5 only reports the end of the TLS handshake, plain connections are part of the time to first byte
+	return between(requestStarted, encrypted);
+}
+
+nanoseconds RequestTiming::timeToFirstByte() const
+{
+	return between(requestStarted, headersReceived);
+}
+
+nanoseconds RequestTiming::transferTime() const
+{
+	return between(headersReceived, finished);
+}
+
+nanoseconds RequestTiming::deserializeTime() const
+{
+	return between(deserializeStarted, deserializeFinished);
+}
+
+nanoseconds RequestTiming::totalTime() const
+{
+	return between(sendStarted, std::max(finished, deserializeFinished));
+}
+
+
+
+TimingRecorder::TimingRecorder(QNetworkReply *reply, const RequestTiming &timing, QNetworkReply *source) :
+	QObject{reply},
+	_timing{timing}
+{
+	if (!source)
+		source = reply;
+	connect(source, &QNetworkReply::encrypted,
+			this, [this]() {
+				_timing.encrypted = RequestTiming::Clock::now();
+			});
+	connect(source, &QNetworkReply::uploadProgress,
+			this, [this](qint64 bytesSent, qint64 bytesTotal) {
+				if (bytesTotal > 0 && bytesSent == bytesTotal)
+					_timing.uploadFinished = RequestTiming::Clock::now();
+			});
+	// only the first occurrence is of interest, so these disconnect themselves
+	_metaDataConnection = connect(source, &QNetworkReply::metaDataChanged,
+								  this, [this]() {
+									  _timing.headersReceived = RequestTiming::Clock::now();
+									  disconnect(_metaDataConnection);
+								  });
+	_readyReadConnection = connect(source, &QNetworkReply::readyRead,
+								   this, [this]() {
+									   _timing.firstByte = RequestTiming::Clock::now();
+									   disconnect(_readyReadConnection);
+								   });
+	connect(source, &QNetworkReply::finished,
+			this, [this]() {
+				_timing.finished = RequestTiming::Clock::now();
+			});
+}
+
+TimingRecorder *TimingRecorder::find(QNetworkReply *reply)
+{
+	return reply ?
+		reply->findChild<TimingRecorder*>(QString{}, Qt::FindDirectChildrenOnly) :
+		nullptr;
+}
+
+const RequestTiming &TimingRecorder::timing() const
+{
+	return _timing;
+}
+
+void TimingRecorder::beginDeserialize()
+{
+	_timing.deserializeStarted = RequestTiming::Clock::now();
+}
+
+void TimingRecorder::endDeserialize()
+{
+	_timing.deserializeFinished = RequestTiming::Clock::now();
+}
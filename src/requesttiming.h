@@ -0,0 +1,67 @@
+#pragma once
+
+#include "qtrest_global.h"
+
+#include <chrono>
+
+#include <QtCore/QObject>
+
+#include <QtNetwork/QNetworkReply>
+
+namespace QtRest {
+
+struct QTREST_EXPORT RequestTiming
+{
+	using Clock = std::chrono::steady_clock;
+	using TimePoint = Clock::time_point;
+
+	// unset phases keep the default time point
+	TimePoint sendStarted;
+	TimePoint buildStarted;
+	TimePoint buildFinished;
+	TimePoint requestStarted;
+	TimePoint encrypted;
+	TimePoint uploadFinished;
+	TimePoint headersReceived;
+	TimePoint firstByte;
+	TimePoint finished;
+	TimePoint deserializeStarted;
+	TimePoint deserializeFinished;
+
+	static std::chrono::nanoseconds between(TimePoint from, TimePoint to);
+
+	std::chrono::nanoseconds queueTime() const;
+	std::chrono::nanoseconds buildTime() const;
+	std::chrono::nanoseconds connectTime() const;
+	std::chrono::nanoseconds timeToFirstByte() const;
+	std::chrono::nanoseconds transferTime() const;
+	std::chrono::nanoseconds deserializeTime() const;
+	std::chrono::nanoseconds totalTime() const;
+};
+
+namespace __private {
+
+class QTREST_EXPORT TimingRecorder : public QObject
+{
+	Q_OBJECT
+
+public:
+	// the recorder belongs to reply, but watches source so wrappers that do not forward all signals still get measured
+	TimingRecorder(QNetworkReply *reply, const RequestTiming &timing, QNetworkReply *source = nullptr);
+
+	static TimingRecorder *find(QNetworkReply *reply);
+
+	const RequestTiming &timing() const;
+
+	void beginDeserialize();
+	void endDeserialize();
+
+private:
+	RequestTiming _timing;
+	QMetaObject::Connection _metaDataConnection;
+	QMetaObject::Connection _readyReadConnection;
+};
+
+}
+
+}
@@ -0,0 +1,56 @@
+#include "restbatch.h"
+#ifdef QT_REST_USE_ASYNC
+#include <utility>
+using namespace QtRest::__private;
+
+BatchSenderBase::BatchSenderBase(int count, int maxInFlight) :
+	_count{count},
+	_maxInFlight{maxInFlight > 0 ? maxInFlight : count}
+{}
+
+void BatchSenderBase::start(QFutureInterfaceBase *futureInterface, const QFuture<void> &future)
+{
+	_futureInterface = futureInterface;
+	_futureInterface->setProgressRange(0, _count);
+	connect(&_watcher, &QFutureWatcherBase::canceled,
+			this, &BatchSenderBase::cancelAll);
+	_watcher.setFuture(future);
+	launchNext();
+}
+
+void BatchSenderBase::complete(int index)
+{
+	_inFlight.remove(index);
+	_futureInterface->setProgressValue(++_done);
+	launchNext();
+}
+
+void BatchSenderBase::launchNext()
+{
+	while (_inFlight.size() < _maxInFlight && _next < _count) {
+		const auto index = _next++;
+		_inFlight.insert(index, launch(index));
+	}
+	if (_done == _count)
+		finish();
+}
+
+void BatchSenderBase::cancelAll()
+{
+	_next = _count;
+	const auto inFlight = std::exchange(_inFlight, {});
+	for (const auto &reply : inFlight) {
+		if (reply)
+			reply->abort();
+	}
+	finish();
+}
+
+void BatchSenderBase::finish()
+{
+	if (_futureInterface->isFinished())
+		return;
+	_futureInterface->reportFinished();
+	deleteLater();
+}
+#endif
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "restbuilder_decl.h"
+
+#ifdef QT_REST_USE_ASYNC
+#include <QtCore/QObject>
+#include <QtCore/QPointer>
+#include <QtCore/QHash>
+#include <QtCore/QFuture>
+#include <QtCore/QFutureInterface>
+#include <QtCore/QFutureWatcher>
+
+namespace QtRest {
+
+namespace __private {
+
+class QTREST_EXPORT BatchSenderBase : public QObject
+{
+	Q_OBJECT
+
+public:
+	BatchSenderBase(int count, int maxInFlight);
+
+protected:
+	void start(QFutureInterfaceBase *futureInterface, const QFuture<void> &future);
+	void complete(int index);
+
+	virtual QNetworkReply *launch(int index) = 0;
+
+private:
+	QFutureInterfaceBase *_futureInterface = nullptr;
+	QFutureWatcher<void> _watcher;
+	int _count;
+	int _maxInFlight;
+	int _next = 0;
+	int _done = 0;
+	QHash<int, QPointer<QNetworkReply>> _inFlight;
+
+	void launchNext();
+	void cancelAll();
+	void finish();
+};
+
+template <typename TBuilder>
+class BatchSender : public BatchSenderBase
+{
+public:
+	using Reply = typename TBuilder::Reply;
+
+	BatchSender(QList<TBuilder> builders, int maxInFlight) :
+		BatchSenderBase{builders.size(), maxInFlight},
+		_builders{std::move(builders)}
+	{
+		_futureInterface.reportStarted();
+		start(&_futureInterface, _futureInterface.future());
+	}
+
+	QFuture<Reply> future() {
+		return _futureInterface.future();
+	}
+
+protected:
+	QNetworkReply *launch(int index) override {
+		auto builder = _builders[index];
+		// a result callback set on the builder still runs before the reply is reported
+		const auto callback = static_cast<RawRestBuilder<TBuilder>&>(builder).d->resultCallback;
+		return builder.onResult([this, index, callback](const Reply &reply) {
+			if (callback)
+				callback(reply);
+			_futureInterface.reportResult(reply, index);
+			complete(index);
+		}).send(this);
+	}
+
+private:
+	QList<TBuilder> _builders;
+	QFutureInterface<Reply> _futureInterface;
+};
+
+}
+
+template <typename TBuilder>
+QFuture<typename TBuilder::Reply> sendBatch(QList<TBuilder> builders, int maxInFlight = 6)
+{
+	const auto sender = new __private::BatchSender<TBuilder>{std::move(builders), maxInFlight};
+	return sender->future();
+}
+
+template <typename TBuilder, typename TParam, typename TConfigure>
+QFuture<typename TBuilder::Reply> sendBatch(const TBuilder &builder, const QList<TParam> &params, TConfigure &&configure, int maxInFlight = 6)
+{
+	QList<TBuilder> builders;
+	builders.reserve(params.size());
+	for (const auto &param : params) {
+		auto paramBuilder = builder;
+		configure(paramBuilder, param);
+		builders.append(std::move(paramBuilder));
+	}
+	return sendBatch(std::move(builders), maxInFlight);
+}
+
+}
+#endif
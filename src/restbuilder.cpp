@@ -45,6 +45,92 @@ QNetworkReply *SendBodyVisitor::operator()(const QUrlQuery &postParams)
 
 
 
+BodyFileHolder::BodyFileHolder(QSharedPointer<QFile> file, QNetworkReply *reply) :
+	QObject{reply},
+	_file{std::move(file)}
+{}
+
+
+
+QUrl PreparedRequest::buildUrl(const QStringList &pathSegments, bool trailingSlash, const QUrlQuery &query, const QString &fragment) const
+{
+	if (pathSegments.isEmpty() && query.isEmpty() && fragment.isNull())
+		return url;
+
+	auto result = url;
+	if (!pathSegments.isEmpty()) {
+		auto path = result.path();
+		if (!path.endsWith(QLatin1Char('/')))
+			path.append(QLatin1Char('/'));
+		path.append(pathSegments.join(QLatin1Char('/')));
+		if (trailingSlash)
+			path.append(QLatin1Char('/'));
+		result.setPath(path);
+	}
+
+	if (!query.isEmpty()) {
+		if (result.hasQuery()) {
+			QUrlQuery fullQuery{result};
+			for (const auto &item : query.queryItems(QUrl::FullyDecoded)) // clazy:exclude=range-loop
+				fullQuery.addQueryItem(item.first, item.second);
+			result.setQuery(fullQuery);
+		} else
+			result.setQuery(query);
+	}
+
+	if (!fragment.isNull())
+		result.setFragment(fragment);
+
+	return result;
+}
+
+
+
+void RestBuilderData::freeze(QSharedPointer<PreparedRequest> prepared)
+{
+	prepared->pathSegments = std::move(pathSegments);
+	prepared->query = std::move(query);
+	prepared->fragment = std::move(fragment);
+	prepared->headers = std::move(headers);
+	prepared->attributes = std::move(attributes);
+	pathSegments.clear();
+	query.clear();
+	fragment.clear();
+	headers.clear();
+	attributes.clear();
+	this->prepared = std::move(prepared);
+}
+
+void RestBuilderData::unfreeze()
+{
+	if (!prepared)
+		return;
+
+	pathSegments = prepared->pathSegments + pathSegments;
+
+	auto fullQuery = prepared->query;
+	for (const auto &item : query.queryItems(QUrl::FullyDecoded)) // clazy:exclude=range-loop
+		fullQuery.addQueryItem(item.first, item.second);
+	query = std::move(fullQuery);
+
+	if (fragment.isNull())
+		fragment = prepared->fragment;
+
+	auto fullHeaders = prepared->headers;
+	for (auto it = headers.constBegin(); it != headers.constEnd(); ++it)
+		fullHeaders.insert(it.key(), it.value());
+	headers = std::move(fullHeaders);
+
+	auto fullAttributes = prepared->attributes;
+	for (auto it = attributes.constBegin(); it != attributes.constEnd(); ++it)
+		fullAttributes.insert(it.key(), it.value());
+	attributes = std::move(fullAttributes);
+
+	prepared.reset();
+}
+
+
+
 RawRestReplyRunnable::RawRestReplyRunnable(std::function<void(RawRestReply)> callback, RawRestReply &&reply) :
     _callback{std::move(callback)},
     _reply{std::move(reply)}
@@ -52,5 +138,6 @@ RawRestReplyRunnable::RawRestReplyRunnable(std::function<void(RawRestReply)> cal
 
 void RawRestReplyRunnable::run()
 {
+    const RestTracer::Span span{"callback", RestTracer::isEnabled() ? _reply.reply().toStrongRef().data() : nullptr};
     _callback(_reply);
 }
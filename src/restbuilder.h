@@ -3,3 +3,5 @@
 #include "restbuilder_decl.h"
 #include "restbuilder_data.h"
 #include "restbuilder_impl.h"
+#include "restbatch.h"
+#include "restpaginator.h"
@@ -1,10 +1,15 @@
 #pragma once
 
 #include "restbuilder_decl.h"
+#include "jsonstreamreader.h"
+#include "ndjsonbodystream.h"
+#include "bufferednetworkreply.h"
 
 #include <variant>
 
 #include <QtCore/QLoggingCategory>
+#include <QtCore/QPointer>
+#include <QtCore/QFile>
 #ifdef QT_REST_USE_ASYNC
 #include <QtCore/QRunnable>
 #endif
@@ -28,6 +33,67 @@ private:
 	QNetworkAccessManager *nam;
 };
 
+// keeps a mapped body file open for as long as the reply uploading it exists
+class QTREST_EXPORT BodyFileHolder : public QObject
+{
+	Q_OBJECT
+
+public:
+	BodyFileHolder(QSharedPointer<QFile> file, QNetworkReply *reply);
+
+private:
+	QSharedPointer<QFile> _file;
+};
+
+struct QTREST_EXPORT PreparedRequest
+{
+	QUrl url;
+	QNetworkRequest request;
+
+	QStringList pathSegments;
+	QUrlQuery query;
+	QString fragment;
+	HeaderMap headers;
+	AttributeMap attributes;
+
+	QUrl buildUrl(const QStringList &pathSegments,
+				  bool trailingSlash,
+				  const QUrlQuery &query,
+				  const QString &fragment) const;
+};
+
+// the stages send() passes a request through, launchers continue after their own stage
+enum class SendStage {
+	Cache,
+	Coalescer,
+	Engine,
+	Scheduler,
+	Network
+};
+
+// settings that are rarely changed per request, shared between derived builders until one of them is modified.
+// This is a single shared layer below the per-builder data, not a chain of parents
+struct QTREST_EXPORT RestBuilderSetup : public QSharedData
+{
+	QNetworkAccessManager *nam = nullptr;
+	QPointer<RestScheduler> scheduler;
+	RestScheduler::Priority priority = RestScheduler::Priority::Normal;
+	QString tenant;
+	QPointer<RestCache> cache;
+	QPointer<RequestCoalescer> coalescer;
+	QPointer<RestEngine> engine;
+	QPointer<RestMetrics> metrics;
+	QList<QSharedPointer<IRestExtender>> extenders;
+	QUrl baseUrl;
+	std::optional<RetryPolicy> retryPolicy;
+	std::optional<Compression> compression;
+	bool recordTiming = false;
+
+#ifndef QT_NO_SSL
+	QSslConfiguration sslConfig;
+#endif
+};
+
 struct QTREST_EXPORT RestBuilderData : public QSharedData
 {
 
@@ -35,10 +101,8 @@ struct QTREST_EXPORT RestBuilderData : public QSharedData
 	static const QLatin1String ContentTypeHeader;
 	static const QByteArray ContentTypeUrlEncoded;
 
-	QNetworkAccessManager *nam = nullptr;
-	QList<QSharedPointer<IRestExtender>> extenders;
+	QSharedDataPointer<RestBuilderSetup> setup {new RestBuilderSetup{}};
 
-	QUrl baseUrl;
 	QStringList pathSegments;
 	bool trailingSlash = false;
 	QUrlQuery query;
@@ -46,12 +110,21 @@ struct QTREST_EXPORT RestBuilderData : public QSharedData
 	HeaderMap headers;
 	AttributeMap attributes;
 	std::variant<QByteArray, QIODevice*, QUrlQuery> body;
+	QSharedPointer<QFile> bodyFile;
 	QByteArray verb = Verbs::GET;
+	bool streamJsonBody = false;
+	std::function<void(const QJsonValue &)> itemCallback;
+	std::optional<FileDownload> download;
+	RequestTiming::TimePoint sendStarted;
+	QString metricsRoute;
+	// set by the send pipeline, so launchers do not detach the shared setup
+	SendStage sendStage = SendStage::Cache;
+	QNetworkAccessManager *engineNam = nullptr;
+	QSharedPointer<const PreparedRequest> prepared;
 	std::function<void(RawRestReply)> resultCallback;
 
-#ifndef QT_NO_SSL
-	QSslConfiguration sslConfig;
-#endif
+	void freeze(QSharedPointer<PreparedRequest> prepared);
+	void unfreeze();
 };
 
 #ifdef QT_REST_USE_ASYNC
@@ -78,6 +151,7 @@ public:
 	{}
 
 	void run() override {
+		const RestTracer::Span span{"callback", RestTracer::isEnabled() ? _reply.reply().toStrongRef().data() : nullptr};
 		_callback(_reply);
 	}
 
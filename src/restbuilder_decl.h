@@ -1,197 +1,274 @@
-#pragma once
-
-#include "qtrest_global.h"
-#include "restreply.h"
-#include "irestextender.h"
-
-#include <QtCore/QUrl>
-#include <QtCore/QUrlQuery>
-#include <QtCore/QSharedData>
-#include <QtCore/QVersionNumber>
-#include <QtCore/QMimeType>
-#include <QtCore/QVariant>
-#ifdef QT_REST_USE_ASYNC
-#include <QtCore/QThreadPool>
-#include <QtCore/QFuture>
-#endif
-
-#include <QtNetwork/QNetworkAccessManager>
-
-#include <qtjson.h>
-
-namespace QtRest::__private {
-
-struct RestBuilderData;
-
-}
-
-namespace QtRest {
-
-template <template <class> class... THandlers>
-class GenericRestBuilder;
-
-template <typename TBuilder>
-class RawRestBuilder
-{
-public:
-	using Builder = TBuilder;
-
-	enum class MergeFlag {
-		None = 0x00,
-		MergeQuery = 0x01,
-		KeepFragment = 0x02,
-	};
-	Q_DECLARE_FLAGS(MergeFlags, MergeFlag)
-
-	enum class VersionFlag {
-		None = 0x00,
-		UseVPrefix = 0x01,
-		Normalize = 0x02,
-		Standard = (UseVPrefix | Normalize)
-	};
-	Q_DECLARE_FLAGS(VersionFlags, VersionFlag)
-
-	RawRestBuilder();
-	RawRestBuilder(QUrl baseUrl, QNetworkAccessManager *nam = nullptr);
-	RawRestBuilder(const RawRestBuilder &other) = default;
-	RawRestBuilder(RawRestBuilder &&other) noexcept = default;
-	RawRestBuilder &operator=(const RawRestBuilder &other) = default;
-	RawRestBuilder &operator=(RawRestBuilder &&other) noexcept = default;
-	virtual ~RawRestBuilder() = default;
-
-	template <template <class> class THandler, typename... TArgs>
-	GenericRestBuilder<THandler> addContentTypeHandler(TArgs&&... args);
-
-	Builder &setNetworkAccessManager(QNetworkAccessManager *nam);
-	Builder &addExtender(IRestExtender *extender);
-	template <typename TExtender>
-	Builder &addExtender();
-
-	Builder &setBaseUrl(QUrl baseUrl);
-	Builder &setScheme(const QString &scheme);
-	Builder &setUser(const QString &user);
-	Builder &setPassword(const QString &password);
-	Builder &setCredentials(const QString &user, const QString &password = {});
-	Builder &setHost(const QString &host);
-	Builder &setPort(quint16 port);
-
-	Builder &addPath(const QString &pathSegment);
-	Builder &addPath(const QVersionNumber &version, VersionFlags versionFlags = VersionFlag::Standard);
-	Builder &addPath(const QStringList &pathSegments);
-	Builder &trailingSlash(bool enable = true);
-
-	Builder &addParameter(const QString &name, QVariant value);
-	template <typename T>
-	inline Builder &addParameter(const QString &name, const T &value);
-	Builder &addParameters(QUrlQuery parameters, bool replace = false);
-	Builder &setFragment(QVariant fragment);
-	template <typename T>
-	inline Builder &setFragment(const T &fragment);
-
-	Builder &addHeader(const QLatin1String &name, QVariant value);
-	template <typename T>
-	inline Builder &addHeader(const QLatin1String &name, const T &value);
-	Builder &addHeaders(HeaderMap headers, bool replace = false);
-	Builder &setAccept(const QByteArray &mimeType);
-	Builder &setAccept(const QByteArrayList &mimeTypes);
-	Builder &setAccept(const QMimeType &mimeType);
-	Builder &setAccept(const QList<QMimeType> &mimeTypes);
-
-	Builder &updateFromRelativeUrl(const QUrl &url, MergeFlags mergeFlags = MergeFlag::None);
-
-	Builder &setAttribute(QNetworkRequest::Attribute attribute, const QVariant &value);
-	template <typename T>
-	inline Builder &setAttribute(QNetworkRequest::Attribute attribute, const T &value);
-	Builder &setAttributes(AttributeMap attributes, bool replace = false);
-#ifndef QT_NO_SSL
-	Builder &setSslConfig(QSslConfiguration sslConfig);
-#endif
-
-	Builder &setBody(QByteArray body, const QByteArray &contentType, bool setAccept = true);
-	Builder &setBody(QByteArray body, const QMimeType &contentType, bool setAccept = true);
-	Builder &setBody(QIODevice *body, const QByteArray &contentType, bool setAccept = true);
-	Builder &setBody(QIODevice *body, const QMimeType &contentType, bool setAccept = true);
-    QIODevice *createBodyDevice(const QByteArray &contentType, bool setAccept = true);
-
-	Builder &addPostParameter(const QString &name, QVariant value);
-	template <typename T>
-	inline Builder &addPostParameter(const QString &name, const T &value);
-	Builder &addPostParameters(QUrlQuery parameters, bool replace = false);
-
-	Builder &setVerb(QByteArray verb);
-
-	Builder &onResult(std::function<void(RawRestReply)> callback);
-#ifdef QT_REST_USE_ASYNC
-	Builder &onResultAsync(std::function<void(RawRestReply)> callback);
-	Builder &onResultAsync(QThreadPool *threadPool, std::function<void(RawRestReply)> callback);
-#endif
-
-	QUrl buildUrl() const;
-	QNetworkRequest build() const;
-	QNetworkReply *send(QObject *context = nullptr) const;
-    QNetworkReply *get(QObject *context = nullptr);
-    QNetworkReply *post(QObject *context = nullptr);
-    QNetworkReply *put(QObject *context = nullptr);
-    QNetworkReply *deleteResource(QObject *context = nullptr);
-    QNetworkReply *patch(QObject *context = nullptr);
-    QNetworkReply *head(QObject *context = nullptr);
-
-#ifdef QT_REST_USE_ASYNC
-    QFuture<RawRestReply> sendAsync();
-    QFuture<RawRestReply> getAsync();
-    QFuture<RawRestReply> postAsync();
-    QFuture<RawRestReply> putAsync();
-    QFuture<RawRestReply> deleteResourceAsync();
-    QFuture<RawRestReply> patchAsync();
-    QFuture<RawRestReply> headAsync();
-#endif
-
-protected:
-	RawRestBuilder(const QSharedDataPointer<__private::RestBuilderData> &d);
-
-	QSharedDataPointer<__private::RestBuilderData> d;
-};
-
-class QTREST_EXPORT RestBuilder : public RawRestBuilder<RestBuilder> {};
-
-template <template <class> class... THandlers>
-class GenericRestBuilder : public RawRestBuilder<GenericRestBuilder<THandlers...>>
-{
-public:
-	using Builder = GenericRestBuilder<THandlers...>;
-	using RestReply = QtRest::RestReply<THandlers...>;
-
-	template<template <class> class THandler, typename... TArgs>
-	GenericRestBuilder<THandlers..., THandler> addContentTypeHandler(TArgs&&... args);
-
-	template <template <class> class THandler, typename T>
-	Builder& setBody(T &&body, bool setAccept = true);
-
-	Builder &onResult(std::function<void(RestReply)> callback);
-#ifdef QT_REST_USE_ASYNC
-	Builder &onResultAsync(std::function<void(RestReply)> callback);
-	Builder &onResultAsync(QThreadPool *threadPool, std::function<void(RestReply)> callback);
-#endif
-
-#ifdef QT_REST_USE_ASYNC
-    QFuture<RestReply> sendAsync();
-    QFuture<RestReply> getAsync();
-    QFuture<RestReply> postAsync();
-    QFuture<RestReply> putAsync();
-    QFuture<RestReply> deleteResourceAsync();
-    QFuture<RestReply> patchAsync();
-    QFuture<RestReply> headAsync();
-#endif
-
-protected:
-	GenericRestBuilder(const QSharedDataPointer<__private::RestBuilderData> &d,
-					   std::tuple<ContentHandlerArgs<THandlers>...> &&contentHandlerArgs);
-
-private:
-	std::tuple<ContentHandlerArgs<THandlers>...> _contentHandlerArgs;
-};
-
-}
-
-Q_DECLARE_GENERIC_OPERATORS_FOR_FLAGS(QtRest::RawRestBuilder<T>::MergeFlags, typename T)
-Q_DECLARE_GENERIC_OPERATORS_FOR_FLAGS(QtRest::RawRestBuilder<T>::VersionFlags, typename T)
+#pragma once
+
+#include "qtrest_global.h"
+#include "restreply.h"
+#include "irestextender.h"
+#include "restscheduler.h"
+#include "retrypolicy.h"
+#include "restcache.h"
+#include "requestcoalescer.h"
+#include "restengine.h"
+#include "deliveryqueue.h"
+#include "compression.h"
+#include "filedownload.h"
+#include "bodypipe.h"
+#include "eventsource.h"
+#include "restmetrics.h"
+#include "resttracer.h"
+
+#include <optional>
+#include <variant>
+
+#include <QtCore/QUrl>
+#include <QtCore/QUrlQuery>
+#include <QtCore/QSharedData>
+#include <QtCore/QVersionNumber>
+#include <QtCore/QMimeType>
+#include <QtCore/QVariant>
+#ifdef QT_REST_USE_ASYNC
+#include <QtCore/QThreadPool>
+#include <QtCore/QFuture>
+#endif
+
+#include <QtNetwork/QNetworkAccessManager>
+
+#include <qtjson.h>
+
+namespace QtRest::__private {
+
+struct RestBuilderData;
+template <typename TBuilder>
+class BatchSender;
+
+}
+
+namespace QtRest {
+
+template <template <class> class... THandlers>
+class GenericRestBuilder;
+
+template <typename TBuilder>
+class RawRestBuilder
+{
+public:
+	using Builder = TBuilder;
+	using Reply = RawRestReply;
+
+	enum class MergeFlag {
+		None = 0x00,
+		MergeQuery = 0x01,
+		KeepFragment = 0x02,
+	};
+	Q_DECLARE_FLAGS(MergeFlags, MergeFlag)
+
+	enum class VersionFlag {
+		None = 0x00,
+		UseVPrefix = 0x01,
+		Normalize = 0x02,
+		Standard = (UseVPrefix | Normalize)
+	};
+	Q_DECLARE_FLAGS(VersionFlags, VersionFlag)
+
+	RawRestBuilder();
+	RawRestBuilder(QUrl baseUrl, QNetworkAccessManager *nam = nullptr);
+	RawRestBuilder(const RawRestBuilder &other) = default;
+	RawRestBuilder(RawRestBuilder &&other) noexcept = default;
+	RawRestBuilder &operator=(const RawRestBuilder &other) = default;
+	RawRestBuilder &operator=(RawRestBuilder &&other) noexcept = default;
+	virtual ~RawRestBuilder() = default;
+
+	template <template <class> class THandler, typename... TArgs>
+	GenericRestBuilder<THandler> addContentTypeHandler(TArgs&&... args);
+
+	Builder &setNetworkAccessManager(QNetworkAccessManager *nam);
+	Builder &setScheduler(RestScheduler *scheduler,
+						  RestScheduler::Priority priority = RestScheduler::Priority::Normal,
+						  QString tenant = {});
+	Builder &addExtender(IRestExtender *extender);
+	template <typename TExtender>
+	Builder &addExtender();
+
+	Builder &setBaseUrl(QUrl baseUrl);
+	Builder &setScheme(const QString &scheme);
+	Builder &setUser(const QString &user);
+	Builder &setPassword(const QString &password);
+	Builder &setCredentials(const QString &user, const QString &password = {});
+	Builder &setHost(const QString &host);
+	Builder &setPort(quint16 port);
+
+	Builder &addPath(const QString &pathSegment);
+	Builder &addPath(const QVersionNumber &version, VersionFlags versionFlags = VersionFlag::Standard);
+	Builder &addPath(const QStringList &pathSegments);
+	Builder &trailingSlash(bool enable = true);
+
+	Builder &addParameter(const QString &name, QVariant value);
+	template <typename T>
+	inline Builder &addParameter(const QString &name, const T &value);
+	Builder &addParameters(QUrlQuery parameters, bool replace = false);
+	Builder &setFragment(QVariant fragment);
+	template <typename T>
+	inline Builder &setFragment(const T &fragment);
+
+	Builder &addHeader(const QLatin1String &name, QVariant value);
+	template <typename T>
+	inline Builder &addHeader(const QLatin1String &name, const T &value);
+	Builder &addHeaders(HeaderMap headers, bool replace = false);
+	Builder &setAccept(const QByteArray &mimeType);
+	Builder &setAccept(const QByteArrayList &mimeTypes);
+	Builder &setAccept(const QMimeType &mimeType);
+	Builder &setAccept(const QList<QMimeType> &mimeTypes);
+
+	Builder &updateFromRelativeUrl(const QUrl &url, MergeFlags mergeFlags = MergeFlag::None);
+
+	Builder &setAttribute(QNetworkRequest::Attribute attribute, const QVariant &value);
+	template <typename T>
+	inline Builder &setAttribute(QNetworkRequest::Attribute attribute, const T &value);
+	Builder &setAttributes(AttributeMap attributes, bool replace = false);
+#ifndef QT_NO_SSL
+	Builder &setSslConfig(QSslConfiguration sslConfig);
+#endif
+
+	Builder &setBody(QByteArray body, const QByteArray &contentType, bool setAccept = true);
+	Builder &setBody(QByteArray body, const QMimeType &contentType, bool setAccept = true);
+	Builder &setBody(QIODevice *body, const QByteArray &contentType, bool setAccept = true);
+	Builder &setBody(QIODevice *body, const QMimeType &contentType, bool setAccept = true);
+	// the file is memory mapped until the upload finishes - truncating it meanwhile crashes the process with SIGBUS
+	Builder &setBodyFile(const QString &filePath,
+						 const QByteArray &contentType,
+						 qint64 offset = 0,
+						 qint64 size = -1,
+						 bool setAccept = true);
+    // the returned pipe cannot be rewound, sending it with a retry policy that may resend the request throws UnretryableBodyException
+    BodyPipeWriter *createBodyDevice(const QByteArray &contentType,
+                                bool setAccept = true,
+                                qint64 contentLength = -1,
+                                qint64 bufferSize = 256 * 1024);
+
+	Builder &addPostParameter(const QString &name, QVariant value);
+	template <typename T>
+	inline Builder &addPostParameter(const QString &name, const T &value);
+	Builder &addPostParameters(QUrlQuery parameters, bool replace = false);
+
+	Builder &setVerb(QByteArray verb);
+	Builder &setCache(RestCache *cache);
+	Builder &setCoalescer(RequestCoalescer *coalescer);
+	Builder &setEngine(RestEngine *engine);
+	Builder &setRetryPolicy(std::optional<RetryPolicy> retryPolicy);
+	Builder &setCompression(std::optional<Compression> compression);
+	Builder &streamJsonBody(bool enable = true);
+	Builder &onItem(std::function<void(const QJsonValue &)> callback);
+	template <typename T>
+	Builder &onItem(std::function<void(T)> callback, QtJson::Configuration config = {});
+	Builder &setMetrics(RestMetrics *metrics);
+	// without a route the request path is used, with numeric and UUID segments replaced by placeholders
+	Builder &setMetricsRoute(QString route);
+	Builder &recordTiming(bool enable = true);
+	Builder &downloadTo(FileDownload download);
+
+	Builder &onResult(std::function<void(RawRestReply)> callback);
+#ifdef QT_REST_USE_ASYNC
+	Builder &onResultAsync(std::function<void(RawRestReply)> callback);
+	Builder &onResultAsync(QThreadPool *threadPool, std::function<void(RawRestReply)> callback);
+#endif
+
+	Builder &prepare();
+	bool isPrepared() const;
+
+	QUrl buildUrl() const;
+	QNetworkRequest build() const;
+	QNetworkReply *send(QObject *context = nullptr) const;
+	EventSource *openEventStream(QObject *parent = nullptr) const;
+    QNetworkReply *get(QObject *context = nullptr);
+    QNetworkReply *post(QObject *context = nullptr);
+    QNetworkReply *put(QObject *context = nullptr);
+    QNetworkReply *deleteResource(QObject *context = nullptr);
+    QNetworkReply *patch(QObject *context = nullptr);
+    QNetworkReply *head(QObject *context = nullptr);
+
+#ifdef QT_REST_USE_ASYNC
+    QFuture<RawRestReply> sendAsync();
+    QFuture<RawRestReply> getAsync();
+    QFuture<RawRestReply> postAsync();
+    QFuture<RawRestReply> putAsync();
+    QFuture<RawRestReply> deleteResourceAsync();
+    QFuture<RawRestReply> patchAsync();
+    QFuture<RawRestReply> headAsync();
+#endif
+
+protected:
+	template <typename>
+	friend class __private::BatchSender;
+
+	RawRestBuilder(const QSharedDataPointer<__private::RestBuilderData> &d);
+
+	using Body = std::variant<QByteArray, QIODevice*, QUrlQuery>;
+
+	QNetworkReply *sendNow(QObject *context) const;
+	QNetworkReply *connectResult(QNetworkReply *reply, QObject *context) const;
+	void attachStreams(QNetworkReply *reply, RequestTiming timing = {}, QNetworkReply *source = nullptr) const;
+	QNetworkReply *sendOnce(Body body) const;
+
+	QUrl buildBaseUrl() const;
+	QNetworkRequest buildBaseRequest() const;
+	void extendUrl(QUrl &url) const;
+
+	QSharedDataPointer<__private::RestBuilderData> d;
+};
+
+class QTREST_EXPORT RestBuilder : public RawRestBuilder<RestBuilder> {};
+
+template <template <class> class... THandlers>
+class GenericRestBuilder : public RawRestBuilder<GenericRestBuilder<THandlers...>>
+{
+public:
+	using Builder = GenericRestBuilder<THandlers...>;
+	using RestReply = QtRest::RestReply<THandlers...>;
+	using Reply = RestReply;
+
+	template<template <class> class THandler, typename... TArgs>
+	GenericRestBuilder<THandlers..., THandler> addContentTypeHandler(TArgs&&... args);
+
+	template <template <class> class THandler, typename T>
+	Builder& setBody(T &&body, bool setAccept = true);
+	// measureLength serializes the body twice, once up front for the Content-Length and once while uploading.
+	// It is skipped if request compression was set before, because the encoded length is unknown anyway
+	template <template <class> class THandler, typename TContainer>
+	Builder &setBodyStream(TContainer data, bool setAccept = true, bool measureLength = true);
+
+	Builder &onResult(std::function<void(RestReply)> callback);
+	using RawRestBuilder<Builder>::openEventStream;
+	template <typename T>
+	EventSource *openEventStream(std::function<void(const ServerSentEvent &, T)> callback,
+								 QObject *parent = nullptr,
+								 const QByteArray &dataContentType = "application/json") const;
+#ifdef QT_REST_USE_ASYNC
+	Builder &onResultAsync(std::function<void(RestReply)> callback);
+	Builder &onResultAsync(QThreadPool *threadPool, std::function<void(RestReply)> callback);
+	template <typename T>
+	Builder &onBodyAsync(QObject *target,
+						 std::function<void(RestReply, std::optional<T>)> callback,
+						 QThreadPool *threadPool = nullptr);
+#endif
+
+#ifdef QT_REST_USE_ASYNC
+    QFuture<RestReply> sendAsync();
+    QFuture<RestReply> getAsync();
+    QFuture<RestReply> postAsync();
+    QFuture<RestReply> putAsync();
+    QFuture<RestReply> deleteResourceAsync();
+    QFuture<RestReply> patchAsync();
+    QFuture<RestReply> headAsync();
+#endif
+
+protected:
+	GenericRestBuilder(const QSharedDataPointer<__private::RestBuilderData> &d,
+					   std::tuple<ContentHandlerArgs<THandlers>...> &&contentHandlerArgs);
+
+private:
+	std::tuple<ContentHandlerArgs<THandlers>...> _contentHandlerArgs;
+};
+
+}
+
+Q_DECLARE_GENERIC_OPERATORS_FOR_FLAGS(QtRest::RawRestBuilder<T>::MergeFlags, typename T)
+Q_DECLARE_GENERIC_OPERATORS_FOR_FLAGS(QtRest::RawRestBuilder<T>::VersionFlags, typename T)
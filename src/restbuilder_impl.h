@@ -1,696 +1,1222 @@
-#pragma once
-
-#include "restbuilder_decl.h"
-#include "restbuilder_data.h"
-#include "qtrest_exceptions.h"
-
-#include <QtCore/QBuffer>
-
-namespace QtRest {
-
-template <typename TBuilder>
-RawRestBuilder<TBuilder>::RawRestBuilder() :
-	d{new __private::RestBuilderData{}}
-{}
-
-template <typename TBuilder>
-RawRestBuilder<TBuilder>::RawRestBuilder(QUrl baseUrl, QNetworkAccessManager *nam) :
-	RawRestBuilder{}
-{
-	d->baseUrl = std::move(baseUrl);
-	d->nam = nam;
-}
-
-template <typename TBuilder>
-template <template <class> class THandler, typename... TArgs>
-GenericRestBuilder<THandler> RawRestBuilder<TBuilder>::addContentTypeHandler(TArgs&&... args)
-{
-	return GenericRestBuilder<THandler>{
-		d,
-		std::tie(ContentHandlerArgs<THandler>{std::forward<TArgs>(args)...})
-	};
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setNetworkAccessManager(QNetworkAccessManager *nam)
-{
-	d->nam = nam;
-	return *static_cast<Builder*>(this);
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::addExtender(IRestExtender *extender)
-{
-	d->extenders.append(QSharedPointer<IRestExtender>{extender});
-	return *static_cast<Builder*>(this);
-}
-
-template <typename TBuilder>
-template <typename TExtender>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::addExtender()
-{
-	static_assert(std::is_base_of_v<IRestExtender, TExtender>, "TExtender must implement IRestExtender");
-	return addExtender(new TExtender{});
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setBaseUrl(QUrl baseUrl)
-{
-	d->baseUrl = std::move(baseUrl);
-	return *static_cast<Builder*>(this);
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setScheme(const QString &scheme)
-{
-	d->baseUrl.setScheme(scheme);
-	return *static_cast<Builder*>(this);
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setUser(const QString &user)
-{
-	d->baseUrl.setUserName(user);
-	return *static_cast<Builder*>(this);
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setPassword(const QString &password)
-{
-	d->baseUrl.setPassword(password);
-	return *static_cast<Builder*>(this);
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setCredentials(const QString &user, const QString &password)
-{
-	return setUser(user).setPassword(password);
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setHost(const QString &host)
-{
-	d->baseUrl.setHost(host);
-	return *static_cast<Builder*>(this);
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setPort(quint16 port)
-{
-	d->baseUrl.setPort(port);
-	return *static_cast<Builder*>(this);
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::addPath(const QString &pathSegment)
-{
-	d->pathSegments.append(pathSegment);
-	return *static_cast<Builder*>(this);
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::addPath(const QVersionNumber &version, VersionFlags versionFlags)
-{
-	auto pathSegment = versionFlags.testFlag(VersionFlag::Normalize) ?
-		version.normalized().toString() :
-		version.toString();
-	if (versionFlags.testFlag(VersionFlag::UseVPrefix))
-		pathSegment.prepend(QLatin1Char('v'));
-	return addPath(pathSegment);
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::addPath(const QStringList &pathSegments)
-{
-	d->pathSegments.append(pathSegments);
-	return *static_cast<Builder*>(this);
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::trailingSlash(bool enable)
-{
-	d->trailingSlash = enable;
-	return *static_cast<Builder*>(this);
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::addParameter(const QString &name, QVariant value)
-{
-	if (const auto oldType = value.userType(); !value.convert(QMetaType::QString))
-		throw UnconvertibleVariantException{oldType, value.userType()};
-	d->query.addQueryItem(name, value.toString());
-	return *static_cast<Builder*>(this);
-}
-
-template <typename TBuilder>
-template <typename T>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::addParameter(const QString &name, const T &value)
-{
-	return addParameter(name, QVariant::fromValue(value));
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::addParameters(QUrlQuery parameters, bool replace)
-{
-	if (replace)
-		d->query = std::move(parameters);
-	else {
-		for (const auto &item : parameters.queryItems())
-			d->query.addQueryItem(item.first, item.second);
-	}
-	return *static_cast<Builder*>(this);
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setFragment(QVariant fragment)
-{
-	if (const auto oldType = fragment.userType(); !fragment.convert(QMetaType::QString))
-		throw UnconvertibleVariantException{oldType, fragment.userType()};
-	d->fragment = fragment.toString();
-	return *static_cast<Builder*>(this);
-}
-
-template <typename TBuilder>
-template <typename T>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setFragment(const T &fragment)
-{
-	return setFragment(QVariant::fromValue(fragment));
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::addHeader(const QLatin1String &name, QVariant value)
-{
-	if (const auto oldType = value.userType(); !value.convert(QMetaType::QString))
-		throw UnconvertibleVariantException{oldType, value.userType()};
-	d->headers.insert(name.latin1(), value.toString().toLatin1());
-	return *static_cast<Builder*>(this);
-}
-
-template <typename TBuilder>
-template <typename T>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::addHeader(const QLatin1String &name, const T &value)
-{
-	return addHeader(name, QVariant::fromValue(value));
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::addHeaders(HeaderMap headers, bool replace)
-{
-	if (replace)
-		d->headers = std::move(headers);
-	else {
-		for (auto it = headers.begin(), end = headers.end(); it != end; ++it)
-			d->headers.insert(it.key(), it.value());
-	}
-	return *static_cast<Builder*>(this);
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setAccept(const QByteArray &mimeType)
-{
-	return addHeader(__private::RestBuilderData::AcceptHeader, mimeType);
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setAccept(const QByteArrayList &mimeTypes)
-{
-	return addHeader(__private::RestBuilderData::AcceptHeader, mimeTypes.join(", "));
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setAccept(const QMimeType &mimeType)
-{
-	return setAccept(mimeType.name().toUtf8());
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setAccept(const QList<QMimeType> &mimeTypes)
-{
-	QByteArrayList values;
-	values.reserve(mimeTypes.size());
-	for (const auto &mimeType : mimeTypes)
-		values.append(mimeType.name().toUtf8());
-	return setAccept(values);
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::updateFromRelativeUrl(const QUrl &url, MergeFlags mergeFlags)
-{
-	auto cUrl = buildUrl();
-	d->baseUrl = cUrl.resolved(url);
-	if (d->baseUrl.host() != cUrl.host()) {
-		qCWarning(__private::logBuilder) << "URL host changed from"
-										 << cUrl.host()
-										 << "to"
-										 << d->baseUrl.host();
-	}
-
-	//clear all the rest
-	d->pathSegments.clear();
-	if (mergeFlags.testFlag(MergeFlag::MergeQuery)) {
-		QUrlQuery query{url.query()};
-		for (const auto &item : query.queryItems(QUrl::FullyDecoded)) // clazy:exclude=range-loop
-			d->query.addQueryItem(item.first, item.second);
-	} else
-		d->query = QUrlQuery{url.query()};
-
-	if (!mergeFlags.testFlag(MergeFlag::KeepFragment))
-		d->fragment.clear();
-
-	return *static_cast<Builder*>(this);
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setAttribute(QNetworkRequest::Attribute attribute, const QVariant &value)
-{
-	d->attributes.insert(attribute, value);
-	return *static_cast<Builder*>(this);
-}
-
-template <typename TBuilder>
-template <typename T>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setAttribute(QNetworkRequest::Attribute attribute, const T &value)
-{
-	return setAttribute(attribute, QVariant::fromValue(value));
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setAttributes(AttributeMap attributes, bool replace)
-{
-	if (replace)
-		d->attributes = std::move(attributes);
-	else {
-		for (auto it = attributes.begin(), end = attributes.end(); it != end; ++it)
-			d->attributes.insert(it.key(), it.value());
-	}
-	return *static_cast<Builder*>(this);
-}
-
-#ifndef QT_NO_SSL
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setSslConfig(QSslConfiguration sslConfig)
-{
-	d->sslConfig = std::move(sslConfig);
-	return *static_cast<Builder*>(this);
-}
-#endif
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setBody(QByteArray body, const QByteArray &contentType, bool setAccept)
-{
-	d->body = body;
-	if (setAccept)
-		this->setAccept(contentType);
-	return addHeader(__private::RestBuilderData::ContentTypeHeader, contentType);
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setBody(QByteArray body, const QMimeType &contentType, bool setAccept)
-{
-	d->body = body;
-	if (setAccept)
-		this->setAccept(contentType);
-	return addHeader(__private::RestBuilderData::ContentTypeHeader, contentType.name().toUtf8());
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setBody(QIODevice *body, const QByteArray &contentType, bool setAccept)
-{
-	d->body = body;
-	if (setAccept)
-		this->setAccept(contentType);
-	return addHeader(__private::RestBuilderData::ContentTypeHeader, contentType);
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setBody(QIODevice *body, const QMimeType &contentType, bool setAccept)
-{
-	d->body = body;
-	if (setAccept)
-		this->setAccept(contentType);
-	return addHeader(__private::RestBuilderData::ContentTypeHeader, contentType.name().toUtf8());
-}
-
-template<typename TBuilder>
-QIODevice *RawRestBuilder<TBuilder>::createBodyDevice(const QByteArray &contentType, bool setAccept)
-{
-    const auto buffer = new QBuffer{};
-    buffer->open(QIODevice::WriteOnly);
-    if (setAccept)
-        this->setAccept(contentType);
-    addHeader(__private::RestBuilderData::ContentTypeHeader, contentType);
-    return buffer;
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::addPostParameter(const QString &name, QVariant value)
-{
-	if (const auto oldType = value.userType(); !value.convert(QMetaType::QString))
-		throw UnconvertibleVariantException{oldType, value.userType()};
-	if (!std::holds_alternative<QUrlQuery>(d->body))
-		d->body = QUrlQuery{};
-	std::get<QUrlQuery>(d->body).addQueryItem(name, value.toString());
-	return *static_cast<Builder*>(this);
-}
-
-template <typename TBuilder>
-template <typename T>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::addPostParameter(const QString &name, const T &value)
-{
-	return addPostParameter(name, QVariant::fromValue(value));
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::addPostParameters(QUrlQuery parameters, bool replace)
-{
-	if (replace)
-		d->body = std::move(parameters);
-	else {
-		if (!std::holds_alternative<QUrlQuery>(d->body))
-			d->body = QUrlQuery{};
-		for (const auto &item : parameters.queryItems())
-			std::get<QUrlQuery>(d->body).addQueryItem(item.first, item.second);
-	}
-	return *static_cast<Builder*>(this);
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setVerb(QByteArray verb)
-{
-    d->verb = std::move(verb);
-    return *static_cast<Builder*>(this);
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::onResult(std::function<void(RawRestReply)> callback)
-{
-	d->resultCallback = std::move(callback);
-	return *static_cast<Builder*>(this);
-}
-
-#ifdef QT_REST_USE_ASYNC
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::onResultAsync(std::function<void(RawRestReply)> callback)
-{
-	return onResultAsync(QThreadPool::globalInstance(), std::move(callback));
-}
-
-template <typename TBuilder>
-typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::onResultAsync(QThreadPool *threadPool, std::function<void(RawRestReply)> callback)
-{
-	return onResult([threadPool, cb = std::move(callback)](RawRestReply reply) {
-		threadPool->start(new __private::RawRestReplyRunnable{cb, std::move(reply)});
-	});
-}
-#endif
-
-template <typename TBuilder>
-QUrl RawRestBuilder<TBuilder>::buildUrl() const
-{
-	auto url = d->baseUrl;
-
-    auto pathList = url.path().split(QLatin1Char('/'), Qt::SkipEmptyParts);
-	pathList.append(d->pathSegments);
-	url.setPath(QLatin1Char('/') +
-				pathList.join(QLatin1Char('/')) +
-				(d->trailingSlash ? QStringLiteral("/") : QString{}));
-
-	if (!d->query.isEmpty())
-		url.setQuery(d->query);
-	if (!d->fragment.isNull())
-		url.setFragment(d->fragment);
-
-	for (const auto &extender : d->extenders)
-		extender->extendUrl(url);
-
-	qCDebug(__private::logBuilder) << "Built URL as"
-								   << url.toString(QUrl::PrettyDecoded | QUrl::RemoveUserInfo);
-	return url;
-}
-
-template <typename TBuilder>
-QNetworkRequest RawRestBuilder<TBuilder>::build() const
-{
-	QNetworkRequest request{buildUrl()};
-
-	for (auto it = d->headers.constBegin(); it != d->headers.constEnd(); it++)
-		request.setRawHeader(it.key(), it.value());
-	for (auto it = d->attributes.constBegin(); it != d->attributes.constEnd(); it++)
-		request.setAttribute(it.key(), it.value());
-#ifndef QT_NO_SSL
-	request.setSslConfiguration(d->sslConfig);
-#endif
-
-	for (const auto &extender : d->extenders)
-		extender->extendRequest(request);
-
-	qCDebug(__private::logBuilder) << "Created request with headers"
-								   << d->headers.keys()
-								   << "and attributes" << d->attributes.keys();
-
-	return request;
-}
-
-template <typename TBuilder>
-QNetworkReply *RawRestBuilder<TBuilder>::send(QObject *context) const
-{
-	auto verb = d->verb;
-	auto body = d->body;
-
-	for (const auto &extender : d->extenders)
-		extender->extendSend(verb, body);
-
-	const auto reply = std::visit(__private::SendBodyVisitor{build(), verb, d->nam}, body);
-	if (d->resultCallback) {
-		QObject::connect(reply, &QNetworkReply::finished,
-						 context ? context : reply,
-						 [cb = d->resultCallback, reply]() {
-							 cb(RawRestReply{reply});
-						 });
-	}
-
-    if (std::holds_alternative<QIODevice*>(body)) {
-        const auto device = std::get<QIODevice*>(body);
-        if (!device->parent())
-            device->setParent(reply);
-    }
-
-	return reply;
-}
-
-template <typename TBuilder>
-QNetworkReply *RawRestBuilder<TBuilder>::get(QObject *context)
-{
-	return setVerb(Verbs::GET)
-		.send(context);
-}
-
-template <typename TBuilder>
-QNetworkReply *RawRestBuilder<TBuilder>::post(QObject *context)
-{
-	return setVerb(Verbs::POST)
-		.send(context);
-}
-
-template <typename TBuilder>
-QNetworkReply *RawRestBuilder<TBuilder>::put(QObject *context)
-{
-	return setVerb(Verbs::PUT)
-		.send(context);
-}
-
-template <typename TBuilder>
-QNetworkReply *RawRestBuilder<TBuilder>::deleteResource(QObject *context)
-{
-	return setVerb(Verbs::DELETE)
-		.send(context);
-}
-
-template <typename TBuilder>
-QNetworkReply *RawRestBuilder<TBuilder>::patch(QObject *context)
-{
-	return setVerb(Verbs::PATCH)
-		.send(context);
-}
-
-template <typename TBuilder>
-QNetworkReply *RawRestBuilder<TBuilder>::head(QObject *context)
-{
-	return setVerb(Verbs::HEAD)
-		.send(context);
-}
-
-#ifdef QT_REST_USE_ASYNC
-template<typename TBuilder>
-QFuture<RawRestReply> RawRestBuilder<TBuilder>::sendAsync()
-{
-	Q_ASSERT_X(!d->resultCallback, Q_FUNC_INFO, "Cannot use result callback with sendAsync");
-	QFutureInterface<RawRestReply> fi;
-	fi.reportStarted();
-	onResult([fi](const RawRestReply &reply) mutable {
-		fi.reportFinished(&reply);
-    })
-        .send();
-	return QFuture<RawRestReply>{&fi};
-}
-
-template <typename TBuilder>
-QFuture<RawRestReply> RawRestBuilder<TBuilder>::getAsync()
-{
-	return setVerb(Verbs::GET)
-		.sendAsync();
-}
-
-template <typename TBuilder>
-QFuture<RawRestReply> RawRestBuilder<TBuilder>::postAsync()
-{
-	return setVerb(Verbs::POST)
-		.sendAsync();
-}
-
-template <typename TBuilder>
-QFuture<RawRestReply> RawRestBuilder<TBuilder>::putAsync()
-{
-	return setVerb(Verbs::PUT)
-		.sendAsync();
-}
-
-template <typename TBuilder>
-QFuture<RawRestReply> RawRestBuilder<TBuilder>::deleteResourceAsync()
-{
-	return setVerb(Verbs::DELETE)
-		.sendAsync();
-}
-
-template <typename TBuilder>
-QFuture<RawRestReply> RawRestBuilder<TBuilder>::patchAsync()
-{
-	return setVerb(Verbs::PATCH)
-		.sendAsync();
-}
-
-template <typename TBuilder>
-QFuture<RawRestReply> RawRestBuilder<TBuilder>::headAsync()
-{
-	return setVerb(Verbs::HEAD)
-		.sendAsync();
-}
-#endif
-
-template<typename TBuilder>
-RawRestBuilder<TBuilder>::RawRestBuilder(const QSharedDataPointer<__private::RestBuilderData> &d) :
-	d{d}
-{}
-
-
-
-template <template <class> class... THandlers>
-template <template <class> class THandler, typename... TArgs>
-GenericRestBuilder<THandlers..., THandler> GenericRestBuilder<THandlers...>::addContentTypeHandler(TArgs&&... args)
-{
-	return GenericRestBuilder<THandler>{
-		this->d,
-		std::tuple_cat(_contentHandlerArgs, std::tie(ContentHandlerArgs<THandler>{std::forward<TArgs>(args)...}))
-	};
-}
-
-template <template <class> class... THandlers>
-template <template <class> class THandler, typename T>
-typename GenericRestBuilder<THandlers...>::Builder &GenericRestBuilder<THandlers...>::setBody(T &&body, bool setAccept)
-{
-    using TType = std::decay_t<T>;
-    static_assert (std::disjunction_v<std::is_same<THandler<TType>, THandlers<TType>>...>, "THandler must be one of the registered content handlers");
-    THandler<TType> handler {std::get<ContentHandlerArgs<THandler>>(_contentHandlerArgs)};
-    auto [data, contentType] = handler.write(std::forward<TType>(body));
-    if constexpr (THandler<TType>::IsStringHandler)
-		return setBody(data.toUtf8(), std::move(contentType), setAccept);
-	else
-        return setBody(std::move(data), std::move(contentType), setAccept);
-}
-
-template <template <class> class... THandlers>
-typename GenericRestBuilder<THandlers...>::Builder &GenericRestBuilder<THandlers...>::onResult(std::function<void(RestReply)> callback)
-{
-	return onResult([args = _contentHandlerArgs, callback](const RawRestReply &reply) {
-		callback(reply.toGeneric<THandlers...>(std::tuple<ContentHandlerArgs<THandlers>...>{args}));
-	});
-}
-
-#ifdef QT_REST_USE_ASYNC
-template <template <class> class... THandlers>
-typename GenericRestBuilder<THandlers...>::Builder &GenericRestBuilder<THandlers...>::onResultAsync(std::function<void(RestReply)> callback)
-{
-	return onResultAsync(QThreadPool::globalInstance(), std::move(callback));
-}
-
-template <template <class> class... THandlers>
-typename GenericRestBuilder<THandlers...>::Builder &GenericRestBuilder<THandlers...>::onResultAsync(QThreadPool *threadPool, std::function<void(RestReply)> callback)
-{
-	return onResult([threadPool, cb = std::move(callback)](RestReply reply) {
-		threadPool->start(new __private::RestReplyRunnable<THandlers...>{cb, std::move(reply)});
-	});
-}
-
-template <template <class> class... THandlers>
-QFuture<RestReply<THandlers...>> GenericRestBuilder<THandlers...>::sendAsync()
-{
-	Q_ASSERT_X(!this->d->resultCallback, Q_FUNC_INFO, "Cannot use result callback with sendAsync");
-	QFutureInterface<RestReply> fi;
-	fi.reportStarted();
-	onResult([fi](const RestReply &reply) mutable {
-		fi.reportFinished(&reply);
-    })
-        .send();
-	return QFuture<RestReply>{&fi};
-}
-
-template <template <class> class... THandlers>
-QFuture<RestReply<THandlers...>> GenericRestBuilder<THandlers...>::getAsync()
-{
-	return this->setVerb(Verbs::GET)
-		.sendAsync();
-}
-
-template <template <class> class... THandlers>
-QFuture<RestReply<THandlers...>> GenericRestBuilder<THandlers...>::postAsync()
-{
-	return this->setVerb(Verbs::POST)
-		.sendAsync();
-}
-
-template <template <class> class... THandlers>
-QFuture<RestReply<THandlers...>> GenericRestBuilder<THandlers...>::putAsync()
-{
-	return this->setVerb(Verbs::PUT)
-		.sendAsync();
-}
-
-template <template <class> class... THandlers>
-QFuture<RestReply<THandlers...>> GenericRestBuilder<THandlers...>::deleteResourceAsync()
-{
-	return this->setVerb(Verbs::DELETE)
-		.sendAsync();
-}
-
-template <template <class> class... THandlers>
-QFuture<RestReply<THandlers...>> GenericRestBuilder<THandlers...>::patchAsync()
-{
-	return this->setVerb(Verbs::PATCH)
-		.sendAsync();
-}
-
-template <template <class> class... THandlers>
-QFuture<RestReply<THandlers...>> GenericRestBuilder<THandlers...>::headAsync()
-{
-	return this->setVerb(Verbs::HEAD)
-		.sendAsync();
-}
-#endif
-
-template <template <class> class... THandlers>
-GenericRestBuilder<THandlers...>::GenericRestBuilder(const QSharedDataPointer<__private::RestBuilderData> &d, std::tuple<ContentHandlerArgs<THandlers>...> &&contentHandlerArgs) :
-	RawRestReply{d},
-	_contentHandlerArgs(std::move(contentHandlerArgs))
-{}
-
-}
+#pragma once
+
+#include "restbuilder_decl.h"
+#include "restbuilder_data.h"
+#include "qtrest_exceptions.h"
+
+#include <limits>
+#include <utility>
+
+namespace QtRest {
+
+template <typename TBuilder>
+RawRestBuilder<TBuilder>::RawRestBuilder() :
+	d{new __private::RestBuilderData{}}
+{}
+
+template <typename TBuilder>
+RawRestBuilder<TBuilder>::RawRestBuilder(QUrl baseUrl, QNetworkAccessManager *nam) :
+	RawRestBuilder{}
+{
+	d->setup->baseUrl = std::move(baseUrl);
+	d->setup->nam = nam;
+}
+
+template <typename TBuilder>
+template <template <class> class THandler, typename... TArgs>
+GenericRestBuilder<THandler> RawRestBuilder<TBuilder>::addContentTypeHandler(TArgs&&... args)
+{
+	return GenericRestBuilder<THandler>{
+		d,
+		std::tie(ContentHandlerArgs<THandler>{std::forward<TArgs>(args)...})
+	};
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setNetworkAccessManager(QNetworkAccessManager *nam)
+{
+	d->setup->nam = nam;
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::addExtender(IRestExtender *extender)
+{
+	d->unfreeze();
+	d->setup->extenders.append(QSharedPointer<IRestExtender>{extender});
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+template <typename TExtender>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::addExtender()
+{
+	static_assert(std::is_base_of_v<IRestExtender, TExtender>, "TExtender must implement IRestExtender");
+	return addExtender(new TExtender{});
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setBaseUrl(QUrl baseUrl)
+{
+	d->unfreeze();
+	d->setup->baseUrl = std::move(baseUrl);
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setScheme(const QString &scheme)
+{
+	d->unfreeze();
+	d->setup->baseUrl.setScheme(scheme);
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setUser(const QString &user)
+{
+	d->unfreeze();
+	d->setup->baseUrl.setUserName(user);
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setPassword(const QString &password)
+{
+	d->unfreeze();
+	d->setup->baseUrl.setPassword(password);
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setCredentials(const QString &user, const QString &password)
+{
+	return setUser(user).setPassword(password);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setHost(const QString &host)
+{
+	d->unfreeze();
+	d->setup->baseUrl.setHost(host);
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setPort(quint16 port)
+{
+	d->unfreeze();
+	d->setup->baseUrl.setPort(port);
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::addPath(const QString &pathSegment)
+{
+	d->pathSegments.append(pathSegment);
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::addPath(const QVersionNumber &version, VersionFlags versionFlags)
+{
+	auto pathSegment = versionFlags.testFlag(VersionFlag::Normalize) ?
+		version.normalized().toString() :
+		version.toString();
+	if (versionFlags.testFlag(VersionFlag::UseVPrefix))
+		pathSegment.prepend(QLatin1Char('v'));
+	return addPath(pathSegment);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::addPath(const QStringList &pathSegments)
+{
+	d->pathSegments.append(pathSegments);
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::trailingSlash(bool enable)
+{
+	d->unfreeze();
+	d->trailingSlash = enable;
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::addParameter(const QString &name, QVariant value)
+{
+	if (const auto oldType = value.userType(); !value.convert(QMetaType::QString))
+		throw UnconvertibleVariantException{oldType, value.userType()};
+	d->query.addQueryItem(name, value.toString());
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+template <typename T>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::addParameter(const QString &name, const T &value)
+{
+	return addParameter(name, QVariant::fromValue(value));
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::addParameters(QUrlQuery parameters, bool replace)
+{
+	if (replace) {
+		d->unfreeze();
+		d->query = std::move(parameters);
+	} else {
+		for (const auto &item : parameters.queryItems())
+			d->query.addQueryItem(item.first, item.second);
+	}
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setFragment(QVariant fragment)
+{
+	if (const auto oldType = fragment.userType(); !fragment.convert(QMetaType::QString))
+		throw UnconvertibleVariantException{oldType, fragment.userType()};
+	d->fragment = fragment.toString();
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+template <typename T>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setFragment(const T &fragment)
+{
+	return setFragment(QVariant::fromValue(fragment));
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::addHeader(const QLatin1String &name, QVariant value)
+{
+	if (const auto oldType = value.userType(); !value.convert(QMetaType::QString))
+		throw UnconvertibleVariantException{oldType, value.userType()};
+	d->headers.insert(name.latin1(), value.toString().toLatin1());
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+template <typename T>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::addHeader(const QLatin1String &name, const T &value)
+{
+	return addHeader(name, QVariant::fromValue(value));
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::addHeaders(HeaderMap headers, bool replace)
+{
+	if (replace) {
+		d->unfreeze();
+		d->headers = std::move(headers);
+	} else {
+		for (auto it = headers.begin(), end = headers.end(); it != end; ++it)
+			d->headers.insert(it.key(), it.value());
+	}
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setAccept(const QByteArray &mimeType)
+{
+	return addHeader(__private::RestBuilderData::AcceptHeader, mimeType);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setAccept(const QByteArrayList &mimeTypes)
+{
+	return addHeader(__private::RestBuilderData::AcceptHeader, mimeTypes.join(", "));
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setAccept(const QMimeType &mimeType)
+{
+	return setAccept(mimeType.name().toUtf8());
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setAccept(const QList<QMimeType> &mimeTypes)
+{
+	QByteArrayList values;
+	values.reserve(mimeTypes.size());
+	for (const auto &mimeType : mimeTypes)
+		values.append(mimeType.name().toUtf8());
+	return setAccept(values);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::updateFromRelativeUrl(const QUrl &url, MergeFlags mergeFlags)
+{
+	d->unfreeze();
+	auto cUrl = buildUrl();
+	d->setup->baseUrl = cUrl.resolved(url);
+	if (d->setup->baseUrl.host() != cUrl.host()) {
+		qCWarning(__private::logBuilder) << "URL host changed from"
+										 << cUrl.host()
+										 << "to"
+										 << d->setup->baseUrl.host();
+	}
+
+	//clear all the rest
+	d->pathSegments.clear();
+	if (mergeFlags.testFlag(MergeFlag::MergeQuery)) {
+		QUrlQuery query{url.query()};
+		for (const auto &item : query.queryItems(QUrl::FullyDecoded)) // clazy:exclude=range-loop
+			d->query.addQueryItem(item.first, item.second);
+	} else
+		d->query = QUrlQuery{url.query()};
+
+	if (!mergeFlags.testFlag(MergeFlag::KeepFragment))
+		d->fragment.clear();
+
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setAttribute(QNetworkRequest::Attribute attribute, const QVariant &value)
+{
+	d->attributes.insert(attribute, value);
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+template <typename T>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setAttribute(QNetworkRequest::Attribute attribute, const T &value)
+{
+	return setAttribute(attribute, QVariant::fromValue(value));
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setAttributes(AttributeMap attributes, bool replace)
+{
+	if (replace) {
+		d->unfreeze();
+		d->attributes = std::move(attributes);
+	} else {
+		for (auto it = attributes.begin(), end = attributes.end(); it != end; ++it)
+			d->attributes.insert(it.key(), it.value());
+	}
+	return *static_cast<Builder*>(this);
+}
+
+#ifndef QT_NO_SSL
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setSslConfig(QSslConfiguration sslConfig)
+{
+	d->unfreeze();
+	d->setup->sslConfig = std::move(sslConfig);
+	return *static_cast<Builder*>(this);
+}
+#endif
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setBody(QByteArray body, const QByteArray &contentType, bool setAccept)
+{
+	d->body = body;
+	d->bodyFile.reset();
+	if (setAccept)
+		this->setAccept(contentType);
+	return addHeader(__private::RestBuilderData::ContentTypeHeader, contentType);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setBody(QByteArray body, const QMimeType &contentType, bool setAccept)
+{
+	d->body = body;
+	d->bodyFile.reset();
+	if (setAccept)
+		this->setAccept(contentType);
+	return addHeader(__private::RestBuilderData::ContentTypeHeader, contentType.name().toUtf8());
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setBody(QIODevice *body, const QByteArray &contentType, bool setAccept)
+{
+	d->body = body;
+	d->bodyFile.reset();
+	if (setAccept)
+		this->setAccept(contentType);
+	return addHeader(__private::RestBuilderData::ContentTypeHeader, contentType);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setBody(QIODevice *body, const QMimeType &contentType, bool setAccept)
+{
+	d->body = body;
+	d->bodyFile.reset();
+	if (setAccept)
+		this->setAccept(contentType);
+	return addHeader(__private::RestBuilderData::ContentTypeHeader, contentType.name().toUtf8());
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setBodyFile(const QString &filePath, const QByteArray &contentType, qint64 offset, qint64 size, bool setAccept)
+{
+	auto file = QSharedPointer<QFile>::create(filePath);
+	if (!file->open(QIODevice::ReadOnly))
+		throw FileMappingException{filePath, file->errorString()};
+	if (size < 0)
+		size = file->size() - offset;
+	if (offset < 0 || size < 0 || offset + size > file->size() || size > std::numeric_limits<int>::max())
+		throw FileMappingException{filePath, QStringLiteral("Invalid file region")};
+
+	// the access manager reads raw data directly, so the mapped pages are uploaded without being copied
+	const auto data = size > 0 ? file->map(offset, size) : nullptr;
+	if (size > 0 && !data)
+		throw FileMappingException{filePath, file->errorString()};
+	setBody(QByteArray::fromRawData(reinterpret_cast<const char*>(data), static_cast<int>(size)), contentType, setAccept);
+	d->bodyFile = std::move(file);
+	return *static_cast<Builder*>(this);
+}
+
+template<typename TBuilder>
+BodyPipeWriter *RawRestBuilder<TBuilder>::createBodyDevice(const QByteArray &contentType, bool setAccept, qint64 contentLength, qint64 bufferSize)
+{
+    const auto reader = new __private::BodyPipeReader{bufferSize};
+    const auto writer = new BodyPipeWriter{reader};
+    d->body = reader;
+    d->bodyFile.reset();
+    // Qt 5 only streams sequential uploads with a known length, otherwise the pipe is buffered until it is closed
+    if (contentLength >= 0) {
+        addHeader(QLatin1String{"Content-Length"}, contentLength);
+        setAttribute(QNetworkRequest::DoNotBufferUploadDataAttribute, true);
+    }
+    if (setAccept)
+        this->setAccept(contentType);
+    addHeader(__private::RestBuilderData::ContentTypeHeader, contentType);
+    return writer;
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::addPostParameter(const QString &name, QVariant value)
+{
+	if (const auto oldType = value.userType(); !value.convert(QMetaType::QString))
+		throw UnconvertibleVariantException{oldType, value.userType()};
+	if (!std::holds_alternative<QUrlQuery>(d->body))
+		d->body = QUrlQuery{};
+	d->bodyFile.reset();
+	std::get<QUrlQuery>(d->body).addQueryItem(name, value.toString());
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+template <typename T>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::addPostParameter(const QString &name, const T &value)
+{
+	return addPostParameter(name, QVariant::fromValue(value));
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::addPostParameters(QUrlQuery parameters, bool replace)
+{
+	d->bodyFile.reset();
+	if (replace)
+		d->body = std::move(parameters);
+	else {
+		if (!std::holds_alternative<QUrlQuery>(d->body))
+			d->body = QUrlQuery{};
+		for (const auto &item : parameters.queryItems())
+			std::get<QUrlQuery>(d->body).addQueryItem(item.first, item.second);
+	}
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setVerb(QByteArray verb)
+{
+    d->verb = std::move(verb);
+    return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setCache(RestCache *cache)
+{
+	d->setup->cache = cache;
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setCoalescer(RequestCoalescer *coalescer)
+{
+	d->setup->coalescer = coalescer;
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setEngine(RestEngine *engine)
+{
+	d->setup->engine = engine;
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setScheduler(RestScheduler *scheduler, RestScheduler::Priority priority, QString tenant)
+{
+	d->setup->scheduler = scheduler;
+	d->setup->priority = priority;
+	d->setup->tenant = std::move(tenant);
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setRetryPolicy(std::optional<RetryPolicy> retryPolicy)
+{
+	d->setup->retryPolicy = std::move(retryPolicy);
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setCompression(std::optional<Compression> compression)
+{
+	d->setup->compression = std::move(compression);
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::streamJsonBody(bool enable)
+{
+	d->streamJsonBody = enable;
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::onItem(std::function<void(const QJsonValue &)> callback)
+{
+	d->itemCallback = std::move(callback);
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+template <typename T>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::onItem(std::function<void(T)> callback, QtJson::Configuration config)
+{
+	return onItem([cb = std::move(callback), config = std::move(config)](const QJsonValue &value) {
+		cb(QtJson::parse<T>(value, config));
+	});
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setMetrics(RestMetrics *metrics)
+{
+	d->setup->metrics = metrics;
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::setMetricsRoute(QString route)
+{
+	d->metricsRoute = std::move(route);
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::recordTiming(bool enable)
+{
+	d->setup->recordTiming = enable;
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::downloadTo(FileDownload download)
+{
+	d->download = std::move(download);
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::onResult(std::function<void(RawRestReply)> callback)
+{
+	d->resultCallback = std::move(callback);
+	return *static_cast<Builder*>(this);
+}
+
+#ifdef QT_REST_USE_ASYNC
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::onResultAsync(std::function<void(RawRestReply)> callback)
+{
+	return onResultAsync(QThreadPool::globalInstance(), std::move(callback));
+}
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::onResultAsync(QThreadPool *threadPool, std::function<void(RawRestReply)> callback)
+{
+	return onResult([threadPool, cb = std::move(callback)](RawRestReply reply) {
+		threadPool->start(new __private::RawRestReplyRunnable{cb, std::move(reply)});
+	});
+}
+#endif
+
+template <typename TBuilder>
+typename RawRestBuilder<TBuilder>::Builder &RawRestBuilder<TBuilder>::prepare()
+{
+	d->unfreeze();
+	// extenders are not frozen, they run again for every built request
+	auto prepared = QSharedPointer<__private::PreparedRequest>::create();
+	prepared->request = buildBaseRequest();
+	prepared->url = prepared->request.url();
+	d->freeze(std::move(prepared));
+	return *static_cast<Builder*>(this);
+}
+
+template <typename TBuilder>
+bool RawRestBuilder<TBuilder>::isPrepared() const
+{
+	return !d->prepared.isNull();
+}
+
+template <typename TBuilder>
+QUrl RawRestBuilder<TBuilder>::buildUrl() const
+{
+	auto url = buildBaseUrl();
+	extendUrl(url);
+	return url;
+}
+
+template <typename TBuilder>
+QNetworkRequest RawRestBuilder<TBuilder>::build() const
+{
+	auto request = buildBaseRequest();
+	auto url = request.url();
+	extendUrl(url);
+	request.setUrl(url);
+	for (const auto &extender : d->setup->extenders)
+		extender->extendRequest(request);
+
+	qCDebug(__private::logBuilder) << "Created request with headers"
+								   << request.rawHeaderList()
+								   << "and attributes"
+								   << (d->prepared ? d->prepared->attributes.keys() + d->attributes.keys() : d->attributes.keys());
+	return request;
+}
+
+template <typename TBuilder>
+QUrl RawRestBuilder<TBuilder>::buildBaseUrl() const
+{
+	if (d->prepared)
+		return d->prepared->buildUrl(d->pathSegments, d->trailingSlash, d->query, d->fragment);
+
+	auto url = d->setup->baseUrl;
+
+    auto pathList = url.path().split(QLatin1Char('/'), Qt::SkipEmptyParts);
+	pathList.append(d->pathSegments);
+	url.setPath(QLatin1Char('/') +
+				pathList.join(QLatin1Char('/')) +
+				(d->trailingSlash ? QStringLiteral("/") : QString{}));
+
+	if (!d->query.isEmpty())
+		url.setQuery(d->query);
+	if (!d->fragment.isNull())
+		url.setFragment(d->fragment);
+	return url;
+}
+
+template <typename TBuilder>
+void RawRestBuilder<TBuilder>::extendUrl(QUrl &url) const
+{
+	for (const auto &extender : d->setup->extenders)
+		extender->extendUrl(url);
+
+	qCDebug(__private::logBuilder) << "Built URL as"
+								   << url.toString(QUrl::PrettyDecoded | QUrl::RemoveUserInfo);
+}
+
+template <typename TBuilder>
+QNetworkRequest RawRestBuilder<TBuilder>::buildBaseRequest() const
+{
+	if (d->prepared) {
+		// only the parts added after prepare() have to be applied on top of the frozen request
+		auto request = d->prepared->request;
+		request.setUrl(buildBaseUrl());
+		for (auto it = d->headers.constBegin(); it != d->headers.constEnd(); it++)
+			request.setRawHeader(it.key(), it.value());
+		for (auto it = d->attributes.constBegin(); it != d->attributes.constEnd(); it++)
+			request.setAttribute(it.key(), it.value());
+		return request;
+	}
+
+	QNetworkRequest request{buildBaseUrl()};
+	for (auto it = d->headers.constBegin(); it != d->headers.constEnd(); it++)
+		request.setRawHeader(it.key(), it.value());
+	for (auto it = d->attributes.constBegin(); it != d->attributes.constEnd(); it++)
+		request.setAttribute(it.key(), it.value());
+#ifndef QT_NO_SSL
+	request.setSslConfiguration(d->setup->sslConfig);
+#endif
+	return request;
+}
+
+template <typename TBuilder>
+QNetworkReply *RawRestBuilder<TBuilder>::send(QObject *context) const
+{
+	// the start is stored in a copy so it travels through all queues and launchers
+	if (d->setup->recordTiming && d->sendStarted == RequestTiming::TimePoint{}) {
+		auto copy = *this;
+		copy.d->sendStarted = RequestTiming::Clock::now();
+		return copy.send(context);
+	}
+
+	// sequential devices cannot be rewound and reading them ahead would truncate bodies that are still being produced
+	if (d->setup->retryPolicy &&
+		d->setup->retryPolicy->mayResend(d->verb) &&
+		std::holds_alternative<QIODevice*>(d->body) &&
+		std::get<QIODevice*>(d->body)->isSequential())
+		throw UnretryableBodyException{d->verb};
+
+	if (d->download) {
+		const auto reply = new __private::BufferedNetworkReply{build(), d->verb};
+		const auto downloader = new __private::FileDownloader{*d->download, reply};
+		QObject::connect(downloader, &__private::FileDownloader::downloadProgress,
+						 reply, &QNetworkReply::downloadProgress);
+		// the attempts are sent through sendOnce() and instrumented there, the proxy gets the streams of this request
+		attachStreams(reply);
+		downloader->start([self = *this](const HeaderMap &headers) {
+			// the copy keeps the download so sendOnce() can limit the read buffer of the network reply
+			auto copy = self;
+			copy.d->streamJsonBody = false;
+			copy.d->itemCallback = nullptr;
+			copy.d->resultCallback = nullptr;
+			for (auto it = headers.begin(), end = headers.end(); it != end; ++it)
+				copy.d->headers.insert(it.key(), it.value());
+			return copy.sendNow(nullptr);
+		});
+		return connectResult(reply, context);
+	} else if (d->sendStage <= __private::SendStage::Cache && d->setup->cache && d->verb == Verbs::GET) {
+		const auto reply = d->setup->cache->send(build(), [self = *this](const HeaderMap &headers, RestCache::Callback callback) {
+			auto copy = self;
+			copy.d->sendStage = __private::SendStage::Coalescer;
+			copy.d->streamJsonBody = false;
+			copy.d->itemCallback = nullptr;
+			copy.d->resultCallback = std::move(callback);
+			for (auto it = headers.begin(), end = headers.end(); it != end; ++it)
+				copy.d->headers.insert(it.key(), it.value());
+			return copy.send(nullptr);
+		});
+		attachStreams(reply);
+		return connectResult(reply, context);
+	} else if (d->sendStage <= __private::SendStage::Coalescer && d->setup->coalescer && d->verb == Verbs::GET) {
+		const auto reply = d->setup->coalescer->send(build(), d->verb, [self = *this](RequestCoalescer::Callback callback) {
+			auto copy = self;
+			copy.d->sendStage = __private::SendStage::Engine;
+			copy.d->streamJsonBody = false;
+			copy.d->itemCallback = nullptr;
+			copy.d->resultCallback = std::move(callback);
+			return copy.send(nullptr);
+		});
+		attachStreams(reply);
+		return connectResult(reply, context);
+	} else if (d->sendStage <= __private::SendStage::Engine && d->setup->engine) {
+		const auto request = build();
+		const auto reply = new __private::BufferedNetworkReply{request, d->verb};
+		// results are posted to a relay on this thread, the proxy is only resolved there
+		const QSharedPointer<QObject> relay{new QObject{}, &QObject::deleteLater};
+		const auto canceled = QSharedPointer<QAtomicInt>::create(0);
+		reply->setAbortHandler([canceled]() {
+			canceled->storeRelease(1);
+		});
+		d->setup->engine->post(request.url().host(), [self = *this,
+													  relay,
+													  canceled,
+													  proxy = QPointer<__private::BufferedNetworkReply>{reply}](QNetworkAccessManager *nam) {
+			if (canceled->loadAcquire())
+				return;
+
+			auto copy = self;
+			copy.d->sendStage = __private::SendStage::Network;
+			copy.d->engineNam = nam;
+			copy.d->streamJsonBody = false;
+			copy.d->itemCallback = nullptr;
+			copy.d->resultCallback = [relay, proxy](RawRestReply result) {
+				const auto network = result.reply().toStrongRef();
+				if (!network)
+					return;
+				// the body is read on the engine thread and only its implicitly shared buffer is handed over
+				QMetaObject::invokeMethod(relay.data(), [proxy,
+														 metaData = __private::BufferedNetworkReply::readMetaData(network.data()),
+														 body = result.bodyData()]() {
+					if (proxy) {
+						proxy->setMetaData(metaData);
+						proxy->finish(body);
+					}
+				}, Qt::QueuedConnection);
+			};
+
+			// aborts are handed back to the engine thread, which is the only one touching the network reply
+			const auto abortNetwork = [nam, network = QPointer<QNetworkReply>{copy.send(nullptr)}]() {
+				QMetaObject::invokeMethod(nam, [network]() {
+					if (network)
+						network->abort();
+				}, Qt::QueuedConnection);
+			};
+			QMetaObject::invokeMethod(relay.data(), [proxy, abortNetwork]() {
+				if (!proxy || proxy->isFinished())
+					abortNetwork();
+				else
+					proxy->setAbortHandler(abortNetwork);
+			}, Qt::QueuedConnection);
+		});
+		attachStreams(reply);
+		return connectResult(reply, context);
+	} else if (d->sendStage <= __private::SendStage::Scheduler && d->setup->scheduler) {
+		const auto request = build();
+		const auto reply = new __private::BufferedNetworkReply{request, d->verb};
+		d->setup->scheduler->enqueue(request.url().host(), d->setup->priority, d->setup->tenant,
+							  [self = *this,
+							   proxy = QPointer<__private::BufferedNetworkReply>{reply},
+							   context = QPointer<QObject>{context},
+							   hasContext = context != nullptr](const RestScheduler::Release &release) {
+								  // the request is dropped if it was aborted or its context was destroyed while queued
+								  if (!proxy || proxy->isFinished()) {
+									  release();
+									  return;
+								  } else if (hasContext && !context) {
+									  proxy->abort();
+									  proxy->deleteLater();
+									  release();
+									  return;
+								  }
+
+								  auto copy = self;
+								  copy.d->streamJsonBody = false;
+								  copy.d->itemCallback = nullptr;
+								  // the slot is held until the last retry attempt has finished
+								  copy.d->resultCallback = [proxy, release](RawRestReply result) {
+									  const auto network = result.reply().toStrongRef();
+									  if (proxy && network) {
+										  proxy->copyMetaData(network.data());
+										  proxy->finish(result.bodyData());
+									  }
+									  release();
+								  };
+								  proxy->setSource(copy.sendNow(nullptr));
+							  });
+		attachStreams(reply);
+		return connectResult(reply, context);
+	} else
+		return sendNow(context);
+}
+
+template <typename TBuilder>
+EventSource *RawRestBuilder<TBuilder>::openEventStream(QObject *parent) const
+{
+	const auto source = new EventSource{[self = *this](const HeaderMap &headers) {
+		auto copy = self;
+		copy.d->streamJsonBody = false;
+		copy.d->itemCallback = nullptr;
+		for (auto it = headers.begin(), end = headers.end(); it != end; ++it)
+			copy.d->headers.insert(it.key(), it.value());
+		// the proxies would hold the stream back until it ends, so it is sent directly
+		return copy.sendOnce(copy.d->body);
+	}, parent};
+	source->open();
+	return source;
+}
+
+template <typename TBuilder>
+QNetworkReply *RawRestBuilder<TBuilder>::sendNow(QObject *context) const
+{
+	if (d->setup->retryPolicy) {
+		const auto device = std::holds_alternative<QIODevice*>(d->body) ?
+			std::get<QIODevice*>(d->body) :
+			nullptr;
+		const auto reply = new __private::BufferedNetworkReply{build(), d->verb};
+		const auto controller = new __private::RetryController{*d->setup->retryPolicy, d->verb, reply, context};
+		if (device && !device->parent())
+			device->setParent(controller);
+		// only the committed attempt is forwarded to the proxy, so the streams read from there and see each body once
+		auto attempt = *this;
+		attempt.d->streamJsonBody = false;
+		attempt.d->itemCallback = nullptr;
+		controller->start([attempt]() {
+			if (std::holds_alternative<QIODevice*>(attempt.d->body))
+				std::get<QIODevice*>(attempt.d->body)->seek(0);
+			return attempt.sendOnce(attempt.d->body);
+		});
+		attachStreams(reply);
+		return connectResult(reply, context);
+	}
+
+	return connectResult(sendOnce(d->body), context);
+}
+
+template <typename TBuilder>
+QNetworkReply *RawRestBuilder<TBuilder>::connectResult(QNetworkReply *reply, QObject *context) const
+{
+	if (d->resultCallback) {
+		QObject::connect(reply, &QNetworkReply::finished,
+						 context ? context : reply,
+						 [cb = d->resultCallback, reply]() {
+							 const RestTracer::Span span{"callback", reply};
+							 cb(RawRestReply{reply});
+						 });
+	}
+	return reply;
+}
+
+template <typename TBuilder>
+void RawRestBuilder<TBuilder>::attachStreams(QNetworkReply *reply, RequestTiming timing, QNetworkReply *source) const
+{
+	// must be created before the result callback is connected to see the finished signal first
+	if (d->setup->recordTiming) {
+		timing.sendStarted = d->sendStarted;
+		if (timing.requestStarted == RequestTiming::TimePoint{})
+			timing.requestStarted = RequestTiming::Clock::now();
+		new __private::TimingRecorder{reply, timing, source};
+	}
+	if (d->streamJsonBody)
+		new __private::JsonBodyStream{reply};
+	if (d->itemCallback)
+		new __private::NdjsonBodyStream{reply, d->itemCallback};
+}
+
+template <typename TBuilder>
+QNetworkReply *RawRestBuilder<TBuilder>::sendOnce(Body body) const
+{
+	RequestTiming timing;
+	if (d->setup->recordTiming)
+		timing.buildStarted = RequestTiming::Clock::now();
+	const auto traceId = RestTracer::isEnabled() ? RestTracer::nextRequestId() : 0;
+	const auto buildBegin = traceId ? RestTracer::now() : 0;
+
+	auto verb = d->verb;
+	for (const auto &extender : d->setup->extenders)
+		extender->extendSend(verb, body);
+
+	auto request = build();
+	if (d->setup->scheduler)
+		request.setPriority(RestScheduler::requestPriority(d->setup->priority));
+
+	if (d->setup->compression)
+		__private::encodeBody(*d->setup->compression, request, body);
+	const auto url = request.url();
+
+	if (d->setup->recordTiming)
+		timing.buildFinished = RequestTiming::Clock::now();
+	const auto sendBegin = traceId ? RestTracer::now() : 0;
+	auto reply = std::visit(__private::SendBodyVisitor{std::move(request), verb, d->engineNam ? d->engineNam : d->setup->nam}, body);
+	const auto sendEnd = traceId ? RestTracer::now() : 0;
+	if (d->download)
+		reply->setReadBufferSize(d->download->readBufferSize);
+	if (d->setup->recordTiming)
+		timing.requestStarted = RequestTiming::Clock::now();
+	if (d->setup->metrics) {
+		d->setup->metrics->track(reply,
+								 url.host(),
+								 verb,
+								 d->metricsRoute.isNull() ? RestMetrics::routeTemplate(url.path()) : d->metricsRoute);
+	}
+	const auto network = reply;
+	if (d->setup->compression && d->setup->compression->decodeResponses)
+		reply = __private::ContentDecoder::wrap(reply);
+	// the mapping has to outlive the upload, it is released together with the last reply or builder using it
+	if (d->bodyFile)
+		new __private::BodyFileHolder{d->bodyFile, reply};
+	if (traceId) {
+		const auto recorder = new __private::TraceRecorder{reply, traceId, sendBegin};
+		RestTracer::record(RestTracer::Event{"build", buildBegin, sendBegin - buildBegin, traceId, recorder->spanId()});
+		RestTracer::record(RestTracer::Event{"send", sendBegin, sendEnd - sendBegin, traceId, recorder->spanId()});
+	}
+	attachStreams(reply, timing, network);
+
+    if (std::holds_alternative<QIODevice*>(body)) {
+        const auto device = std::get<QIODevice*>(body);
+        if (!device->parent())
+            device->setParent(reply);
+    }
+
+	return reply;
+}
+
+template <typename TBuilder>
+QNetworkReply *RawRestBuilder<TBuilder>::get(QObject *context)
+{
+	return setVerb(Verbs::GET)
+		.send(context);
+}
+
+template <typename TBuilder>
+QNetworkReply *RawRestBuilder<TBuilder>::post(QObject *context)
+{
+	return setVerb(Verbs::POST)
+		.send(context);
+}
+
+template <typename TBuilder>
+QNetworkReply *RawRestBuilder<TBuilder>::put(QObject *context)
+{
+	return setVerb(Verbs::PUT)
+		.send(context);
+}
+
+template <typename TBuilder>
+QNetworkReply *RawRestBuilder<TBuilder>::deleteResource(QObject *context)
+{
+	return setVerb(Verbs::DELETE)
+		.send(context);
+}
+
+template <typename TBuilder>
+QNetworkReply *RawRestBuilder<TBuilder>::patch(QObject *context)
+{
+	return setVerb(Verbs::PATCH)
+		.send(context);
+}
+
+template <typename TBuilder>
+QNetworkReply *RawRestBuilder<TBuilder>::head(QObject *context)
+{
+	return setVerb(Verbs::HEAD)
+		.send(context);
+}
+
+#ifdef QT_REST_USE_ASYNC
+template<typename TBuilder>
+QFuture<RawRestReply> RawRestBuilder<TBuilder>::sendAsync()
+{
+	Q_ASSERT_X(!d->resultCallback, Q_FUNC_INFO, "Cannot use result callback with sendAsync");
+	QFutureInterface<RawRestReply> fi;
+	fi.reportStarted();
+	onResult([fi](const RawRestReply &reply) mutable {
+		fi.reportFinished(&reply);
+    })
+        .send();
+	return QFuture<RawRestReply>{&fi};
+}
+
+template <typename TBuilder>
+QFuture<RawRestReply> RawRestBuilder<TBuilder>::getAsync()
+{
+	return setVerb(Verbs::GET)
+		.sendAsync();
+}
+
+template <typename TBuilder>
+QFuture<RawRestReply> RawRestBuilder<TBuilder>::postAsync()
+{
+	return setVerb(Verbs::POST)
+		.sendAsync();
+}
+
+template <typename TBuilder>
+QFuture<RawRestReply> RawRestBuilder<TBuilder>::putAsync()
+{
+	return setVerb(Verbs::PUT)
+		.sendAsync();
+}
+
+template <typename TBuilder>
+QFuture<RawRestReply> RawRestBuilder<TBuilder>::deleteResourceAsync()
+{
+	return setVerb(Verbs::DELETE)
+		.sendAsync();
+}
+
+template <typename TBuilder>
+QFuture<RawRestReply> RawRestBuilder<TBuilder>::patchAsync()
+{
+	return setVerb(Verbs::PATCH)
+		.sendAsync();
+}
+
+template <typename TBuilder>
+QFuture<RawRestReply> RawRestBuilder<TBuilder>::headAsync()
+{
+	return setVerb(Verbs::HEAD)
+		.sendAsync();
+}
+#endif
+
+template<typename TBuilder>
+RawRestBuilder<TBuilder>::RawRestBuilder(const QSharedDataPointer<__private::RestBuilderData> &d) :
+	d{d}
+{}
+
+
+
+template <template <class> class... THandlers>
+template <template <class> class THandler, typename... TArgs>
+GenericRestBuilder<THandlers..., THandler> GenericRestBuilder<THandlers...>::addContentTypeHandler(TArgs&&... args)
+{
+	return GenericRestBuilder<THandler>{
+		this->d,
+		std::tuple_cat(_contentHandlerArgs, std::tie(ContentHandlerArgs<THandler>{std::forward<TArgs>(args)...}))
+	};
+}
+
+template <template <class> class... THandlers>
+template <template <class> class THandler, typename T>
+typename GenericRestBuilder<THandlers...>::Builder &GenericRestBuilder<THandlers...>::setBody(T &&body, bool setAccept)
+{
+    using TType = std::decay_t<T>;
+    static_assert (std::disjunction_v<std::is_same<THandler<TType>, THandlers<TType>>...>, "THandler must be one of the registered content handlers");
+    THandler<TType> handler {std::get<ContentHandlerArgs<THandler>>(_contentHandlerArgs)};
+    auto [data, contentType] = handler.write(std::forward<TType>(body));
+    if constexpr (THandler<TType>::IsStringHandler)
+		return setBody(data.toUtf8(), std::move(contentType), setAccept);
+	else
+        return setBody(std::move(data), std::move(contentType), setAccept);
+}
+
+template <template <class> class... THandlers>
+template <template <class> class THandler, typename TContainer>
+typename GenericRestBuilder<THandlers...>::Builder &GenericRestBuilder<THandlers...>::setBodyStream(TContainer data, bool setAccept, bool measureLength)
+{
+	using TType = typename TContainer::value_type;
+	static_assert (std::disjunction_v<std::is_same<THandler<TType>, THandlers<TType>>...>, "THandler must be one of the registered content handlers");
+	static_assert (THandler<TType>::IsStreamingHandler, "THandler must support streamed serialization");
+	THandler<TType> handler {std::get<ContentHandlerArgs<THandler>>(_contentHandlerArgs)};
+	auto [device, contentType] = handler.writeStream(std::move(data));
+	// Qt 5 only streams sequential uploads with a known length, so the body is serialized once up front to measure it.
+	// Compressed uploads drop the length again, measuring them would only serialize the body twice
+	const auto &compression = std::as_const(this->d)->setup->compression;
+	if (measureLength &&
+		!(compression && compression->compressDevices && compression->requestEncoding != Compression::Encoding::Identity)) {
+		this->addHeader(QLatin1String{"Content-Length"}, device->measureSize());
+		this->setAttribute(QNetworkRequest::DoNotBufferUploadDataAttribute, true);
+	}
+	return RawRestBuilder<Builder>::setBody(device, contentType, setAccept);
+}
+
+template <template <class> class... THandlers>
+typename GenericRestBuilder<THandlers...>::Builder &GenericRestBuilder<THandlers...>::onResult(std::function<void(RestReply)> callback)
+{
+	return onResult([args = _contentHandlerArgs, callback](const RawRestReply &reply) {
+		callback(reply.toGeneric<THandlers...>(std::tuple<ContentHandlerArgs<THandlers>...>{args}));
+	});
+}
+
+template <template <class> class... THandlers>
+template <typename T>
+EventSource *GenericRestBuilder<THandlers...>::openEventStream(std::function<void(const ServerSentEvent &, T)> callback, QObject *parent, const QByteArray &dataContentType) const
+{
+	const auto source = RawRestBuilder<Builder>::openEventStream(parent);
+	QObject::connect(source, &EventSource::eventReceived,
+					 source, [decoder = RestReply{std::tuple<ContentHandlerArgs<THandlers>...>{_contentHandlerArgs}},
+							  cb = std::move(callback),
+							  dataContentType](const ServerSentEvent &event) {
+		std::optional<T> data;
+		try {
+			data = decoder.template decode<T>(event.data, dataContentType);
+		} catch (std::exception &e) {
+			qCWarning(logReply) << "Failed to deserialize event data with exception:"
+								<< e.what();
+			return;
+		}
+		cb(event, std::move(*data));
+	});
+	return source;
+}
+
+#ifdef QT_REST_USE_ASYNC
+template <template <class> class... THandlers>
+typename GenericRestBuilder<THandlers...>::Builder &GenericRestBuilder<THandlers...>::onResultAsync(std::function<void(RestReply)> callback)
+{
+	return onResultAsync(QThreadPool::globalInstance(), std::move(callback));
+}
+
+template <template <class> class... THandlers>
+typename GenericRestBuilder<THandlers...>::Builder &GenericRestBuilder<THandlers...>::onResultAsync(QThreadPool *threadPool, std::function<void(RestReply)> callback)
+{
+	return onResult([threadPool, cb = std::move(callback)](RestReply reply) {
+		threadPool->start(new __private::RestReplyRunnable<THandlers...>{cb, std::move(reply)});
+	});
+}
+
+template <template <class> class... THandlers>
+template <typename T>
+typename GenericRestBuilder<THandlers...>::Builder &GenericRestBuilder<THandlers...>::onBodyAsync(QObject *target, std::function<void(RestReply, std::optional<T>)> callback, QThreadPool *threadPool)
+{
+	Q_ASSERT_X(target, Q_FUNC_INFO, "onBodyAsync requires a target object to deliver to");
+	return RawRestBuilder<Builder>::onResult([args = _contentHandlerArgs,
+											  queue = __private::DeliveryQueue::forThread(target->thread()),
+											  target = QPointer<QObject>{target},
+											  threadPool = threadPool ? threadPool : QThreadPool::globalInstance(),
+											  cb = QSharedPointer<const std::function<void(RestReply, std::optional<T>)>>::create(std::move(callback))](RawRestReply raw) {
+		// runs on the thread of the network reply, so the body is drained before it is handed to the pool
+		raw.bufferBody();
+		threadPool->start([reply = raw.toGeneric<THandlers...>(std::tuple<ContentHandlerArgs<THandlers>...>{args}), queue, target, cb]() mutable {
+			std::optional<T> body;
+			if (reply.wasSuccessful() && reply.hasBody()) {
+				try {
+					body = reply.template body<T>();
+				} catch (std::exception &e) {
+					qCWarning(logReply) << "Failed to deserialize reply body with exception:"
+										<< e.what();
+				}
+			}
+			// the thread is resolved per delivery, as the target may have been moved since the request was set up
+			const auto thread = target ? target->thread() : nullptr;
+			if (!thread)
+				return;
+			const auto deliveryQueue = thread == queue->thread() ?
+				queue :
+				__private::DeliveryQueue::forThread(thread);
+			deliveryQueue->post(target, [reply = std::move(reply), body = std::move(body), cb]() mutable {
+				(*cb)(std::move(reply), std::move(body));
+			});
+		});
+	});
+}
+
+template <template <class> class... THandlers>
+QFuture<RestReply<THandlers...>> GenericRestBuilder<THandlers...>::sendAsync()
+{
+	Q_ASSERT_X(!this->d->resultCallback, Q_FUNC_INFO, "Cannot use result callback with sendAsync");
+	QFutureInterface<RestReply> fi;
+	fi.reportStarted();
+	onResult([fi](const RestReply &reply) mutable {
+		fi.reportFinished(&reply);
+    })
+        .send();
+	return QFuture<RestReply>{&fi};
+}
+
+template <template <class> class... THandlers>
+QFuture<RestReply<THandlers...>> GenericRestBuilder<THandlers...>::getAsync()
+{
+	return this->setVerb(Verbs::GET)
+		.sendAsync();
+}
+
+template <template <class> class... THandlers>
+QFuture<RestReply<THandlers...>> GenericRestBuilder<THandlers...>::postAsync()
+{
+	return this->setVerb(Verbs::POST)
+		.sendAsync();
+}
+
+template <template <class> class... THandlers>
+QFuture<RestReply<THandlers...>> GenericRestBuilder<THandlers...>::putAsync()
+{
+	return this->setVerb(Verbs::PUT)
+		.sendAsync();
+}
+
+template <template <class> class... THandlers>
+QFuture<RestReply<THandlers...>> GenericRestBuilder<THandlers...>::deleteResourceAsync()
+{
+	return this->setVerb(Verbs::DELETE)
+		.sendAsync();
+}
+
+template <template <class> class... THandlers>
+QFuture<RestReply<THandlers...>> GenericRestBuilder<THandlers...>::patchAsync()
+{
+	return this->setVerb(Verbs::PATCH)
+		.sendAsync();
+}
+
+template <template <class> class... THandlers>
+QFuture<RestReply<THandlers...>> GenericRestBuilder<THandlers...>::headAsync()
+{
+	return this->setVerb(Verbs::HEAD)
+		.sendAsync();
+}
+#endif
+
+template <template <class> class... THandlers>
+GenericRestBuilder<THandlers...>::GenericRestBuilder(const QSharedDataPointer<__private::RestBuilderData> &d, std::tuple<ContentHandlerArgs<THandlers>...> &&contentHandlerArgs) :
+	RawRestReply{d},
+	_contentHandlerArgs(std::move(contentHandlerArgs))
+{}
+
+}
@@ -0,0 +1,251 @@
+#include "restcache.h"
+#include "bufferednetworkreply.h"
+#include <QtCore/QPointer>
+#include <QtCore/QCryptographicHash>
+using namespace QtRest;
+using namespace QtRest::__private;
+using namespace std::chrono;
+
+RestCache::RestCache(int maxBytes, QObject *parent) :
+	QObject{parent},
+	_entries{maxBytes}
+{}
+
+int RestCache::maxBytes() const
+{
+	return _entries.maxCost();
+}
+
+int RestCache::totalBytes() const
+{
+	return _entries.totalCost();
+}
+
+seconds RestCache::defaultMaxAge() const
+{
+	return _defaultMaxAge;
+}
+
+seconds RestCache::defaultStaleWhileRevalidate() const
+{
+	return _defaultStaleWhileRevalidate;
+}
+
+void RestCache::setMaxBytes(int maxBytes)
+{
+	_entries.setMaxCost(maxBytes);
+}
+
+void RestCache::setDefaultMaxAge(seconds maxAge)
+{
+	_defaultMaxAge = maxAge;
+}
+
+void RestCache::setDefaultStaleWhileRevalidate(seconds staleWhileRevalidate)
+{
+	_defaultStaleWhileRevalidate = staleWhileRevalidate;
+}
+
+QNetworkReply *RestCache::send(const QNetworkRequest &request, const Launcher &launcher)
+{
+	const auto key = cacheKey(request);
+	const auto reply = new BufferedNetworkReply{request};
+	if (const auto entry = find(key, request); entry) {
+		const auto age = duration_cast<seconds>(milliseconds{entry->age.elapsed()});
+		if (age < entry->maxAge) {
+			serve(*entry, reply);
+			return reply;
+		} else if (age < entry->maxAge + entry->staleWhileRevalidate) {
+			serve(*entry, reply);
+			if (!_revalidating.contains(key))
+				revalidate(key, request, launcher, nullptr);
+			return reply;
+		}
+	}
+
+	revalidate(key, request, launcher, reply);
+	return reply;
+}
+
+void RestCache::remove(const QNetworkRequest &request)
+{
+	_entries.remove(cacheKey(request));
+}
+
+void RestCache::clear()
+{
+	_entries.clear();
+}
+
+QByteArray RestCache::cacheKey(const QNetworkRequest &request)
+{
+	auto key = request.url().toEncoded() + '\n' + request.rawHeader("Accept");
+	// responses must never be shared between credentials, only a digest of them is kept
+	if (request.hasRawHeader("Authorization") || request.hasRawHeader("Cookie")) {
+		QCryptographicHash hash{QCryptographicHash::Sha256};
+		hash.addData(request.rawHeader("Authorization"));
+		hash.addData("\n", 1);
+		hash.addData(request.rawHeader("Cookie"));
+		key += '\n' + hash.result().toBase64();
+	}
+	return key;
+}
+
+RestCache::Entry *RestCache::find(const QByteArray &key, const QNetworkRequest &request) const
+{
+	const auto entry = _entries.object(key);
+	if (!entry)
+		return nullptr;
+	// only the latest variant is kept, requests for another one are misses
+	for (const auto &header : qAsConst(entry->varyHeaders)) {
+		if (request.rawHeader(header.first) != header.second)
+			return nullptr;
+	}
+	return entry;
+}
+
+void RestCache::revalidate(const QByteArray &key, const QNetworkRequest &request, const Launcher &launcher, QNetworkReply *target)
+{
+	HeaderMap headers;
+	if (const auto entry = find(key, request); entry) {
+		if (!entry->etag.isEmpty())
+			headers.insert("If-None-Match", entry->etag);
+		if (!entry->lastModified.isEmpty())
+			headers.insert("If-Modified-Since", entry->lastModified);
+	}
+	if (!target)
+		_revalidating.insert(key);
+
+	const auto network = launcher(headers, [self = QPointer<RestCache>{this},
+											key,
+											request,
+											launcher,
+											target = QPointer<BufferedNetworkReply>{static_cast<BufferedNetworkReply*>(target)},
+											isBackground = !target,
+											isConditional = !headers.isEmpty()](RawRestReply reply) {
+		const auto network = reply.reply().toStrongRef();
+		if (!network)
+			return;
+		if (self && isBackground)
+			self->_revalidating.remove(key);
+
+		if (reply.statusCode() == 304 && isConditional && self) {
+			if (self->refresh(key, request, network.data())) {
+				if (target)
+					serve(*self->_entries.object(key), target);
+			} else if (target && !target->isFinished()) {
+				// the entry was evicted while the request was running, so the full response is fetched again
+				self->revalidate(key, request, launcher, target);
+			}
+			return;
+		}
+
+		const auto body = reply.bodyData();
+		if (self && reply.statusCode() == 200)
+			self->store(key, request, network.data(), body);
+		if (target) {
+			target->copyMetaData(network.data());
+			target->finish(body);
+		}
+	});
+	if (target && network)
+		static_cast<BufferedNetworkReply*>(target)->setSource(network);
+}
+
+void RestCache::store(const QByteArray &key, const QNetworkRequest &request, QNetworkReply *reply, const QByteArray &body)
+{
+	if (reply->rawHeader("Cache-Control").toLower().contains("no-store")) {
+		_entries.remove(key);
+		return;
+	}
+
+	auto entry = new Entry{};
+	entry->statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+	entry->reasonPhrase = reply->attribute(QNetworkRequest::HttpReasonPhraseAttribute).toByteArray();
+	entry->headers = reply->rawHeaderPairs();
+	entry->body = body;
+	entry->etag = reply->rawHeader("ETag");
+	entry->lastModified = reply->rawHeader("Last-Modified");
+	readCacheControl(*entry, reply);
+	// without freshness or validators, the entry could never be served
+	if (!readVary(*entry, request, reply) ||
+		(entry->maxAge.count() == 0 && entry->etag.isEmpty() && entry->lastModified.isEmpty())) {
+		delete entry;
+		_entries.remove(key);
+		return;
+	}
+
+	auto cost = entry->body.size();
+	for (const auto &header : qAsConst(entry->headers))
+		cost += header.first.size() + header.second.size();
+	entry->age.start();
+	_entries.insert(key, entry, cost);
+}
+
+bool RestCache::refresh(const QByteArray &key, const QNetworkRequest &request, QNetworkReply *reply)
+{
+	const auto entry = find(key, request);
+	if (!entry)
+		return false;
+
+	for (const auto &header : reply->rawHeaderPairs()) {
+		auto replaced = false;
+		for (auto &oldHeader : entry->headers) {
+			if (oldHeader.first.compare(header.first, Qt::CaseInsensitive) == 0) {
+				oldHeader.second = header.second;
+				replaced = true;
+			}
+		}
+		if (!replaced)
+			entry->headers.append(header);
+	}
+	if (const auto etag = reply->rawHeader("ETag"); !etag.isEmpty())
+		entry->etag = etag;
+	if (const auto lastModified = reply->rawHeader("Last-Modified"); !lastModified.isEmpty())
+		entry->lastModified = lastModified;
+	readCacheControl(*entry, reply);
+	if (reply->hasRawHeader("Vary") && !readVary(*entry, request, reply)) {
+		_entries.remove(key);
+		return false;
+	}
+	entry->age.restart();
+	return true;
+}
+
+void RestCache::readCacheControl(Entry &entry, QNetworkReply *reply) const
+{
+	entry.maxAge = _defaultMaxAge;
+	entry.staleWhileRevalidate = _defaultStaleWhileRevalidate;
+	const auto directives = reply->rawHeader("Cache-Control").toLower().split(',');
+	for (const auto &directive : directives) {
+		const auto args = directive.trimmed().split('=');
+		if (args[0] == "no-cache")
+			entry.maxAge = seconds{0};
+		else if (args[0] == "must-revalidate")
+			entry.staleWhileRevalidate = seconds{0};
+		else if (args.size() == 2 && args[0] == "max-age")
+			entry.maxAge = seconds{args[1].toLongLong()};
+		else if (args.size() == 2 && args[0] == "stale-while-revalidate")
+			entry.staleWhileRevalidate = seconds{args[1].toLongLong()};
+	}
+}
+
+bool RestCache::readVary(Entry &entry, const QNetworkRequest &request, QNetworkReply *reply)
+{
+	entry.varyHeaders.clear();
+	for (const auto &name : reply->rawHeader("Vary").split(',')) {
+		const auto header = name.trimmed();
+		if (header == "*")
+			return false;
+		else if (!header.isEmpty())
+			entry.varyHeaders.append({header, request.rawHeader(header)});
+	}
+	return true;
+}
+
+void RestCache::serve(const Entry &entry, QNetworkReply *target)
+{
+	const auto reply = static_cast<BufferedNetworkReply*>(target);
+	reply->setResponse(entry.statusCode, entry.reasonPhrase, entry.headers);
+	reply->finish(entry.body);
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "qtrest_global.h"
+#include "restreply.h"
+
+#include <chrono>
+#include <functional>
+
+#include <QtCore/QObject>
+#include <QtCore/QCache>
+#include <QtCore/QSet>
+#include <QtCore/QElapsedTimer>
+
+#include <QtNetwork/QNetworkReply>
+
+namespace QtRest {
+
+class QTREST_EXPORT RestCache : public QObject
+{
+	Q_OBJECT
+
+	Q_PROPERTY(int maxBytes READ maxBytes WRITE setMaxBytes)
+	Q_PROPERTY(int totalBytes READ totalBytes STORED false)
+
+public:
+	using Callback = std::function<void(RawRestReply)>;
+	using Launcher = std::function<QNetworkReply*(const HeaderMap &, Callback)>;
+
+	explicit RestCache(int maxBytes = 16 * 1024 * 1024, QObject *parent = nullptr);
+
+	int maxBytes() const;
+	int totalBytes() const;
+	std::chrono::seconds defaultMaxAge() const;
+	std::chrono::seconds defaultStaleWhileRevalidate() const;
+
+	void setMaxBytes(int maxBytes);
+	void setDefaultMaxAge(std::chrono::seconds maxAge);
+	void setDefaultStaleWhileRevalidate(std::chrono::seconds staleWhileRevalidate);
+
+	QNetworkReply *send(const QNetworkRequest &request, const Launcher &launcher);
+	void remove(const QNetworkRequest &request);
+	void clear();
+
+	// explicit Authorization and Cookie headers are part of the key, cookies added by a cookie jar are not
+	static QByteArray cacheKey(const QNetworkRequest &request);
+
+private:
+	struct Entry {
+		int statusCode = 0;
+		QByteArray reasonPhrase;
+		QList<QNetworkReply::RawHeaderPair> headers;
+		QByteArray body;
+		QByteArray etag;
+		QByteArray lastModified;
+		QList<QNetworkReply::RawHeaderPair> varyHeaders;
+		QElapsedTimer age;
+		std::chrono::seconds maxAge;
+		std::chrono::seconds staleWhileRevalidate;
+	};
+
+	QCache<QByteArray, Entry> _entries;
+	QSet<QByteArray> _revalidating;
+	std::chrono::seconds _defaultMaxAge {0};
+	std::chrono::seconds _defaultStaleWhileRevalidate {0};
+
+	Entry *find(const QByteArray &key, const QNetworkRequest &request) const;
+	void revalidate(const QByteArray &key, const QNetworkRequest &request, const Launcher &launcher, QNetworkReply *target);
+	void store(const QByteArray &key, const QNetworkRequest &request, QNetworkReply *reply, const QByteArray &body);
+	bool refresh(const QByteArray &key, const QNetworkRequest &request, QNetworkReply *reply);
+	void readCacheControl(Entry &entry, QNetworkReply *reply) const;
+	static bool readVary(Entry &entry, const QNetworkRequest &request, QNetworkReply *reply);
+	static void serve(const Entry &entry, QNetworkReply *target);
+};
+
+}
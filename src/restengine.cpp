@@ -0,0 +1,59 @@
+#include "restengine.h"
+#include <algorithm>
+using namespace QtRest;
+
+RestEngine::RestEngine(int threadCount, QObject *parent) :
+	QObject{parent}
+{
+	_shards.reserve(std::max(threadCount, 1));
+	for (auto i = 0; i < std::max(threadCount, 1); ++i) {
+		const auto thread = new QThread{this};
+		thread->setObjectName(QStringLiteral("QtRest.Engine.%1").arg(i));
+		const auto nam = new QNetworkAccessManager{};
+		nam->moveToThread(thread);
+		connect(thread, &QThread::finished,
+				nam, &QNetworkAccessManager::deleteLater);
+		thread->start();
+		_shards.append({thread, nam});
+	}
+}
+
+RestEngine::~RestEngine()
+{
+	for (const auto &shard : qAsConst(_shards))
+		shard.thread->quit();
+	for (const auto &shard : qAsConst(_shards))
+		shard.thread->wait();
+}
+
+int RestEngine::threadCount() const
+{
+	return _shards.size();
+}
+
+int RestEngine::shardFor(const QString &host) const
+{
+	return static_cast<int>(qHash(host) % static_cast<uint>(_shards.size()));
+}
+
+QThread *RestEngine::thread(int shard) const
+{
+	return _shards[shard].thread;
+}
+
+void RestEngine::post(const QString &host, Job job) const
+{
+	const auto nam = _shards[shardFor(host)].nam;
+	QMetaObject::invokeMethod(nam, [nam, job = std::move(job)]() {
+		job(nam);
+	}, Qt::QueuedConnection);
+}
+
+void RestEngine::postAll(const Job &job) const
+{
+	for (const auto &shard : _shards) {
+		QMetaObject::invokeMethod(shard.nam, [nam = shard.nam, job]() {
+			job(nam);
+		}, Qt::QueuedConnection);
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "qtrest_global.h"
+
+#include <functional>
+
+#include <QtCore/QObject>
+#include <QtCore/QVector>
+#include <QtCore/QThread>
+
+#include <QtNetwork/QNetworkAccessManager>
+
+namespace QtRest {
+
+class QTREST_EXPORT RestEngine : public QObject
+{
+	Q_OBJECT
+
+	Q_PROPERTY(int threadCount READ threadCount CONSTANT)
+
+public:
+	using Job = std::function<void(QNetworkAccessManager*)>;
+
+	explicit RestEngine(int threadCount = 1, QObject *parent = nullptr);
+	~RestEngine() override;
+
+	int threadCount() const;
+	int shardFor(const QString &host) const;
+	QThread *thread(int shard) const;
+
+	void post(const QString &host, Job job) const;
+	void postAll(const Job &job) const;
+
+private:
+	struct Shard {
+		QThread *thread;
+		QNetworkAccessManager *nam;
+	};
+
+	QVector<Shard> _shards;
+};
+
+}
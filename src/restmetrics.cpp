@@ -0,0 +1,417 @@
+#include "restmetrics.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include <QtCore/QHash>
+#include <QtCore/QGlobalStatic>
+#include <QtCore/QRegularExpression>
+using namespace QtRest;
+using namespace QtRest::__private;
+using namespace std::chrono;
+
+namespace QtRest::__private {
+
+struct MetricsCounter
+{
+	std::atomic<quint64> value {0};
+
+	// replies may complete on another thread than the one that tracked them
+	inline void add(quint64 count) {
+		value.fetch_add(count, std::memory_order_relaxed);
+	}
+	inline quint64 load() const {
+		return value.load(std::memory_order_relaxed);
+	}
+};
+
+struct EndpointKey
+{
+	QString host;
+	QByteArray verb;
+	QString route;
+
+	inline bool operator==(const EndpointKey &other) const {
+		return host == other.host && verb == other.verb && route == other.route;
+	}
+};
+
+inline uint qHash(const EndpointKey &key, uint seed = 0)
+{
+	return ::qHash(key.host, seed) ^ ::qHash(key.verb, seed) ^ ::qHash(key.route, seed + 1);
+}
+
+struct EndpointShard
+{
+	EndpointKey key;
+	MetricsCounter requests;
+	MetricsCounter completed;
+	std::array<MetricsCounter, 6> statusClasses;
+	MetricsCounter bytesSent;
+	MetricsCounter bytesReceived;
+	MetricsCounter latencySum;
+	std::array<MetricsCounter, LatencyHistogram::BucketCount> latency;
+};
+
+struct MetricsShard
+{
+	// the lookup is only touched by the owning thread, snapshots read the endpoint list
+	QHash<EndpointKey, EndpointShard*> lookup;
+	QMutex mutex;
+	std::vector<std::unique_ptr<EndpointShard>> endpoints;
+	// the owning thread and the recorder of every pending reply, unused shards are folded into the retired totals
+	QAtomicInt users = 1;
+
+	EndpointShard *endpoint(const EndpointKey &key);
+};
+
+struct LocalShard
+{
+	QSharedPointer<MetricsShard> shard;
+
+	inline ~LocalShard() {
+		shard->users.deref();
+	}
+};
+
+void mergeEndpoint(EndpointMetrics &metrics, const EndpointShard &endpoint)
+{
+	metrics.host = endpoint.key.host;
+	metrics.verb = endpoint.key.verb;
+	metrics.route = endpoint.key.route;
+	// relaxed reads may see a completion before its request, which must not yield a negative gauge
+	const auto completed = endpoint.completed.load();
+	metrics.completed += completed;
+	metrics.requests += std::max(endpoint.requests.load(), completed);
+	for (auto i = 0; i < static_cast<int>(metrics.statusClasses.size()); ++i)
+		metrics.statusClasses[i] += endpoint.statusClasses[i].load();
+	metrics.bytesSent += endpoint.bytesSent.load();
+	metrics.bytesReceived += endpoint.bytesReceived.load();
+	for (auto i = 0; i < LatencyHistogram::BucketCount; ++i) {
+		if (const auto count = endpoint.latency[i].load(); count > 0)
+			metrics.latency.addBucket(i, count);
+	}
+	metrics.latency.addSum(microseconds{static_cast<microseconds::rep>(endpoint.latencySum.load())});
+}
+
+}
+
+Q_GLOBAL_STATIC(RestMetrics, globalMetrics)
+
+int LatencyHistogram::bucketFor(quint64 micros)
+{
+	if (micros < SubBucketCount)
+		return static_cast<int>(micros);
+
+	const auto magnitude = std::min(63 - static_cast<int>(qCountLeadingZeroBits(micros)), MaxMagnitude - 1);
+	const auto shift = magnitude - SubBucketBits;
+	const auto subBucket = std::min<quint64>((micros >> shift) - SubBucketCount, SubBucketCount - 1);
+	return SubBucketCount + shift * SubBucketCount + static_cast<int>(subBucket);
+}
+
+quint64 LatencyHistogram::bucketUpperBound(int bucket)
+{
+	if (bucket < SubBucketCount)
+		return static_cast<quint64>(bucket) + 1;
+
+	const auto shift = (bucket - SubBucketCount) / SubBucketCount;
+	const auto subBucket = (bucket - SubBucketCount) % SubBucketCount;
+	return static_cast<quint64>(SubBucketCount + subBucket + 1) << shift;
+}
+
+LatencyHistogram::LatencyHistogram() :
+	_buckets(BucketCount, 0)
+{}
+
+void LatencyHistogram::record(quint64 micros, quint64 count)
+{
+	addBucket(bucketFor(micros), count);
+	_sum += micros * count;
+}
+
+void LatencyHistogram::addBucket(int bucket, quint64 count)
+{
+	_buckets[bucket] += count;
+	_count += count;
+}
+
+void LatencyHistogram::addSum(microseconds sum)
+{
+	_sum += static_cast<quint64>(sum.count());
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+	for (auto i = 0; i < BucketCount; ++i)
+		_buckets[i] += other._buckets[i];
+	_count += other._count;
+	_sum += other._sum;
+}
+
+quint64 LatencyHistogram::count() const
+{
+	return _count;
+}
+
+microseconds LatencyHistogram::sum() const
+{
+	return microseconds{static_cast<microseconds::rep>(_sum)};
+}
+
+microseconds LatencyHistogram::percentile(double percentile) const
+{
+	if (_count == 0)
+		return microseconds::zero();
+
+	const auto rank = std::max<quint64>(static_cast<quint64>(std::ceil(std::clamp(percentile, 0.0, 1.0) * _count)), 1);
+	quint64 seen = 0;
+	for (auto i = 0; i < BucketCount; ++i) {
+		seen += _buckets[i];
+		if (seen >= rank)
+			return microseconds{static_cast<microseconds::rep>(bucketUpperBound(i))};
+	}
+	return microseconds{static_cast<microseconds::rep>(bucketUpperBound(BucketCount - 1))};
+}
+
+const QVector<quint64> &LatencyHistogram::buckets() const
+{
+	return _buckets;
+}
+
+
+
+qint64 EndpointMetrics::inFlight() const
+{
+	return static_cast<qint64>(requests - completed);
+}
+
+
+
+namespace {
+
+QByteArray escapeLabel(const QByteArray &value)
+{
+	auto escaped = value;
+	escaped.replace('\\', "\\\\");
+	escaped.replace('"', "\\\"");
+	escaped.replace('\n', "\\n");
+	return escaped;
+}
+
+QByteArray formatSeconds(quint64 micros)
+{
+	return QByteArray::number(static_cast<double>(micros) / 1000000.0, 'g', 12);
+}
+
+}
+
+QByteArray MetricsSnapshot::toPrometheus(const QByteArray &prefix) const
+{
+	QByteArray requests;
+	QByteArray inFlight;
+	QByteArray bytesSent;
+	QByteArray bytesReceived;
+	QByteArray duration;
+	for (const auto &endpoint : endpoints) {
+		const auto labels = "host=\"" + escapeLabel(endpoint.host.toUtf8()) +
+							"\",verb=\"" + escapeLabel(endpoint.verb) +
+							"\",route=\"" + escapeLabel(endpoint.route.toUtf8()) + '"';
+
+		for (auto i = 0; i < static_cast<int>(endpoint.statusClasses.size()); ++i) {
+			if (endpoint.statusClasses[i] == 0)
+				continue;
+			requests += prefix + "_requests_total{" + labels +
+						",status=\"" + (i == 0 ? QByteArray{"error"} : QByteArray::number(i) + "xx") + "\"} " +
+						QByteArray::number(endpoint.statusClasses[i]) + '\n';
+		}
+		inFlight += prefix + "_requests_in_flight{" + labels + "} " + QByteArray::number(endpoint.inFlight()) + '\n';
+		bytesSent += prefix + "_sent_bytes_total{" + labels + "} " + QByteArray::number(endpoint.bytesSent) + '\n';
+		bytesReceived += prefix + "_received_bytes_total{" + labels + "} " + QByteArray::number(endpoint.bytesReceived) + '\n';
+
+		// the fine grained buckets are folded into one bucket per power of two
+		const auto &buckets = endpoint.latency.buckets();
+		auto last = LatencyHistogram::BucketCount - 1;
+		while (last > 0 && buckets[last] == 0)
+			--last;
+		quint64 cumulative = 0;
+		for (auto i = 0; i <= last; ++i) {
+			cumulative += buckets[i];
+			if ((i + 1) % LatencyHistogram::SubBucketCount == 0 || i == last) {
+				duration += prefix + "_request_duration_seconds_bucket{" + labels +
+							",le=\"" + formatSeconds(LatencyHistogram::bucketUpperBound(i)) + "\"} " +
+							QByteArray::number(cumulative) + '\n';
+			}
+		}
+		duration += prefix + "_request_duration_seconds_bucket{" + labels + ",le=\"+Inf\"} " + QByteArray::number(endpoint.latency.count()) + '\n';
+		duration += prefix + "_request_duration_seconds_sum{" + labels + "} " + formatSeconds(static_cast<quint64>(endpoint.latency.sum().count())) + '\n';
+		duration += prefix + "_request_duration_seconds_count{" + labels + "} " + QByteArray::number(endpoint.latency.count()) + '\n';
+	}
+
+	return "# HELP " + prefix + "_requests_total Completed requests by status class.\n"
+		   "# TYPE " + prefix + "_requests_total counter\n" + requests +
+		   "# HELP " + prefix + "_requests_in_flight Requests that were sent but did not finish yet.\n"
+		   "# TYPE " + prefix + "_requests_in_flight gauge\n" + inFlight +
+		   "# HELP " + prefix + "_sent_bytes_total Request body bytes sent.\n"
+		   "# TYPE " + prefix + "_sent_bytes_total counter\n" + bytesSent +
+		   "# HELP " + prefix + "_received_bytes_total Response body bytes received.\n"
+		   "# TYPE " + prefix + "_received_bytes_total counter\n" + bytesReceived +
+		   "# HELP " + prefix + "_request_duration_seconds Time from sending a request until it finished.\n"
+		   "# TYPE " + prefix + "_request_duration_seconds histogram\n" + duration;
+}
+
+
+
+RestMetrics::RestMetrics(QObject *parent) :
+	QObject{parent}
+{}
+
+RestMetrics::~RestMetrics() = default;
+
+RestMetrics *RestMetrics::instance()
+{
+	return globalMetrics;
+}
+
+QString RestMetrics::routeTemplate(const QString &path)
+{
+	static const QRegularExpression uuidRegex{QStringLiteral(R"__(^[0-9a-fA-F]{8}-[0-9a-fA-F]{4}-[0-9a-fA-F]{4}-[0-9a-fA-F]{4}-[0-9a-fA-F]{12}$)__")};
+	auto segments = path.split(QLatin1Char('/'));
+	for (auto &segment : segments) {
+		auto isNumber = false;
+		segment.toULongLong(&isNumber);
+		if (isNumber)
+			segment = QStringLiteral("{id}");
+		else if (uuidRegex.match(segment).hasMatch())
+			segment = QStringLiteral("{uuid}");
+	}
+	return segments.join(QLatin1Char('/'));
+}
+
+void RestMetrics::track(QNetworkReply *reply, const QString &host, const QByteArray &verb, const QString &route)
+{
+	const auto shard = localShard();
+	const auto endpoint = shard->endpoint(EndpointKey{host, verb, route});
+	endpoint->requests.add(1);
+	new MetricsRecorder{reply, shard, endpoint};
+}
+
+MetricsSnapshot RestMetrics::snapshot() const
+{
+	QHash<EndpointKey, EndpointMetrics> merged;
+	{
+		QMutexLocker lock{&_mutex};
+		for (const auto &metrics : _retired)
+			merged.insert(EndpointKey{metrics.host, metrics.verb, metrics.route}, metrics);
+		for (const auto &shard : _shards) {
+			QMutexLocker shardLock{&shard->mutex};
+			for (const auto &endpoint : shard->endpoints)
+				mergeEndpoint(merged[endpoint->key], *endpoint);
+		}
+	}
+
+	MetricsSnapshot snapshot;
+	snapshot.endpoints.reserve(merged.size());
+	for (auto &metrics : merged)
+		snapshot.endpoints.append(std::move(metrics));
+	return snapshot;
+}
+
+QByteArray RestMetrics::toPrometheus(const QByteArray &prefix) const
+{
+	return snapshot().toPrometheus(prefix);
+}
+
+QSharedPointer<MetricsShard> RestMetrics::localShard()
+{
+	if (!_localShard.hasLocalData()) {
+		const auto local = new LocalShard{QSharedPointer<MetricsShard>::create()};
+		QMutexLocker lock{&_mutex};
+		// threads only come and go with new shards, so this keeps the list at the threads in use
+		retireShards();
+		_shards.append(local->shard);
+		_localShard.setLocalData(local);
+	}
+	return _localShard.localData()->shard;
+}
+
+void RestMetrics::retireShards()
+{
+	for (auto it = _shards.begin(); it != _shards.end();) {
+		// an unused shard cannot be written to anymore, as only its finished thread could track new replies
+		if ((*it)->users.loadAcquire() != 0) {
+			++it;
+			continue;
+		}
+
+		QMutexLocker shardLock{&(*it)->mutex};
+		for (const auto &endpoint : (*it)->endpoints) {
+			const auto retired = std::find_if(_retired.begin(), _retired.end(), [&](const EndpointMetrics &metrics) {
+				return EndpointKey{metrics.host, metrics.verb, metrics.route} == endpoint->key;
+			});
+			if (retired != _retired.end())
+				mergeEndpoint(*retired, *endpoint);
+			else {
+				_retired.append(EndpointMetrics{});
+				mergeEndpoint(_retired.last(), *endpoint);
+			}
+		}
+		shardLock.unlock();
+		it = _shards.erase(it);
+	}
+}
+
+
+
+EndpointShard *MetricsShard::endpoint(const EndpointKey &key)
+{
+	if (const auto it = lookup.constFind(key); it != lookup.constEnd())
+		return *it;
+
+	auto endpoint = std::make_unique<EndpointShard>();
+	endpoint->key = key;
+	const auto result = endpoint.get();
+	{
+		QMutexLocker lock{&mutex};
+		endpoints.push_back(std::move(endpoint));
+	}
+	lookup.insert(key, result);
+	return result;
+}
+
+MetricsRecorder::MetricsRecorder(QNetworkReply *reply, QSharedPointer<MetricsShard> shard, EndpointShard *endpoint) :
+	QObject{reply},
+	_shard{std::move(shard)},
+	_endpoint{endpoint}
+{
+	_shard->users.ref();
+	_timer.start();
+	connect(reply, &QNetworkReply::uploadProgress,
+			this, [this](qint64 bytesSent, qint64) {
+				_bytesSent = bytesSent;
+			});
+	connect(reply, &QNetworkReply::downloadProgress,
+			this, [this](qint64 bytesReceived, qint64) {
+				_bytesReceived = bytesReceived;
+			});
+	connect(reply, &QNetworkReply::finished,
+			this, &MetricsRecorder::complete);
+}
+
+MetricsRecorder::~MetricsRecorder()
+{
+	_shard->users.deref();
+}
+
+void MetricsRecorder::complete()
+{
+	const auto reply = static_cast<QNetworkReply*>(parent());
+	const auto status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+	const auto micros = static_cast<quint64>(_timer.nsecsElapsed() / 1000);
+	_endpoint->statusClasses[status >= 100 && status < 600 ? status / 100 : 0].add(1);
+	_endpoint->bytesSent.add(static_cast<quint64>(std::max<qint64>(_bytesSent, 0)));
+	_endpoint->bytesReceived.add(static_cast<quint64>(std::max<qint64>(_bytesReceived, 0)));
+	_endpoint->latencySum.add(micros);
+	_endpoint->latency[LatencyHistogram::bucketFor(micros)].add(1);
+	_endpoint->completed.add(1);
+}
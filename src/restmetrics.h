@@ -0,0 +1,126 @@
+#pragma once
+
+#include "qtrest_global.h"
+
+#include <array>
+#include <chrono>
+
+#include <QtCore/QObject>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QVector>
+#include <QtCore/QMutex>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QThreadStorage>
+
+#include <QtNetwork/QNetworkReply>
+
+namespace QtRest {
+
+class QTREST_EXPORT LatencyHistogram
+{
+public:
+	// log-linear buckets with 16 linear steps per power of two, as used by HDR histograms
+	static constexpr int SubBucketBits = 4;
+	static constexpr int SubBucketCount = 1 << SubBucketBits;
+	static constexpr int MaxMagnitude = 36;
+	static constexpr int BucketCount = SubBucketCount + (MaxMagnitude - SubBucketBits) * SubBucketCount;
+
+	static int bucketFor(quint64 micros);
+	static quint64 bucketUpperBound(int bucket);
+
+	LatencyHistogram();
+
+	void record(quint64 micros, quint64 count = 1);
+	void addBucket(int bucket, quint64 count);
+	void addSum(std::chrono::microseconds sum);
+	void merge(const LatencyHistogram &other);
+
+	quint64 count() const;
+	std::chrono::microseconds sum() const;
+	std::chrono::microseconds percentile(double percentile) const;
+	const QVector<quint64> &buckets() const;
+
+private:
+	QVector<quint64> _buckets;
+	quint64 _count = 0;
+	quint64 _sum = 0;
+};
+
+struct QTREST_EXPORT EndpointMetrics
+{
+	QString host;
+	QByteArray verb;
+	QString route;
+
+	quint64 requests = 0;
+	quint64 completed = 0;
+	// index 0 counts replies without a status code, 1 to 5 the status classes 1xx to 5xx
+	std::array<quint64, 6> statusClasses {};
+	quint64 bytesSent = 0;
+	quint64 bytesReceived = 0;
+	LatencyHistogram latency;
+
+	qint64 inFlight() const;
+};
+
+struct QTREST_EXPORT MetricsSnapshot
+{
+	QVector<EndpointMetrics> endpoints;
+
+	QByteArray toPrometheus(const QByteArray &prefix = "qtrest") const;
+};
+
+namespace __private {
+
+struct MetricsShard;
+struct EndpointShard;
+struct LocalShard;
+
+class QTREST_EXPORT MetricsRecorder : public QObject
+{
+	Q_OBJECT
+
+public:
+	MetricsRecorder(QNetworkReply *reply, QSharedPointer<MetricsShard> shard, EndpointShard *endpoint);
+	~MetricsRecorder() override;
+
+private:
+	QSharedPointer<MetricsShard> _shard;
+	EndpointShard *_endpoint;
+	QElapsedTimer _timer;
+	qint64 _bytesSent = 0;
+	qint64 _bytesReceived = 0;
+
+	void complete();
+};
+
+}
+
+class QTREST_EXPORT RestMetrics : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit RestMetrics(QObject *parent = nullptr);
+	~RestMetrics() override;
+
+	static RestMetrics *instance();
+	// replaces numeric and UUID path segments by {id} and {uuid}, so resources of the same kind share one series
+	static QString routeTemplate(const QString &path);
+
+	void track(QNetworkReply *reply, const QString &host, const QByteArray &verb, const QString &route);
+	MetricsSnapshot snapshot() const;
+	QByteArray toPrometheus(const QByteArray &prefix = "qtrest") const;
+
+private:
+	mutable QMutex _mutex;
+	QVector<QSharedPointer<__private::MetricsShard>> _shards;
+	// totals of shards whose thread has finished
+	QVector<EndpointMetrics> _retired;
+	QThreadStorage<__private::LocalShard*> _localShard;
+
+	QSharedPointer<__private::MetricsShard> localShard();
+	void retireShards();
+};
+
+}
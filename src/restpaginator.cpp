@@ -0,0 +1,235 @@
+#include "restpaginator.h"
+#include <algorithm>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QJsonArray>
+using namespace QtRest;
+
+QUrl Pagination::findLink(const QString &header, const QString &relation)
+{
+	// <url>; rel="next", <url>; rel="last" - urls may contain commas, so the header is walked instead of split
+	auto pos = 0;
+	while ((pos = header.indexOf(QLatin1Char('<'), pos)) >= 0) {
+		const auto urlEnd = header.indexOf(QLatin1Char('>'), pos);
+		if (urlEnd < 0)
+			break;
+		auto paramsEnd = header.indexOf(QLatin1Char('<'), urlEnd);
+		if (paramsEnd < 0)
+			paramsEnd = header.size();
+
+		const auto params = header.midRef(urlEnd + 1, paramsEnd - urlEnd - 1).split(QLatin1Char(';'));
+		for (const auto &param : params) {
+			const auto args = param.split(QLatin1Char('='));
+			if (args.size() != 2 || args[0].trimmed().compare(QLatin1String("rel"), Qt::CaseInsensitive) != 0)
+				continue;
+			auto rels = args[1].trimmed();
+			if (rels.endsWith(QLatin1Char(',')))
+				rels.chop(1);
+			if (rels.startsWith(QLatin1Char('"')) && rels.endsWith(QLatin1Char('"')))
+				rels = rels.mid(1, rels.size() - 2);
+			for (const auto &rel : rels.split(QLatin1Char(' '), Qt::SkipEmptyParts)) {
+				if (rel.compare(relation, Qt::CaseInsensitive) == 0)
+					return QUrl{header.mid(pos + 1, urlEnd - pos - 1).trimmed()};
+			}
+		}
+		pos = paramsEnd;
+	}
+	return {};
+}
+
+QJsonValue Pagination::findField(const QJsonValue &value, const QString &path)
+{
+	auto current = value;
+	for (const auto &key : path.split(QLatin1Char('.'), Qt::SkipEmptyParts)) {
+		if (!current.isObject())
+			return QJsonValue::Undefined;
+		current = current.toObject().value(key);
+	}
+	return current;
+}
+
+
+
+int Paginator::pagesDelivered() const
+{
+	return _nextDelivery;
+}
+
+qint64 Paginator::totalCount() const
+{
+	return _totalCount;
+}
+
+bool Paginator::isFinished() const
+{
+	return _finished;
+}
+
+void Paginator::cancel()
+{
+	finish();
+}
+
+Paginator::Paginator(Pagination pagination) :
+	_pagination{std::move(pagination)}
+{
+	_pagination.maxInFlight = std::max(_pagination.maxInFlight, 1);
+	_pagination.limit = std::max<qint64>(_pagination.limit, 1);
+}
+
+void Paginator::start()
+{
+	_pendingRequest = _pagination.mode == Pagination::Mode::OffsetLimit ?
+		offsetRequest(0) :
+		PageRequest{};
+	launchNext();
+}
+
+void Paginator::pageReceived(int index, RawRestReply &reply)
+{
+	_inFlight.remove(index);
+	if (_finished)
+		return;
+
+	// the body is read for the next page before the consumer gets to it
+	reply.bufferBody();
+	if (reply.wasSuccessful())
+		readNext(index, reply);
+	else
+		_lastIndex = _lastIndex < 0 ? index : std::min(_lastIndex, index);
+	_ready.insert(index);
+
+	// the next request goes out before the consumer processes this page
+	launchNext();
+	deliverReady();
+}
+
+Paginator::PageRequest Paginator::offsetRequest(int index) const
+{
+	PageRequest request;
+	request.query.addQueryItem(_pagination.offsetParameter, QString::number(_pagination.startOffset + index * _pagination.limit));
+	request.query.addQueryItem(_pagination.limitParameter, QString::number(_pagination.limit));
+	return request;
+}
+
+void Paginator::readNext(int index, RawRestReply &reply)
+{
+	std::optional<QJsonValue> json;
+	const auto body = [&]() -> const QJsonValue & {
+		if (!json) {
+			try {
+				if (auto streamed = reply.streamedJson(); streamed)
+					json = *streamed;
+			} catch (std::exception &) {}
+			if (!json) {
+				const auto document = QJsonDocument::fromJson(reply.bodyData());
+				json = document.isArray() ? QJsonValue{document.array()} : QJsonValue{document.object()};
+			}
+		}
+		return *json;
+	};
+
+	if (_totalCount < 0) {
+		if (const auto header = reply.header(QLatin1String{_pagination.totalCountHeader}); !header.isEmpty())
+			_totalCount = header.toLongLong();
+		else if (_pagination.mode != Pagination::Mode::Link && !_pagination.totalCountField.isEmpty()) {
+			if (const auto total = Pagination::findField(body(), _pagination.totalCountField); total.isDouble())
+				_totalCount = static_cast<qint64>(total.toDouble());
+		}
+	}
+
+	switch (_pagination.mode) {
+	case Pagination::Mode::Link:
+		if (const auto url = Pagination::findLink(reply.header(QLatin1String{"Link"}), _pagination.linkRelation); url.isValid())
+			_pendingRequest = PageRequest{reply.reply().toStrongRef()->url().resolved(url), {}};
+		else
+			_lastIndex = index;
+		break;
+	case Pagination::Mode::Cursor: {
+		const auto cursor = Pagination::findField(body(), _pagination.cursorField).toVariant().toString();
+		if (cursor.isEmpty())
+			_lastIndex = index;
+		else {
+			PageRequest request;
+			request.query.addQueryItem(_pagination.cursorParameter, cursor);
+			_pendingRequest = std::move(request);
+		}
+		break;
+	}
+	case Pagination::Mode::OffsetLimit:
+		if (_lastIndex >= 0)
+			break;
+		else if (_totalCount >= 0) {
+			// with a known total all remaining pages can be requested in parallel
+			const auto remaining = std::max<qint64>(_totalCount - _pagination.startOffset, 0);
+			_lastIndex = std::max(static_cast<int>((remaining + _pagination.limit - 1) / _pagination.limit) - 1, index);
+			_pendingRequest.reset();
+		} else {
+			const auto items = _pagination.itemsField.isEmpty() ?
+				body() :
+				Pagination::findField(body(), _pagination.itemsField);
+			if (items.toArray().size() < _pagination.limit)
+				_lastIndex = index;
+			else
+				_pendingRequest = offsetRequest(index + 1);
+		}
+		break;
+	}
+}
+
+void Paginator::launchNext()
+{
+	while (!_finished &&
+		   (_lastIndex < 0 || _nextLaunch <= _lastIndex) &&
+		   (_pagination.maxPages < 0 || _nextLaunch < _pagination.maxPages) &&
+		   _inFlight.size() + _ready.size() < _pagination.maxInFlight) {
+		PageRequest request;
+		if (_pagination.mode == Pagination::Mode::OffsetLimit && _lastIndex >= 0)
+			request = offsetRequest(_nextLaunch);
+		else if (_pendingRequest)
+			request = *std::exchange(_pendingRequest, std::nullopt);
+		else
+			break;
+
+		const auto index = _nextLaunch++;
+		_inFlight.insert(index, launch(index, request));
+	}
+}
+
+void Paginator::deliverReady()
+{
+	// consumers that spin the event loop must not receive pages out of order
+	if (_delivering)
+		return;
+
+	_delivering = true;
+	while (!_finished && _ready.remove(_nextDelivery)) {
+		if (!deliver(_nextDelivery++))
+			finish();
+		else
+			launchNext();
+	}
+	_delivering = false;
+
+	if ((_inFlight.isEmpty() && _ready.isEmpty()) ||
+		(_lastIndex >= 0 && _nextDelivery > _lastIndex))
+		finish();
+}
+
+void Paginator::finish()
+{
+	if (_finished)
+		return;
+
+	_finished = true;
+	_pendingRequest.reset();
+	const auto inFlight = std::exchange(_inFlight, {});
+	for (const auto &reply : inFlight) {
+		if (reply)
+			reply->abort();
+	}
+	_ready.clear();
+	clearPages();
+	emit finished();
+	deleteLater();
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "restbuilder_decl.h"
+
+#include <functional>
+#include <optional>
+
+#include <QtCore/QObject>
+#include <QtCore/QPointer>
+#include <QtCore/QHash>
+#include <QtCore/QSet>
+#include <QtCore/QUrl>
+#include <QtCore/QUrlQuery>
+#include <QtCore/QJsonValue>
+
+namespace QtRest {
+
+struct QTREST_EXPORT Pagination
+{
+	enum class Mode {
+		Link,
+		Cursor,
+		OffsetLimit
+	};
+
+	Mode mode = Mode::Link;
+	QString linkRelation = QStringLiteral("next");
+	QString cursorParameter = QStringLiteral("cursor");
+	QString cursorField = QStringLiteral("next_cursor");
+	QString offsetParameter = QStringLiteral("offset");
+	QString limitParameter = QStringLiteral("limit");
+	qint64 startOffset = 0;
+	qint64 limit = 100;
+	QByteArray totalCountHeader = "X-Total-Count";
+	QString totalCountField = QStringLiteral("total");
+	QString itemsField;
+	int maxInFlight = 4;
+	int maxPages = -1;
+
+	static QUrl findLink(const QString &header, const QString &relation);
+	static QJsonValue findField(const QJsonValue &value, const QString &path);
+};
+
+class QTREST_EXPORT Paginator : public QObject
+{
+	Q_OBJECT
+
+	Q_PROPERTY(int pagesDelivered READ pagesDelivered)
+	Q_PROPERTY(qint64 totalCount READ totalCount)
+	Q_PROPERTY(bool finished READ isFinished NOTIFY finished)
+
+public:
+	int pagesDelivered() const;
+	qint64 totalCount() const;
+	bool isFinished() const;
+
+public Q_SLOTS:
+	void cancel();
+
+Q_SIGNALS:
+	void finished();
+
+protected:
+	struct PageRequest {
+		QUrl url;
+		QUrlQuery query;
+	};
+
+	explicit Paginator(Pagination pagination);
+
+	void start();
+	void pageReceived(int index, RawRestReply &reply);
+
+	virtual QNetworkReply *launch(int index, const PageRequest &request) = 0;
+	virtual bool deliver(int index) = 0;
+	virtual void clearPages() = 0;
+
+private:
+	Pagination _pagination;
+	QHash<int, QPointer<QNetworkReply>> _inFlight;
+	QSet<int> _ready;
+	std::optional<PageRequest> _pendingRequest;
+	int _nextLaunch = 0;
+	int _nextDelivery = 0;
+	int _lastIndex = -1;
+	qint64 _totalCount = -1;
+	bool _delivering = false;
+	bool _finished = false;
+
+	PageRequest offsetRequest(int index) const;
+	void readNext(int index, RawRestReply &reply);
+	void launchNext();
+	void deliverReady();
+	void finish();
+};
+
+namespace __private {
+
+template <typename TBuilder>
+class PageFetcher : public Paginator
+{
+public:
+	using Reply = typename TBuilder::Reply;
+	using PageHandler = std::function<bool(Reply)>;
+
+	PageFetcher(TBuilder builder, Pagination pagination, PageHandler handler) :
+		Paginator{std::move(pagination)},
+		_builder{std::move(builder)},
+		_handler{std::move(handler)}
+	{
+		start();
+	}
+
+protected:
+	QNetworkReply *launch(int index, const PageRequest &request) override {
+		auto builder = _builder;
+		if (request.url.isValid())
+			builder.updateFromRelativeUrl(request.url);
+		return builder.addParameters(request.query)
+			.onResult([this, index](const Reply &reply) {
+				auto page = reply;
+				_pages.insert(index, page);
+				pageReceived(index, page);
+			}).send(this);
+	}
+
+	bool deliver(int index) override {
+		// typed replies are not default constructible, hence the optional
+		return _handler(std::move(*_pages.take(index)));
+	}
+
+	void clearPages() override {
+		_pages.clear();
+	}
+
+private:
+	TBuilder _builder;
+	PageHandler _handler;
+	QHash<int, std::optional<Reply>> _pages;
+};
+
+}
+
+template <typename TBuilder>
+Paginator *paginate(TBuilder builder, Pagination pagination, std::function<bool(typename TBuilder::Reply)> onPage)
+{
+	return new __private::PageFetcher<TBuilder>{std::move(builder), std::move(pagination), std::move(onPage)};
+}
+
+}
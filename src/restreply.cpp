@@ -1,159 +1,290 @@
-#include "restreply.h"
-#include <optional>
-#include <QtCore/QThread>
-using namespace QtRest;
-
-Q_LOGGING_CATEGORY(QtRest::logReply, "qtrest.RestReply", QtInfoMsg)
-
-namespace QtRest {
-
-void deleteReplyLater(QNetworkReply *reply)
-{
-	QMetaObject::invokeMethod(reply, "deleteLater", Qt::AutoConnection);
-}
-
-class RestReplyData : public QSharedData
-{
-public:
-	QSharedPointer<QNetworkReply> reply;
-
-	mutable std::optional<int> statusCode = std::nullopt;
-	mutable std::optional<qint64> contentLength = std::nullopt;
-	mutable std::optional<QByteArray> contentType = std::nullopt;
-	mutable QTextCodec *contentCodec = nullptr;
-
-	void parseContentType();
-};
-
-}
-
-RawRestReply::RawRestReply(QNetworkReply *reply) :
-	d{new RestReplyData{}}
-{
-	d->reply = QSharedPointer<QNetworkReply>{reply, deleteReplyLater};
-}
-
-RawRestReply::RawRestReply(const RawRestReply &other) = default;
-
-RawRestReply::RawRestReply(RawRestReply &&other) noexcept = default;
-
-RawRestReply &RawRestReply::operator=(const RawRestReply &other) = default;
-
-RawRestReply &RawRestReply::operator=(RawRestReply &&other) noexcept = default;
-
-RawRestReply::~RawRestReply() = default;
-
-bool RawRestReply::hasHeader(const QLatin1String &name) const
-{
-	return d->reply->hasRawHeader(name.latin1());
-}
-
-QString RawRestReply::header(const QLatin1String &name) const
-{
-	return QString::fromLatin1(d->reply->rawHeader(name.latin1()));
-}
-
-QVariant RawRestReply::attribute(QNetworkRequest::Attribute attribute) const
-{
-	return d->reply->attribute(attribute);
-}
-
-bool RawRestReply::hasBody()
-{
-	if (statusCode() == 204)  // NO_CONTENT
-		return false;
-	if (contentLength() > 0)
-		return true;
-	else
-		return d->reply->bytesAvailable() > 0 || d->reply->pos() > 0;
-}
-
-QIODevice *RawRestReply::bodyDevice() const
-{
-	return d->reply.data();
-}
-
-QByteArray RawRestReply::bodyData()
-{
-	return d->reply->readAll();
-}
-
-QString RawRestReply::bodyString()
-{
-	if (const auto codec = contentCodec(); codec)
-		return codec->toUnicode(bodyData());
-	else
-		return QString::fromUtf8(bodyData());
-}
-
-bool RawRestReply::wasSuccessful() const
-{
-	return error() == QNetworkReply::NoError && statusCode() < 300;
-}
-
-int RawRestReply::statusCode() const
-{
-	if (!d->statusCode)
-		d->statusCode = d->reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-	return *d->statusCode;
-}
-
-QNetworkReply::NetworkError RawRestReply::error() const
-{
-	return d->reply->error();
-}
-
-QByteArray RawRestReply::contentType() const
-{
-	if (!d->contentType)
-		d->parseContentType();
-	return *d->contentType;
-}
-
-QTextCodec *RawRestReply::contentCodec() const
-{
-	if (!d->contentType)
-		d->parseContentType();
-	return d->contentCodec;
-}
-
-qint64 RawRestReply::contentLength() const
-{
-	if (!d->contentLength) {
-		auto ok = false;
-		d->contentLength = d->reply->header(QNetworkRequest::ContentLengthHeader).toLongLong(&ok);
-		if (!ok)
-			d->contentLength = -1;
-	}
-	return *d->contentLength;
-}
-
-QWeakPointer<QNetworkReply> RawRestReply::reply() const
-{
-	return d->reply;
-}
-
-RawRestReply RawRestReply::clone() const
-{
-	RawRestReply copy {*this};
-	copy.d.detach();
-	return copy;
-}
-
-void RestReplyData::parseContentType()
-{
-	contentCodec = nullptr;
-	contentType = reply->header(QNetworkRequest::ContentTypeHeader).toByteArray().trimmed();
-	if (const auto cList = contentType->split(';'); cList.size() > 1) {
-		contentType = cList.first().trimmed();
-		for (auto i = 1; i < cList.size(); ++i) {
-			auto args = cList[i].trimmed().split('=');
-			if (args.size() == 2 && args[0] == "charset") {
-				contentCodec = QTextCodec::codecForName(args[1]);
-				if (!contentCodec)
-					throw UnsupportedCodecException{args[1]};
-			} else
-				qCWarning(logReply) << "Unknown content type directive:" << args[0];
-		}
-	}
-}
+#include "restreply.h"
+#include "jsonstreamreader.h"
+#include "ndjsonbodystream.h"
+#include "bufferednetworkreply.h"
+#include <optional>
+#include <QtCore/QThread>
+using namespace QtRest;
+
+Q_LOGGING_CATEGORY(QtRest::logReply, "qtrest.RestReply", QtInfoMsg)
+
+namespace QtRest {
+
+void deleteReplyLater(QNetworkReply *reply)
+{
+	QMetaObject::invokeMethod(reply, "deleteLater", Qt::AutoConnection);
+}
+
+class RestReplyData : public QSharedData
+{
+public:
+	QSharedPointer<QNetworkReply> reply;
+
+	mutable std::optional<int> statusCode = std::nullopt;
+	mutable std::optional<qint64> contentLength = std::nullopt;
+	mutable std::optional<QByteArray> contentType = std::nullopt;
+	mutable QTextCodec *contentCodec = nullptr;
+	std::optional<QByteArray> body = std::nullopt;
+	mutable std::optional<__private::TimingRecorder*> timingRecorder = std::nullopt;
+
+	// filled by bufferBody(), afterwards the accessors only read these instead of the reply
+	std::optional<__private::BufferedNetworkReply::MetaData> metaData = std::nullopt;
+	std::optional<QJsonValue> streamedJson = std::nullopt;
+	QString streamedJsonError;
+	std::optional<qint64> streamedItems = std::nullopt;
+	QString streamedItemsError;
+
+	void parseContentType();
+	const QByteArray *findHeader(const QByteArray &name) const;
+};
+
+}
+
+RawRestReply::RawRestReply(QNetworkReply *reply) :
+	d{new RestReplyData{}}
+{
+	d->reply = QSharedPointer<QNetworkReply>{reply, deleteReplyLater};
+}
+
+RawRestReply::RawRestReply(const RawRestReply &other) = default;
+
+RawRestReply::RawRestReply(RawRestReply &&other) noexcept = default;
+
+RawRestReply &RawRestReply::operator=(const RawRestReply &other) = default;
+
+RawRestReply &RawRestReply::operator=(RawRestReply &&other) noexcept = default;
+
+RawRestReply::~RawRestReply() = default;
+
+bool RawRestReply::hasHeader(const QLatin1String &name) const
+{
+	if (d->metaData)
+		return d->findHeader(name.latin1());
+	else
+		return d->reply->hasRawHeader(name.latin1());
+}
+
+QString RawRestReply::header(const QLatin1String &name) const
+{
+	if (d->metaData) {
+		const auto value = d->findHeader(name.latin1());
+		return value ? QString::fromLatin1(*value) : QString{};
+	} else
+		return QString::fromLatin1(d->reply->rawHeader(name.latin1()));
+}
+
+QVariant RawRestReply::attribute(QNetworkRequest::Attribute attribute) const
+{
+	if (d->metaData)
+		return d->metaData->attributes.value(attribute);
+	else
+		return d->reply->attribute(attribute);
+}
+
+bool RawRestReply::hasBody()
+{
+	if (statusCode() == 204)  // NO_CONTENT
+		return false;
+	if (contentLength() > 0)
+		return true;
+	else if (d->body)
+		return !d->body->isEmpty();
+	else
+		return d->reply->bytesAvailable() > 0 || d->reply->pos() > 0;
+}
+
+QIODevice *RawRestReply::bodyDevice() const
+{
+	return d->reply.data();
+}
+
+QByteArray RawRestReply::bodyData()
+{
+	if (d->body)
+		return *d->body;
+	else {
+		// stream readers parse the body as it arrives and do not retain the raw bytes
+		if (__private::BodyStreamReader::hasConsumed(d->reply.data()))
+			qCWarning(logReply) << "The body of" << d->reply->url()
+								<< "was consumed by a body stream - bodyData() and bodyString() only return the unread remainder";
+		return d->reply->readAll();
+	}
+}
+
+void RawRestReply::bufferBody()
+{
+	if (d->body)
+		return;
+
+	// everything the accessors need is read here, so the reply can be used from another thread afterwards
+	d->body = d->reply->readAll();
+	d->metaData = __private::BufferedNetworkReply::readMetaData(d->reply.data());
+	statusCode();
+	contentLength();
+	timingRecorder();
+	try {
+		d->parseContentType();
+	} catch (Exception &) {
+		d->contentType.reset();
+	}
+
+	if (const auto stream = __private::BodyStreamReader::find<__private::JsonBodyStream>(d->reply.data());
+		stream && stream->state() == __private::BodyStreamReader::State::Finished) {
+		if (stream->reader().hasError())
+			d->streamedJsonError = stream->reader().errorString();
+		else
+			d->streamedJson = stream->reader().result();
+	}
+	if (const auto stream = __private::BodyStreamReader::find<__private::NdjsonBodyStream>(d->reply.data());
+		stream && stream->state() == __private::BodyStreamReader::State::Finished) {
+		if (stream->hasError())
+			d->streamedItemsError = stream->errorString();
+		else
+			d->streamedItems = stream->itemCount();
+	}
+}
+
+QString RawRestReply::bodyString()
+{
+	if (const auto codec = contentCodec(); codec)
+		return codec->toUnicode(bodyData());
+	else
+		return QString::fromUtf8(bodyData());
+}
+
+std::optional<QJsonValue> RawRestReply::streamedJson() const
+{
+	if (d->metaData) {
+		if (!d->streamedJsonError.isNull())
+			throw InvalidBodyException{contentType(), d->streamedJsonError};
+		return d->streamedJson;
+	}
+
+	const auto stream = __private::BodyStreamReader::find<__private::JsonBodyStream>(d->reply.data());
+	if (!stream || stream->state() != __private::BodyStreamReader::State::Finished)
+		return std::nullopt;
+	else if (stream->reader().hasError())
+		throw InvalidBodyException{contentType(), stream->reader().errorString()};
+	else
+		return stream->reader().result();
+}
+
+std::optional<qint64> RawRestReply::streamedItems() const
+{
+	if (d->metaData) {
+		if (!d->streamedItemsError.isNull())
+			throw InvalidBodyException{contentType(), d->streamedItemsError};
+		return d->streamedItems;
+	}
+
+	const auto stream = __private::BodyStreamReader::find<__private::NdjsonBodyStream>(d->reply.data());
+	if (!stream || stream->state() != __private::BodyStreamReader::State::Finished)
+		return std::nullopt;
+	else if (stream->hasError())
+		throw InvalidBodyException{contentType(), stream->errorString()};
+	else
+		return stream->itemCount();
+}
+
+std::optional<RequestTiming> RawRestReply::timing() const
+{
+	if (const auto recorder = timingRecorder(); recorder)
+		return recorder->timing();
+	else
+		return std::nullopt;
+}
+
+bool RawRestReply::wasSuccessful() const
+{
+	return error() == QNetworkReply::NoError && statusCode() < 300;
+}
+
+int RawRestReply::statusCode() const
+{
+	if (!d->statusCode)
+		d->statusCode = attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+	return *d->statusCode;
+}
+
+QNetworkReply::NetworkError RawRestReply::error() const
+{
+	if (d->metaData)
+		return d->metaData->error;
+	else
+		return d->reply->error();
+}
+
+QByteArray RawRestReply::contentType() const
+{
+	if (!d->contentType)
+		d->parseContentType();
+	return *d->contentType;
+}
+
+QTextCodec *RawRestReply::contentCodec() const
+{
+	if (!d->contentType)
+		d->parseContentType();
+	return d->contentCodec;
+}
+
+qint64 RawRestReply::contentLength() const
+{
+	if (!d->contentLength) {
+		auto ok = false;
+		d->contentLength = d->reply->header(QNetworkRequest::ContentLengthHeader).toLongLong(&ok);
+		if (!ok)
+			d->contentLength = -1;
+	}
+	return *d->contentLength;
+}
+
+QWeakPointer<QNetworkReply> RawRestReply::reply() const
+{
+	return d->reply;
+}
+
+RawRestReply RawRestReply::clone() const
+{
+	RawRestReply copy {*this};
+	copy.d.detach();
+	return copy;
+}
+
+__private::TimingRecorder *RawRestReply::timingRecorder() const
+{
+	if (!d->timingRecorder)
+		d->timingRecorder = __private::TimingRecorder::find(d->reply.data());
+	return *d->timingRecorder;
+}
+
+void RestReplyData::parseContentType()
+{
+	contentCodec = nullptr;
+	if (metaData) {
+		const auto header = findHeader("Content-Type");
+		contentType = header ? header->trimmed() : QByteArray{};
+	} else
+		contentType = reply->header(QNetworkRequest::ContentTypeHeader).toByteArray().trimmed();
+	if (const auto cList = contentType->split(';'); cList.size() > 1) {
+		contentType = cList.first().trimmed();
+		for (auto i = 1; i < cList.size(); ++i) {
+			auto args = cList[i].trimmed().split('=');
+			if (args.size() == 2 && args[0] == "charset") {
+				contentCodec = QTextCodec::codecForName(args[1]);
+				if (!contentCodec)
+					throw UnsupportedCodecException{args[1]};
+			} else
+				qCWarning(logReply) << "Unknown content type directive:" << args[0];
+		}
+	}
+}
+
+const QByteArray *RestReplyData::findHeader(const QByteArray &name) const
+{
+	for (const auto &header : metaData->headers) {
+		if (header.first.compare(name, Qt::CaseInsensitive) == 0)
+			return &header.second;
+	}
+	return nullptr;
+}
@@ -1,169 +1,261 @@
-#pragma once
-
-#include "qtrest_global.h"
-#include "qtrest_exceptions.h"
-#include "contenthandler.h"
-
-#include <tuple>
-#include <variant>
-
-#include <QtCore/QObject>
-#include <QtCore/QByteArray>
-#include <QtCore/QTextCodec>
-#include <QtCore/QExplicitlySharedDataPointer>
-#include <QtCore/QLoggingCategory>
-#include <QtCore/QSharedPointer>
-
-#include <QtNetwork/QNetworkReply>
-
-namespace QtRest {
-
-Q_DECLARE_LOGGING_CATEGORY(logReply)
-
-template <template<class> class... THandlers>
-class RestReply;
-
-class RestReplyData;
-class QTREST_EXPORT RawRestReply
-{
-	Q_GADGET
-
-	Q_PROPERTY(bool successful READ wasSuccessful STORED false CONSTANT)
-	Q_PROPERTY(int statusCode READ statusCode CONSTANT)
-	Q_PROPERTY(QNetworkReply::NetworkError error READ error CONSTANT)
-	Q_PROPERTY(QByteArray contentType READ contentType CONSTANT)
-	Q_PROPERTY(QTextCodec contentCodec READ contentCodec CONSTANT)
-	Q_PROPERTY(qint64 contentLength READ contentLength CONSTANT)
-
-	Q_PROPERTY(QWeakPointer<QNetworkReply> reply READ reply CONSTANT)
-
-public:
-	RawRestReply(QNetworkReply *reply = nullptr);
-	RawRestReply(const RawRestReply &other);
-	RawRestReply(RawRestReply &&other) noexcept;
-	RawRestReply &operator=(const RawRestReply &other);
-	RawRestReply &operator=(RawRestReply &&other) noexcept;
-	~RawRestReply();
-
-	Q_INVOKABLE bool hasHeader(const QLatin1String &name) const;
-	Q_INVOKABLE QString header(const QLatin1String &name) const;
-	template <typename T>
-	inline T header(const QLatin1String &name) const {
-		return QVariant{header(name)}.template value<T>();
-	}
-
-	Q_INVOKABLE QVariant attribute(QNetworkRequest::Attribute attrib) const;
-	template <typename T>
-	inline T attribute(QNetworkRequest::Attribute attrib) const {
-		return attribute(attrib).template value<T>();
-	}
-
-	Q_INVOKABLE bool hasBody();
-	Q_INVOKABLE QIODevice *bodyDevice() const;
-	Q_INVOKABLE QByteArray bodyData();
-	Q_INVOKABLE QString bodyString();
-
-	bool wasSuccessful() const;
-	int statusCode() const;
-	QNetworkReply::NetworkError error() const;
-	QByteArray contentType() const;
-	QTextCodec *contentCodec() const;
-	qint64 contentLength() const;
-	QWeakPointer<QNetworkReply> reply() const;
-
-	template <template<class> class... THandlers>
-	inline RestReply<THandlers...> toGeneric(ContentHandlerArgs<THandlers>... args) const {
-		return RestReply<THandlers...>{std::make_tuple(std::move(args)...), *this};
-	}
-
-	template <template<class> class... THandlers>
-	inline RestReply<THandlers...> toGeneric(std::tuple<ContentHandlerArgs<THandlers>...> &&args) const {
-		return RestReply<THandlers...>{std::move(args), *this};
-	}
-
-	RawRestReply clone() const;
-
-protected:
-	QExplicitlySharedDataPointer<RestReplyData> d;
-};
-
-template <template<class> class... THandlers>
-class RestReply : public RawRestReply
-{
-private:
-	friend class RawRestReply;
-
-	template <typename T>
-	using HandlerVariant = std::variant<THandlers<T>...>;
-
-public:
-	RestReply(std::tuple<ContentHandlerArgs<THandlers>...> &&args, QNetworkReply *reply = nullptr) :
-		RawRestReply{reply},
-		_initArgs{std::move(args)}
-	{}
-
-	template <typename T>
-	T body() {
-		auto handler = findHandler<T, THandlers...>();
-		return std::visit([this](auto &handler) -> T {
-			if constexpr (std::decay_t<decltype(handler)>::IsStringHandler)
-				return handler.read(this->bodyString(), this->contentType());
-			else
-				return handler.read(this->bodyData(), this->contentType(), this->contentCodec());
-		}, handler);
-	}
-
-	template <typename TResult, typename TError>
-	TResult evaluate() {
-		if (this->wasSuccessful())
-			return this->body<TResult>();
-		else {
-			std::optional<TError> error = std::nullopt;
-			if (this->hasBody()) {
-				try {
-					error = this->body<TError>();
-				} catch (std::exception &e) {
-					qCWarning(logReply) << "Failed to deserialized request error with exception:"
-										<< e.what();
-				}
-			}
-
-			throw RequestFailedException<TError> {
-				this->statusCode(),
-				this->error(),
-				std::move(error)
-			};
-		}
-	}
-
-	RestReply<THandlers...> clone() const {
-		RestReply<THandlers...> copy{*this};
-		copy.d.detach();
-		return copy;
-	}
-
-private:
-	std::tuple<ContentHandlerArgs<THandlers>...> _initArgs;
-
-	RestReply(ContentHandlerArgs<THandlers>... args, const RawRestReply &base) :
-		RawRestReply{base},
-		_initArgs{std::make_tuple(std::move(args)...)}
-	{}
-
-	template <typename T>
-	HandlerVariant<T> findHandler() const {
-		throw MissingContentHandlerException{this->contentType()};
-	}
-
-	template <typename T, template<class> class THandler, template<class> class... TOthers>
-	HandlerVariant<T> findHandler() const {
-		THandler<T> handler(std::get<ContentHandlerArgs<THandler>>(_initArgs));
-		if (handler.contentTypes().contains(this->contentType()))
-			return std::move(handler);
-		else
-			return findHandler<T, TOthers...>();
-	}
-};
-
-}
-
+#pragma once
+
+#include "qtrest_global.h"
+#include "qtrest_exceptions.h"
+#include "contenthandler.h"
+#include "requesttiming.h"
+#include "resttracer.h"
+
+#include <tuple>
+#include <utility>
+#include <type_traits>
+#include <variant>
+#include <optional>
+
+#include <QtCore/QObject>
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QTextCodec>
+#include <QtCore/QExplicitlySharedDataPointer>
+#include <QtCore/QLoggingCategory>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QJsonValue>
+#include <QtCore/QScopeGuard>
+
+#include <QtNetwork/QNetworkReply>
+
+namespace QtRest {
+
+Q_DECLARE_LOGGING_CATEGORY(logReply)
+
+namespace __private {
+
+template <typename TArgs, typename = void>
+struct HasStaticContentType : std::false_type {};
+
+template <typename TArgs>
+struct HasStaticContentType<TArgs, std::void_t<decltype(TArgs::ContentType)>> : std::true_type {};
+
+}
+
+template <template<class> class... THandlers>
+class RestReply;
+
+class RestReplyData;
+class QTREST_EXPORT RawRestReply
+{
+	Q_GADGET
+
+	Q_PROPERTY(bool successful READ wasSuccessful STORED false CONSTANT)
+	Q_PROPERTY(int statusCode READ statusCode CONSTANT)
+	Q_PROPERTY(QNetworkReply::NetworkError error READ error CONSTANT)
+	Q_PROPERTY(QByteArray contentType READ contentType CONSTANT)
+	Q_PROPERTY(QTextCodec contentCodec READ contentCodec CONSTANT)
+	Q_PROPERTY(qint64 contentLength READ contentLength CONSTANT)
+
+	Q_PROPERTY(QWeakPointer<QNetworkReply> reply READ reply CONSTANT)
+
+public:
+	RawRestReply(QNetworkReply *reply = nullptr);
+	RawRestReply(const RawRestReply &other);
+	RawRestReply(RawRestReply &&other) noexcept;
+	RawRestReply &operator=(const RawRestReply &other);
+	RawRestReply &operator=(RawRestReply &&other) noexcept;
+	~RawRestReply();
+
+	Q_INVOKABLE bool hasHeader(const QLatin1String &name) const;
+	Q_INVOKABLE QString header(const QLatin1String &name) const;
+	template <typename T>
+	inline T header(const QLatin1String &name) const {
+		return QVariant{header(name)}.template value<T>();
+	}
+
+	Q_INVOKABLE QVariant attribute(QNetworkRequest::Attribute attrib) const;
+	template <typename T>
+	inline T attribute(QNetworkRequest::Attribute attrib) const {
+		return attribute(attrib).template value<T>();
+	}
+
+	Q_INVOKABLE bool hasBody();
+	Q_INVOKABLE QIODevice *bodyDevice() const;
+	// with streamJsonBody() or onItem() the body is parsed while it arrives, so these return only the unread remainder
+	Q_INVOKABLE QByteArray bodyData();
+	void bufferBody();
+	Q_INVOKABLE QString bodyString();
+	std::optional<QJsonValue> streamedJson() const;
+	std::optional<qint64> streamedItems() const;
+	std::optional<RequestTiming> timing() const;
+
+	bool wasSuccessful() const;
+	int statusCode() const;
+	QNetworkReply::NetworkError error() const;
+	QByteArray contentType() const;
+	QTextCodec *contentCodec() const;
+	qint64 contentLength() const;
+	QWeakPointer<QNetworkReply> reply() const;
+
+	template <template<class> class... THandlers>
+	inline RestReply<THandlers...> toGeneric(ContentHandlerArgs<THandlers>... args) const {
+		return RestReply<THandlers...>{std::make_tuple(std::move(args)...), *this};
+	}
+
+	template <template<class> class... THandlers>
+	inline RestReply<THandlers...> toGeneric(std::tuple<ContentHandlerArgs<THandlers>...> &&args) const {
+		return RestReply<THandlers...>{std::move(args), *this};
+	}
+
+	RawRestReply clone() const;
+
+protected:
+	QExplicitlySharedDataPointer<RestReplyData> d;
+
+	__private::TimingRecorder *timingRecorder() const;
+};
+
+template <template<class> class... THandlers>
+class RestReply : public RawRestReply
+{
+private:
+	friend class RawRestReply;
+
+	template <typename T>
+	using HandlerVariant = std::variant<THandlers<T>...>;
+
+public:
+	RestReply(std::tuple<ContentHandlerArgs<THandlers>...> &&args, QNetworkReply *reply = nullptr) :
+		RawRestReply{reply},
+		_initArgs{std::move(args)}
+	{}
+
+	template <typename T>
+	T body() {
+		auto handler = findHandler<T>(this->contentType());
+		const RestTracer::Span span{"deserialize", RestTracer::isEnabled() ? this->reply().toStrongRef().data() : nullptr};
+		const auto recorder = this->timingRecorder();
+		if (recorder)
+			recorder->beginDeserialize();
+		// failed reads are timed as well
+		const auto endDeserialize = qScopeGuard([recorder]() {
+			if (recorder)
+				recorder->endDeserialize();
+		});
+		return std::visit([this](auto &handler) -> T {
+			if constexpr (std::decay_t<decltype(handler)>::IsJsonValueHandler) {
+				if (auto value = this->streamedJson(); value)
+					return handler.readValue(*value);
+			}
+			if constexpr (std::decay_t<decltype(handler)>::IsStringHandler)
+				return handler.read(this->bodyString(), this->contentType());
+			else
+				return handler.read(this->bodyData(), this->contentType(), this->contentCodec());
+		}, handler);
+	}
+
+	template <typename T>
+	T decode(const QByteArray &data, const QByteArray &contentType, QTextCodec *codec = nullptr) const {
+		auto handler = findHandler<T>(contentType);
+		return std::visit([&](auto &handler) -> T {
+			if constexpr (std::decay_t<decltype(handler)>::IsStringHandler)
+				return handler.read(codec ? codec->toUnicode(data) : QString::fromUtf8(data), contentType);
+			else
+				return handler.read(data, contentType, codec);
+		}, handler);
+	}
+
+	template <typename TResult, typename TError>
+	TResult evaluate() {
+		if (this->wasSuccessful())
+			return this->body<TResult>();
+		else {
+			std::optional<TError> error = std::nullopt;
+			if (this->hasBody()) {
+				try {
+					error = this->body<TError>();
+				} catch (std::exception &e) {
+					qCWarning(logReply) << "Failed to deserialized request error with exception:"
+										<< e.what();
+				}
+			}
+
+			throw RequestFailedException<TError> {
+				this->statusCode(),
+				this->error(),
+				std::move(error)
+			};
+		}
+	}
+
+	RestReply<THandlers...> clone() const {
+		RestReply<THandlers...> copy{*this};
+		copy.d.detach();
+		return copy;
+	}
+
+private:
+	std::tuple<ContentHandlerArgs<THandlers>...> _initArgs;
+
+	RestReply(ContentHandlerArgs<THandlers>... args, const RawRestReply &base) :
+		RawRestReply{base},
+		_initArgs{std::make_tuple(std::move(args)...)}
+	{}
+
+	template <typename T>
+	HandlerVariant<T> findHandler(const QByteArray &contentType) const {
+		if constexpr (HasContentTypeTable) {
+			const auto &table = contentTypeTable();
+			if (const auto it = table.constFind(contentType); it != table.constEnd())
+				return createHandler<T>(*it, std::index_sequence_for<THandlers...>{});
+			else  // handlers can accept more types via contentTypes() than their static one
+				return searchHandler<T, THandlers...>(contentType);
+		} else
+			return searchHandler<T, THandlers...>(contentType);
+	}
+
+	// handlers with a static content type are dispatched via a table that is built once per handler set,
+	// misses fall back to asking every handler for its contentTypes()
+	static constexpr bool HasContentTypeTable = (__private::HasStaticContentType<ContentHandlerArgs<THandlers>>::value && ...);
+
+	static const QHash<QByteArray, int> &contentTypeTable() {
+		static const auto table = []() {
+			QHash<QByteArray, int> table;
+			auto index = 0;
+			const auto addContentType = [&](const QByteArray &contentType) {
+				if (!table.contains(contentType))
+					table.insert(contentType, index);
+				++index;
+			};
+			(addContentType(ContentHandlerArgs<THandlers>::ContentType), ...);
+			return table;
+		}();
+		return table;
+	}
+
+	template <typename T, std::size_t... TIndex>
+	HandlerVariant<T> createHandler(int index, std::index_sequence<TIndex...>) const {
+		using Factory = HandlerVariant<T>(*)(const std::tuple<ContentHandlerArgs<THandlers>...> &);
+		static constexpr Factory factories[] = {&RestReply::makeHandler<T, TIndex>...};
+		return factories[index](_initArgs);
+	}
+
+	template <typename T, std::size_t TIndex>
+	static HandlerVariant<T> makeHandler(const std::tuple<ContentHandlerArgs<THandlers>...> &args) {
+		return HandlerVariant<T>{std::in_place_index<TIndex>, std::get<TIndex>(args)};
+	}
+
+	template <typename T>
+	HandlerVariant<T> searchHandler(const QByteArray &contentType) const {
+		throw MissingContentHandlerException{contentType};
+	}
+
+	template <typename T, template<class> class THandler, template<class> class... TOthers>
+	HandlerVariant<T> searchHandler(const QByteArray &contentType) const {
+		THandler<T> handler(std::get<ContentHandlerArgs<THandler>>(_initArgs));
+		if (handler.contentTypes().contains(contentType))
+			return std::move(handler);
+		else
+			return searchHandler<T, TOthers...>(contentType);
+	}
+};
+
+}
+
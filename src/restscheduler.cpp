@@ -0,0 +1,130 @@
+#include "restscheduler.h"
+#include <algorithm>
+#include <QtCore/QPointer>
+using namespace QtRest;
+
+RestScheduler::RestScheduler(QObject *parent) :
+	QObject{parent}
+{}
+
+int RestScheduler::hostBudget() const
+{
+	return _hostBudget;
+}
+
+int RestScheduler::backgroundBudget() const
+{
+	return _backgroundBudget;
+}
+
+int RestScheduler::queuedCount() const
+{
+	auto count = 0;
+	for (const auto &lane : _lanes) {
+		for (const auto &queue : lane.queues)
+			count += queue.size();
+	}
+	return count;
+}
+
+int RestScheduler::activeCount(const QString &host) const
+{
+	return _active.value(host);
+}
+
+void RestScheduler::enqueue(const QString &host, Priority priority, const QString &tenant, Job job)
+{
+	auto &lane = _lanes[static_cast<int>(priority)];
+	auto &queue = lane.queues[tenant];
+	if (queue.isEmpty())
+		lane.tenants.append(tenant);
+	queue.enqueue(Entry{host, std::move(job)});
+	dispatch();
+}
+
+QNetworkRequest::Priority RestScheduler::requestPriority(Priority priority)
+{
+	switch (priority) {
+	case Priority::Background:
+		return QNetworkRequest::LowPriority;
+	case Priority::Normal:
+		return QNetworkRequest::NormalPriority;
+	case Priority::Interactive:
+		return QNetworkRequest::HighPriority;
+	default:
+		Q_UNREACHABLE();
+	}
+}
+
+void RestScheduler::setHostBudget(int hostBudget)
+{
+	_hostBudget = std::max(hostBudget, 1);
+	dispatch();
+}
+
+void RestScheduler::setBackgroundBudget(int backgroundBudget)
+{
+	_backgroundBudget = std::max(backgroundBudget, 1);
+	dispatch();
+}
+
+void RestScheduler::dispatch()
+{
+	// jobs may release synchronously, which would otherwise recurse into the lane iteration
+	if (_dispatching) {
+		_redispatch = true;
+		return;
+	}
+
+	_dispatching = true;
+	do {
+		_redispatch = false;
+		for (auto priority = static_cast<int>(Priority::Interactive); priority >= 0; --priority) {
+			const auto budget = priority == static_cast<int>(Priority::Background) ?
+				std::min(_backgroundBudget, _hostBudget) :
+				_hostBudget;
+			while (dispatchLane(_lanes[priority], budget));
+		}
+	} while (_redispatch);
+	_dispatching = false;
+}
+
+bool RestScheduler::dispatchLane(Lane &lane, int budget)
+{
+	// round robin over the tenants, taking the first request of each tenant whose host has a free slot
+	for (auto tried = 0; tried < lane.tenants.size(); ++tried) {
+		lane.next %= lane.tenants.size();
+		const auto tenant = lane.tenants[lane.next];
+		auto &queue = lane.queues[tenant];
+		const auto it = std::find_if(queue.begin(), queue.end(), [&](const Entry &entry) {
+			return _active.value(entry.host) < budget;
+		});
+		if (it == queue.end()) {
+			++lane.next;
+			continue;
+		}
+
+		auto entry = std::move(*it);
+		queue.erase(it);
+		if (queue.isEmpty()) {
+			lane.queues.remove(tenant);
+			lane.tenants.removeAt(lane.next);
+		} else
+			++lane.next;
+
+		++_active[entry.host];
+		entry.job([self = QPointer<RestScheduler>{this}, host = entry.host]() {
+			if (self)
+				self->release(host);
+		});
+		return true;
+	}
+	return false;
+}
+
+void RestScheduler::release(const QString &host)
+{
+	if (const auto it = _active.find(host); it != _active.end() && --(*it) <= 0)
+		_active.erase(it);
+	dispatch();
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "qtrest_global.h"
+
+#include <array>
+#include <functional>
+
+#include <QtCore/QObject>
+#include <QtCore/QHash>
+#include <QtCore/QQueue>
+#include <QtCore/QStringList>
+
+#include <QtNetwork/QNetworkRequest>
+
+namespace QtRest {
+
+class QTREST_EXPORT RestScheduler : public QObject
+{
+	Q_OBJECT
+
+	Q_PROPERTY(int hostBudget READ hostBudget WRITE setHostBudget)
+	Q_PROPERTY(int backgroundBudget READ backgroundBudget WRITE setBackgroundBudget)
+
+public:
+	enum class Priority {
+		Background = 0,
+		Normal = 1,
+		Interactive = 2
+	};
+	Q_ENUM(Priority)
+
+	using Release = std::function<void()>;
+	using Job = std::function<void(Release)>;
+
+	explicit RestScheduler(QObject *parent = nullptr);
+
+	int hostBudget() const;
+	int backgroundBudget() const;
+	int queuedCount() const;
+	int activeCount(const QString &host) const;
+
+	void enqueue(const QString &host, Priority priority, const QString &tenant, Job job);
+
+	static QNetworkRequest::Priority requestPriority(Priority priority);
+
+public Q_SLOTS:
+	void setHostBudget(int hostBudget);
+	void setBackgroundBudget(int backgroundBudget);
+
+private:
+	struct Entry {
+		QString host;
+		Job job;
+	};
+
+	struct Lane {
+		QHash<QString, QQueue<Entry>> queues;
+		QStringList tenants;
+		int next = 0;
+	};
+
+	int _hostBudget = 6;
+	int _backgroundBudget = 2;
+	std::array<Lane, 3> _lanes;
+	QHash<QString, int> _active;
+	bool _dispatching = false;
+	bool _redispatch = false;
+
+	void dispatch();
+	bool dispatchLane(Lane &lane, int budget);
+	void release(const QString &host);
+};
+
+}
@@ -0,0 +1,348 @@
+#include "resttracer.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QVector>
+#include <QtCore/QThread>
+#include <QtCore/QGlobalStatic>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QRandomGenerator>
+using namespace QtRest;
+using namespace QtRest::__private;
+
+namespace {
+
+// the fields are atomic so readers may race with the writer, the sequence tells them if what they read is consistent
+struct TraceSlot
+{
+	// position + 1 of the stored event, 0 while the slot is being written
+	std::atomic<quint64> sequence {0};
+	std::atomic<const char*> name {nullptr};
+	std::atomic<qint64> begin {0};
+	std::atomic<qint64> duration {-1};
+	std::atomic<quint64> requestId {0};
+	std::atomic<quint64> spanId {0};
+};
+
+struct TraceRing
+{
+	TraceRing(int capacity, int index, QString threadName) :
+		entries{new TraceSlot[static_cast<size_t>(capacity)]},
+		capacity{static_cast<quint64>(capacity)},
+		index{index},
+		threadName{std::move(threadName)}
+	{}
+
+	const std::unique_ptr<TraceSlot[]> entries;
+	const quint64 capacity;
+	const int index;
+	const QString threadName;
+	std::atomic<quint64> head {0};
+	std::atomic<quint64> clearedAt {0};
+
+	// only the owning thread writes, so the slot fields need no read-modify-write
+	inline void push(const RestTracer::Event &event) {
+		const auto position = head.load(std::memory_order_relaxed);
+		auto &slot = entries[position % capacity];
+		slot.sequence.store(0, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		slot.name.store(event.name, std::memory_order_relaxed);
+		slot.begin.store(event.begin, std::memory_order_relaxed);
+		slot.duration.store(event.duration, std::memory_order_relaxed);
+		slot.requestId.store(event.requestId, std::memory_order_relaxed);
+		slot.spanId.store(event.spanId, std::memory_order_relaxed);
+		slot.sequence.store(position + 1, std::memory_order_release);
+		head.store(position + 1, std::memory_order_release);
+	}
+
+	// fails if the slot no longer holds the event at position or was written to while reading it
+	inline bool read(quint64 position, RestTracer::Event &event) const {
+		const auto &slot = entries[position % capacity];
+		if (slot.sequence.load(std::memory_order_acquire) != position + 1)
+			return false;
+		event.name = slot.name.load(std::memory_order_relaxed);
+		event.begin = slot.begin.load(std::memory_order_relaxed);
+		event.duration = slot.duration.load(std::memory_order_relaxed);
+		event.requestId = slot.requestId.load(std::memory_order_relaxed);
+		event.spanId = slot.spanId.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return slot.sequence.load(std::memory_order_relaxed) == position + 1;
+	}
+};
+
+struct TraceRegistry
+{
+	QMutex mutex;
+	QVector<std::shared_ptr<TraceRing>> rings;
+	int lastIndex = 0;
+
+	// rings of finished threads are only referenced by the registry and can go once nothing new can be read from them
+	void reclaim(const QHash<TraceRing*, quint64> &readUpTo = {});
+};
+
+Q_GLOBAL_STATIC(TraceRegistry, traceRegistry)
+
+std::atomic<bool> tracingEnabled {false};
+std::atomic<int> traceBufferSize {8192};
+std::atomic<quint64> traceRequestCounter {0};
+thread_local std::shared_ptr<TraceRing> localRing;
+
+TraceRing *currentRing()
+{
+	if (!localRing) {
+		const auto thread = QThread::currentThread();
+		auto threadName = thread ? thread->objectName() : QString{};
+		QMutexLocker lock{&traceRegistry->mutex};
+		const auto index = ++traceRegistry->lastIndex;
+		if (threadName.isEmpty())
+			threadName = QStringLiteral("Thread %1").arg(index);
+		localRing = std::make_shared<TraceRing>(traceBufferSize.load(std::memory_order_relaxed), index, std::move(threadName));
+		traceRegistry->rings.append(localRing);
+	}
+	return localRing.get();
+}
+
+void TraceRegistry::reclaim(const QHash<TraceRing*, quint64> &readUpTo)
+{
+	rings.erase(std::remove_if(rings.begin(), rings.end(), [&](const std::shared_ptr<TraceRing> &ring) {
+		if (ring.use_count() > 1)
+			return false;
+		const auto head = ring->head.load(std::memory_order_acquire);
+		return head == ring->clearedAt.load(std::memory_order_relaxed) ||
+			   (readUpTo.contains(ring.get()) && readUpTo.value(ring.get()) == head);
+	}), rings.end());
+}
+
+QByteArray escapeJson(const QString &string)
+{
+	QByteArray escaped;
+	for (const auto c : string.toUtf8()) {
+		if (c == '"' || c == '\\')
+			escaped += '\\' + QByteArray{1, c};
+		else if (static_cast<uchar>(c) < 0x20)
+			escaped += "\\u00" + QByteArray::number(static_cast<uchar>(c), 16).rightJustified(2, '0');
+		else
+			escaped += c;
+	}
+	return escaped;
+}
+
+QByteArray formatMicros(qint64 nanos)
+{
+	return QByteArray::number(static_cast<double>(nanos) / 1000.0, 'f', 3);
+}
+
+QByteArray randomHex(int words)
+{
+	QByteArray hex;
+	for (auto i = 0; i < words; ++i) {
+		quint64 value = 0;
+		// all zero ids are invalid
+		while (value == 0)
+			value = QRandomGenerator::global()->generate64();
+		hex += QByteArray::number(value, 16).rightJustified(16, '0');
+	}
+	return hex;
+}
+
+}
+
+RestTracer::Span::Span(const char *name, QNetworkReply *reply) :
+	_name{name}
+{
+	if (!isEnabled())
+		return;
+
+	if (const auto recorder = TraceRecorder::find(reply); recorder) {
+		_requestId = recorder->requestId();
+		_spanId = recorder->spanId();
+	}
+	_begin = now();
+}
+
+RestTracer::Span::~Span()
+{
+	if (_begin >= 0)
+		record(Event{_name, _begin, now() - _begin, _requestId, _spanId});
+}
+
+bool RestTracer::isEnabled()
+{
+	return tracingEnabled.load(std::memory_order_relaxed);
+}
+
+void RestTracer::setEnabled(bool enabled)
+{
+	tracingEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+int RestTracer::bufferSize()
+{
+	return traceBufferSize.load(std::memory_order_relaxed);
+}
+
+void RestTracer::setBufferSize(int bufferSize)
+{
+	// rings are allocated once per thread, so this only affects threads that did not trace yet
+	traceBufferSize.store(std::max(bufferSize, 1), std::memory_order_relaxed);
+}
+
+qint64 RestTracer::now()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+quint64 RestTracer::nextRequestId()
+{
+	return traceRequestCounter.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+void RestTracer::record(const Event &event)
+{
+	currentRing()->push(event);
+}
+
+QByteArray RestTracer::toChromeTrace()
+{
+	QVector<std::shared_ptr<TraceRing>> rings;
+	{
+		QMutexLocker lock{&traceRegistry->mutex};
+		rings = traceRegistry->rings;
+	}
+
+	const auto pid = QByteArray::number(QCoreApplication::applicationPid());
+	QByteArray json = "{\"traceEvents\":[";
+	auto first = true;
+	const auto separator = [&]() {
+		if (!first)
+			json += ",\n";
+		first = false;
+	};
+
+	QHash<TraceRing*, quint64> readUpTo;
+	for (const auto &ring : qAsConst(rings)) {
+		const auto tid = QByteArray::number(ring->index);
+		separator();
+		json += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + pid + ",\"tid\":" + tid +
+				",\"args\":{\"name\":\"" + escapeJson(ring->threadName) + "\"}}";
+
+		const auto head = ring->head.load(std::memory_order_acquire);
+		const auto begin = std::max(head > ring->capacity ? head - ring->capacity : 0, ring->clearedAt.load(std::memory_order_relaxed));
+		readUpTo.insert(ring.get(), head);
+		for (auto position = begin; position < head; ++position) {
+			// slots the writer wrapped around to while reading are dropped
+			Event event;
+			if (!ring->read(position, event))
+				continue;
+			separator();
+			json += "{\"name\":\"" + QByteArray{event.name} + "\",\"cat\":\"qtrest\",\"pid\":" + pid + ",\"tid\":" + tid +
+					",\"ts\":" + formatMicros(event.begin);
+			if (event.duration >= 0)
+				json += ",\"ph\":\"X\",\"dur\":" + formatMicros(event.duration);
+			else
+				json += ",\"ph\":\"i\",\"s\":\"t\"";
+			json += ",\"args\":{\"request\":" + QByteArray::number(event.requestId);
+			if (event.spanId != 0)
+				json += ",\"span\":\"" + QByteArray::number(event.spanId, 16).rightJustified(16, '0') + '"';
+			json += "}}";
+		}
+	}
+
+	json += "],\"displayTimeUnit\":\"ms\"}";
+
+	rings.clear();
+	QMutexLocker lock{&traceRegistry->mutex};
+	traceRegistry->reclaim(readUpTo);
+	return json;
+}
+
+void RestTracer::clear()
+{
+	// rings are never touched by other threads, they are only marked as read up to their current head
+	QMutexLocker lock{&traceRegistry->mutex};
+	for (const auto &ring : qAsConst(traceRegistry->rings))
+		ring->clearedAt.store(ring->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+	traceRegistry->reclaim();
+}
+
+
+
+TraceContextExtender::TraceContextExtender(QByteArray traceId, bool sampled) :
+	_traceId{traceId.toLower()},
+	_sampled{sampled}
+{}
+
+QByteArray TraceContextExtender::traceId() const
+{
+	return _traceId;
+}
+
+void TraceContextExtender::extendUrl(QUrl &url) const
+{
+	Q_UNUSED(url)
+}
+
+void TraceContextExtender::extendRequest(QNetworkRequest &request) const
+{
+	// a context propagated by the caller keeps its trace and flags, but every built request is a span of its own
+	// 00-<trace id>-<span id>-<flags>
+	if (const auto traceparent = request.rawHeader("traceparent"); traceparent.size() >= 55) {
+		request.setRawHeader("traceparent", traceparent.left(36) + randomHex(1) + traceparent.mid(52));
+		return;
+	}
+
+	// without a fixed trace id, every request starts a trace of its own
+	request.setRawHeader("traceparent",
+						 "00-" + (_traceId.isEmpty() ? randomHex(2) : _traceId) +
+						 '-' + randomHex(1) +
+						 (_sampled ? "-01" : "-00"));
+}
+
+void TraceContextExtender::extendSend(QByteArray &verb, std::variant<QByteArray, QIODevice*, QUrlQuery> &body) const
+{
+	Q_UNUSED(verb)
+	Q_UNUSED(body)
+}
+
+
+
+TraceRecorder::TraceRecorder(QNetworkReply *reply, quint64 requestId, qint64 sent) :
+	QObject{reply},
+	_requestId{requestId},
+	_sent{sent}
+{
+	// 00-<trace id>-<span id>-<flags>
+	if (const auto traceparent = reply->request().rawHeader("traceparent"); traceparent.size() >= 52)
+		_spanId = traceparent.mid(36, 16).toULongLong(nullptr, 16);
+
+	_metaDataConnection = connect(reply, &QNetworkReply::metaDataChanged,
+								  this, [this]() {
+									  RestTracer::record(RestTracer::Event{"firstByte", RestTracer::now(), -1, _requestId, _spanId});
+									  disconnect(_metaDataConnection);
+								  });
+	connect(reply, &QNetworkReply::finished,
+			this, [this]() {
+				const auto now = RestTracer::now();
+				RestTracer::record(RestTracer::Event{"finished", _sent, now - _sent, _requestId, _spanId});
+			});
+}
+
+TraceRecorder *TraceRecorder::find(QNetworkReply *reply)
+{
+	return reply ?
+		reply->findChild<TraceRecorder*>(QString{}, Qt::FindDirectChildrenOnly) :
+		nullptr;
+}
+
+quint64 TraceRecorder::requestId() const
+{
+	return _requestId;
+}
+
+quint64 TraceRecorder::spanId() const
+{
+	return _spanId;
+}
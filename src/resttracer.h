@@ -0,0 +1,92 @@
+#pragma once
+
+#include "qtrest_global.h"
+#include "irestextender.h"
+
+#include <QtCore/QObject>
+#include <QtCore/QByteArray>
+
+#include <QtNetwork/QNetworkReply>
+
+namespace QtRest {
+
+class QTREST_EXPORT RestTracer
+{
+public:
+	// names must be string literals, only the pointer is stored
+	struct Event {
+		const char *name = nullptr;
+		qint64 begin = 0;
+		qint64 duration = -1;
+		quint64 requestId = 0;
+		quint64 spanId = 0;
+	};
+
+	class QTREST_EXPORT Span
+	{
+		Q_DISABLE_COPY(Span)
+
+	public:
+		Span(const char *name, QNetworkReply *reply = nullptr);
+		~Span();
+
+	private:
+		const char *_name;
+		qint64 _begin = -1;
+		quint64 _requestId = 0;
+		quint64 _spanId = 0;
+	};
+
+	static bool isEnabled();
+	static void setEnabled(bool enabled);
+	static int bufferSize();
+	static void setBufferSize(int bufferSize);
+
+	static qint64 now();
+	static quint64 nextRequestId();
+	static void record(const Event &event);
+
+	static QByteArray toChromeTrace();
+	static void clear();
+};
+
+class QTREST_EXPORT TraceContextExtender : public IRestExtender
+{
+public:
+	explicit TraceContextExtender(QByteArray traceId = {}, bool sampled = true);
+
+	QByteArray traceId() const;
+
+	void extendUrl(QUrl &url) const override;
+	void extendRequest(QNetworkRequest &request) const override;
+	void extendSend(QByteArray &verb, std::variant<QByteArray, QIODevice*, QUrlQuery> &body) const override;
+
+private:
+	QByteArray _traceId;
+	bool _sampled;
+};
+
+namespace __private {
+
+class QTREST_EXPORT TraceRecorder : public QObject
+{
+	Q_OBJECT
+
+public:
+	TraceRecorder(QNetworkReply *reply, quint64 requestId, qint64 sent);
+
+	static TraceRecorder *find(QNetworkReply *reply);
+
+	quint64 requestId() const;
+	quint64 spanId() const;
+
+private:
+	quint64 _requestId;
+	quint64 _spanId = 0;
+	qint64 _sent;
+	QMetaObject::Connection _metaDataConnection;
+};
+
+}
+
+}
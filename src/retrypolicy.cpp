@@ -0,0 +1,300 @@
+#include "retrypolicy.h"
+#include "bufferednetworkreply.h"
+#include "qtrest_global.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <QtCore/QTimer>
+#include <QtCore/QDateTime>
+#include <QtCore/QRandomGenerator>
+using namespace QtRest;
+using namespace QtRest::__private;
+using namespace std::chrono;
+
+RetryBudget::RetryBudget(double ratio, int minRetries) :
+	_deposit{static_cast<int>(ratio * 1000)},
+	_capacity{std::max(minRetries, 1) * 1000},
+	_balance{_capacity}
+{}
+
+void RetryBudget::deposit()
+{
+	auto balance = _balance.loadRelaxed();
+	while (balance < _capacity &&
+		   !_balance.testAndSetOrdered(balance, std::min(balance + _deposit, _capacity), balance));
+}
+
+bool RetryBudget::withdraw()
+{
+	auto balance = _balance.loadRelaxed();
+	while (balance >= 1000) {
+		if (_balance.testAndSetOrdered(balance, balance - 1000, balance))
+			return true;
+	}
+	return false;
+}
+
+
+
+LatencyTracker::LatencyTracker(int windowSize) :
+	_window(std::max(windowSize, 1))
+{}
+
+void LatencyTracker::record(milliseconds latency)
+{
+	QMutexLocker lock{&_mutex};
+	_window[_next] = latency;
+	if (++_next == _window.size()) {
+		_next = 0;
+		_full = true;
+	}
+}
+
+std::optional<milliseconds> LatencyTracker::percentile(double percentile, int minSamples) const
+{
+	QMutexLocker lock{&_mutex};
+	auto samples = _full ? _window : _window.mid(0, _next);
+	lock.unlock();
+
+	if (samples.isEmpty() || samples.size() < minSamples)
+		return std::nullopt;
+	const auto index = std::clamp(static_cast<int>(std::ceil(percentile * samples.size())) - 1,
+								  0, samples.size() - 1);
+	std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+	return samples[index];
+}
+
+
+
+bool RetryPolicy::isIdempotent(const QByteArray &verb) const
+{
+	return verb == Verbs::GET ||
+		   verb == Verbs::HEAD ||
+		   verb == Verbs::PUT ||
+		   verb == Verbs::DELETE ||
+		   verb == "OPTIONS" ||
+		   verb == "TRACE";
+}
+
+bool RetryPolicy::canHedge(const QByteArray &verb) const
+{
+	return (verb == Verbs::GET || verb == Verbs::HEAD) &&
+		   (hedgeDelay.count() > 0 || latencyTracker);
+}
+
+bool RetryPolicy::mayResend(const QByteArray &verb) const
+{
+	return (maxAttempts > 1 || canHedge(verb)) &&
+		   (!idempotentOnly || isIdempotent(verb));
+}
+
+bool RetryPolicy::shouldRetry(QNetworkReply *reply) const
+{
+	if (reply->error() == QNetworkReply::OperationCanceledError)
+		return false;
+	else if (retryErrors.contains(reply->error()))
+		return true;
+	else
+		return retryStatusCodes.contains(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt());
+}
+
+milliseconds RetryPolicy::backoff(int attempt, QNetworkReply *reply) const
+{
+	auto delay = baseDelay * (1ll << std::clamp(attempt - 1, 0, 30));
+	delay = std::min(delay, maxDelay);
+	if (jitter > 0.0 && delay.count() > 0) {
+		const auto range = static_cast<qint64>(delay.count() * std::min(jitter, 1.0));
+		delay -= milliseconds{QRandomGenerator::global()->bounded(range + 1)};
+	}
+
+	if (respectRetryAfter && reply && reply->hasRawHeader("Retry-After")) {
+		const auto retryAfter = reply->rawHeader("Retry-After").trimmed();
+		auto ok = false;
+		if (const auto seconds = retryAfter.toLongLong(&ok); ok)
+			delay = std::max<milliseconds>(delay, duration_cast<milliseconds>(std::chrono::seconds{seconds}));
+		else if (const auto date = QDateTime::fromString(QString::fromLatin1(retryAfter), Qt::RFC2822Date); date.isValid())
+			delay = std::max(delay, milliseconds{QDateTime::currentDateTimeUtc().msecsTo(date)});
+		delay = std::min(delay, maxDelay);
+	}
+
+	return delay;
+}
+
+milliseconds RetryPolicy::hedgeAfter() const
+{
+	if (latencyTracker) {
+		if (const auto latency = latencyTracker->percentile(hedgePercentile); latency)
+			return *latency;
+	}
+	return hedgeDelay;
+}
+
+
+
+RetryController::RetryController(RetryPolicy policy, QByteArray verb, BufferedNetworkReply *target, QObject *context) :
+	_policy{std::move(policy)},
+	_verb{std::move(verb)},
+	_target{target},
+	_context{context},
+	_hasContext{context != nullptr}
+{
+	// aborting or deleting the target cancels all attempts
+	connect(target, &QNetworkReply::finished,
+			this, &RetryController::cancel);
+	connect(target, &QObject::destroyed,
+			this, &RetryController::cancel);
+	if (context) {
+		connect(context, &QObject::destroyed,
+				this, [this]() {
+					if (_target) {
+						_target->abort();
+						_target->deleteLater();
+					}
+					cancel();
+				});
+	}
+}
+
+void RetryController::start(Launcher launcher)
+{
+	_launcher = std::move(launcher);
+	if (_policy.budget)
+		_policy.budget->deposit();
+
+	launch();
+	if (_policy.canHedge(_verb)) {
+		if (const auto delay = _policy.hedgeAfter(); delay.count() > 0)
+			QTimer::singleShot(delay, this, &RetryController::hedge);
+	}
+}
+
+void RetryController::launch()
+{
+	// hedged duplicates belong to the same attempt
+	if (_pending.isEmpty()) {
+		++_attempt;
+		_timer.start();
+	}
+
+	const auto reply = _launcher();
+	_pending.append(reply);
+	connect(reply, &QNetworkReply::metaDataChanged,
+			this, [this, reply]() {
+				readMetaData(reply);
+			});
+	connect(reply, &QNetworkReply::finished,
+			this, [this, reply]() {
+				replyFinished(reply);
+			});
+	if (_target)
+		_target->setSource(reply);
+}
+
+void RetryController::hedge()
+{
+	if (!_done && !_committed && _attempt == 1 && _pending.size() == 1)
+		launch();
+}
+
+bool RetryController::isRetryable(QNetworkReply *reply) const
+{
+	return _policy.shouldRetry(reply) &&
+		   (!_policy.idempotentOnly || _policy.isIdempotent(_verb));
+}
+
+void RetryController::readMetaData(QNetworkReply *reply)
+{
+	if (_done || _committed)
+		return;
+
+	// the body of a final response is streamed to the target, retryable responses wait for their end
+	const auto statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+	if (statusCode > 0 && !isRetryable(reply))
+		commit(reply);
+}
+
+void RetryController::readData()
+{
+	if (_committed && _target)
+		_target->appendData(_committed->readAll());
+}
+
+void RetryController::replyFinished(QNetworkReply *reply)
+{
+	if (_done || (_committed && reply != _committed)) {
+		reply->deleteLater();
+		return;
+	} else if (reply == _committed) {
+		complete();
+		return;
+	}
+
+	_pending.removeOne(reply);
+	const auto retryable = isRetryable(reply);
+	if (retryable && !_pending.isEmpty()) {
+		// a hedged duplicate is still running and may still succeed
+		reply->deleteLater();
+		return;
+	} else if (retryable &&
+			   _attempt < _policy.maxAttempts &&
+			   (!_policy.budget || _policy.budget->withdraw())) {
+		const auto delay = _policy.backoff(_attempt, reply);
+		reply->deleteLater();
+		QTimer::singleShot(delay, this, [this]() {
+			if (!_done)
+				launch();
+		});
+		return;
+	}
+
+	commit(reply);
+	complete();
+}
+
+void RetryController::commit(QNetworkReply *reply)
+{
+	_committed = reply;
+	_pending.removeOne(reply);
+	abortAll();
+	if (!_target)
+		return;
+
+	_target->setSource(reply);
+	_target->setMetaData(BufferedNetworkReply::readMetaData(reply), true);
+	connect(reply, &QNetworkReply::readyRead,
+			this, &RetryController::readData);
+	readData();
+}
+
+void RetryController::complete()
+{
+	_done = true;
+	if (_policy.latencyTracker && _committed->error() == QNetworkReply::NoError)
+		_policy.latencyTracker->record(milliseconds{_timer.elapsed()});
+	if (_target) {
+		readData();
+		_target->setMetaData(BufferedNetworkReply::readMetaData(_committed));
+		_target->finish();
+	}
+	_committed->deleteLater();
+	deleteLater();
+}
+
+void RetryController::cancel()
+{
+	if (_done)
+		return;
+
+	_done = true;
+	abortAll();
+	if (_committed)
+		_committed->abort();
+	deleteLater();
+}
+
+void RetryController::abortAll()
+{
+	const auto pending = std::exchange(_pending, {});
+	for (const auto reply : pending)
+		reply->abort();
+}
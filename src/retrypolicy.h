@@ -0,0 +1,130 @@
+#pragma once
+
+#include "qtrest_global.h"
+
+#include <chrono>
+#include <optional>
+#include <functional>
+
+#include <QtCore/QObject>
+#include <QtCore/QAtomicInteger>
+#include <QtCore/QMutex>
+#include <QtCore/QVector>
+#include <QtCore/QPointer>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QSharedPointer>
+
+#include <QtNetwork/QNetworkReply>
+
+namespace QtRest {
+
+class QTREST_EXPORT RetryBudget
+{
+	Q_DISABLE_COPY(RetryBudget)
+
+public:
+	RetryBudget(double ratio = 0.1, int minRetries = 10);
+
+	void deposit();
+	bool withdraw();
+
+private:
+	const int _deposit;
+	const int _capacity;
+	QAtomicInteger<int> _balance;
+};
+
+class QTREST_EXPORT LatencyTracker
+{
+	Q_DISABLE_COPY(LatencyTracker)
+
+public:
+	LatencyTracker(int windowSize = 128);
+
+	void record(std::chrono::milliseconds latency);
+	std::optional<std::chrono::milliseconds> percentile(double percentile, int minSamples = 16) const;
+
+private:
+	mutable QMutex _mutex;
+	QVector<std::chrono::milliseconds> _window;
+	int _next = 0;
+	bool _full = false;
+};
+
+struct QTREST_EXPORT RetryPolicy
+{
+	int maxAttempts = 3;
+	std::chrono::milliseconds baseDelay {100};
+	std::chrono::milliseconds maxDelay {10000};
+	double jitter = 1.0;
+	bool idempotentOnly = true;
+	bool respectRetryAfter = true;
+	QVector<int> retryStatusCodes {408, 429, 502, 503, 504};
+	QVector<QNetworkReply::NetworkError> retryErrors {
+		QNetworkReply::ConnectionRefusedError,
+		QNetworkReply::RemoteHostClosedError,
+		QNetworkReply::TimeoutError,
+		QNetworkReply::TemporaryNetworkFailureError,
+		QNetworkReply::NetworkSessionFailedError,
+		QNetworkReply::ProxyConnectionClosedError,
+		QNetworkReply::UnknownNetworkError
+	};
+	QSharedPointer<RetryBudget> budget;
+
+	std::chrono::milliseconds hedgeDelay {0};
+	double hedgePercentile = 0.95;
+	QSharedPointer<LatencyTracker> latencyTracker;
+
+	bool isIdempotent(const QByteArray &verb) const;
+	bool canHedge(const QByteArray &verb) const;
+	bool mayResend(const QByteArray &verb) const;
+	bool shouldRetry(QNetworkReply *reply) const;
+	std::chrono::milliseconds backoff(int attempt, QNetworkReply *reply = nullptr) const;
+	std::chrono::milliseconds hedgeAfter() const;
+};
+
+namespace __private {
+
+class BufferedNetworkReply;
+
+// an attempt is committed once its response headers are not retryable, later failures are reported as they are
+class QTREST_EXPORT RetryController : public QObject
+{
+	Q_OBJECT
+
+public:
+	using Launcher = std::function<QNetworkReply*()>;
+
+	RetryController(RetryPolicy policy, QByteArray verb, BufferedNetworkReply *target, QObject *context);
+
+	void start(Launcher launcher);
+
+private:
+	RetryPolicy _policy;
+	QByteArray _verb;
+	QPointer<BufferedNetworkReply> _target;
+	QPointer<QObject> _context;
+	bool _hasContext;
+	Launcher _launcher;
+
+	int _attempt = 0;
+	bool _done = false;
+	QElapsedTimer _timer;
+	QVector<QNetworkReply*> _pending;
+	QPointer<QNetworkReply> _committed;
+
+	void launch();
+	void hedge();
+	bool isRetryable(QNetworkReply *reply) const;
+	void readMetaData(QNetworkReply *reply);
+	void readData();
+	void replyFinished(QNetworkReply *reply);
+	void commit(QNetworkReply *reply);
+	void complete();
+	void cancel();
+	void abortAll();
+};
+
+}
+
+}
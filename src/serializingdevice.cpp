@@ -0,0 +1,66 @@
+#include "serializingdevice.h"
+#include <algorithm>
+#include <cstring>
+using namespace QtRest::__private;
+
+SerializingDevice::SerializingDevice(GeneratorFactory factory, QObject *parent) :
+	QIODevice{parent},
+	_factory{std::move(factory)},
+	_generator{_factory()}
+{
+	open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+qint64 SerializingDevice::measureSize() const
+{
+	auto generator = _factory();
+	qint64 size = 0;
+	QByteArray chunk;
+	for (auto more = true; more;) {
+		chunk.clear();
+		more = generator(chunk);
+		size += chunk.size();
+	}
+	return size;
+}
+
+bool SerializingDevice::isSequential() const
+{
+	return true;
+}
+
+bool SerializingDevice::atEnd() const
+{
+	return _finished && _offset == _buffer.size();
+}
+
+qint64 SerializingDevice::bytesAvailable() const
+{
+	// there is always more to generate until the generator finished
+	return _finished ?
+		_buffer.size() - _offset + QIODevice::bytesAvailable() :
+		std::max<qint64>(_buffer.size() - _offset, 1) + QIODevice::bytesAvailable();
+}
+
+qint64 SerializingDevice::readData(char *data, qint64 maxSize)
+{
+	// only the remainder of the last element is kept, so the buffer never grows beyond one read
+	if (_offset > 0) {
+		_buffer.remove(0, static_cast<int>(_offset));
+		_offset = 0;
+	}
+	while (!_finished && _buffer.size() - _offset < maxSize)
+		_finished = !_generator(_buffer);
+
+	const auto size = std::min(maxSize, _buffer.size() - _offset);
+	if (size == 0)
+		return _finished ? -1 : 0;
+	std::memcpy(data, _buffer.constData() + _offset, static_cast<size_t>(size));
+	_offset += size;
+	return size;
+}
+
+qint64 SerializingDevice::writeData(const char *, qint64)
+{
+	return -1;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "qtrest_global.h"
+
+#include <functional>
+
+#include <QtCore/QIODevice>
+
+namespace QtRest::__private {
+
+class QTREST_EXPORT SerializingDevice : public QIODevice
+{
+	Q_OBJECT
+
+public:
+	// appends the next part of the body to out and returns false once the body is complete
+	using Generator = std::function<bool(QByteArray &)>;
+	using GeneratorFactory = std::function<Generator()>;
+
+	explicit SerializingDevice(GeneratorFactory factory, QObject *parent = nullptr);
+
+	// runs a separate generator over the whole body, so measuring costs a full extra serialization
+	qint64 measureSize() const;
+
+	bool isSequential() const override;
+	bool atEnd() const override;
+	qint64 bytesAvailable() const override;
+
+protected:
+	qint64 readData(char *data, qint64 maxSize) override;
+	qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+	GeneratorFactory _factory;
+	Generator _generator;
+	QByteArray _buffer;
+	qint64 _offset = 0;
+	bool _finished = false;
+};
+
+}
@@ -0,0 +1,10 @@
+TEMPLATE = app
+
+TARGET = tst_compression
+
+include(../tests.pri)
+
+SOURCES += \
+	tst_compression.cpp
+
+!load(qdep):error("Failed to load qdep feature! Run 'qdep prfgen --qmake $$QMAKE_QMAKE' to create it.")
@@ -0,0 +1,172 @@
+#include <QtTest>
+#include <QtCore/QBuffer>
+#include <compression.h>
+#include <bodypipe.h>
+using namespace QtRest;
+using namespace QtRest::__private;
+
+Q_DECLARE_METATYPE(QtRest::Compression::Encoding)
+
+class CompressionTest : public QObject
+{
+	Q_OBJECT
+
+private Q_SLOTS:
+	void testRoundTrip_data();
+	void testRoundTrip();
+	void testEncodingDevice_data();
+	void testEncodingDevice();
+	void testDecodeReply_data();
+	void testDecodeReply();
+	void testInvalidData_data();
+	void testInvalidData();
+	void testDefaults();
+
+private:
+	static QByteArray testData();
+	static QByteArray encode(Compression::Encoding encoding, const QByteArray &data);
+	static void addEncodings();
+};
+
+void CompressionTest::testRoundTrip_data()
+{
+	addEncodings();
+}
+
+void CompressionTest::testRoundTrip()
+{
+	QFETCH(Compression::Encoding, encoding);
+
+	const auto data = testData();
+	const auto encoded = encode(encoding, data);
+	QVERIFY(encoded.size() < data.size());
+
+	// decoders have to cope with arbitrary chunk boundaries
+	const auto decoder = Codec::createDecoder(encoding);
+	QVERIFY(decoder);
+	QVERIFY(!decoder->hasError());
+	QByteArray decoded;
+	for (auto i = 0; i < encoded.size(); i += 7)
+		QVERIFY2(decoder->process(encoded.constData() + i, std::min(7, encoded.size() - i), decoded), qUtf8Printable(decoder->errorString()));
+	QVERIFY2(decoder->finish(decoded), qUtf8Printable(decoder->errorString()));
+	QCOMPARE(decoded, data);
+}
+
+void CompressionTest::testEncodingDevice_data()
+{
+	addEncodings();
+}
+
+void CompressionTest::testEncodingDevice()
+{
+	QFETCH(Compression::Encoding, encoding);
+
+	const auto data = testData();
+	const auto reader = new BodyPipeReader{data.size()};
+	BodyPipeWriter writer{reader};
+	EncodingDevice device{reader, Codec::createEncoder(encoding)};
+	QSignalSpy finishedSpy{&device, &QIODevice::readChannelFinished};
+
+	QCOMPARE(writer.write(data), data.size());
+	auto encoded = device.readAll();
+	QVERIFY(!device.atEnd());
+
+	// the end of the source is passed on, so readers waiting for it collect the remainder
+	writer.close();
+	QCOMPARE(finishedSpy.size(), 1);
+	encoded += device.readAll();
+	QVERIFY(device.atEnd());
+
+	const auto decoder = Codec::createDecoder(encoding);
+	QByteArray decoded;
+	QVERIFY(decoder->process(encoded.constData(), encoded.size(), decoded));
+	QVERIFY(decoder->finish(decoded));
+	QCOMPARE(decoded, data);
+}
+
+void CompressionTest::testDecodeReply_data()
+{
+	addEncodings();
+}
+
+void CompressionTest::testDecodeReply()
+{
+	QFETCH(Compression::Encoding, encoding);
+
+	const auto data = testData();
+	const auto source = new BufferedNetworkReply{QNetworkRequest{QUrl{QStringLiteral("http://localhost/")}}};
+	source->setResponse(200, "OK", {
+		{"Content-Encoding", Compression::encodingName(encoding)},
+		{"Content-Type", "text/plain"}
+	});
+	const QScopedPointer<QNetworkReply> reply{ContentDecoder::wrap(source)};
+	source->finish(encode(encoding, data));
+
+	QTRY_VERIFY(reply->isFinished());
+	QCOMPARE(reply->error(), QNetworkReply::NoError);
+	QVERIFY(!reply->hasRawHeader("Content-Encoding"));
+	QCOMPARE(reply->readAll(), data);
+}
+
+void CompressionTest::testInvalidData_data()
+{
+	addEncodings();
+}
+
+void CompressionTest::testInvalidData()
+{
+	QFETCH(Compression::Encoding, encoding);
+
+	const auto source = new BufferedNetworkReply{QNetworkRequest{QUrl{QStringLiteral("http://localhost/")}}};
+	source->setResponse(200, "OK", {{"Content-Encoding", Compression::encodingName(encoding)}});
+	const QScopedPointer<QNetworkReply> reply{ContentDecoder::wrap(source)};
+	source->finish(QByteArray{"this is not compressed at all"});
+
+	QTRY_VERIFY(reply->isFinished());
+	QCOMPARE(reply->error(), QNetworkReply::UnknownContentError);
+}
+
+void CompressionTest::testDefaults()
+{
+	// enabling compression only decodes responses, uploads stay as they are
+	const Compression compression;
+	QCOMPARE(compression.requestEncoding, Compression::Encoding::Identity);
+	QVERIFY(compression.decodeResponses);
+
+	QNetworkRequest request;
+	std::variant<QByteArray, QIODevice*, QUrlQuery> body = testData();
+	encodeBody(compression, request, body);
+	QVERIFY(!request.hasRawHeader("Content-Encoding"));
+	QCOMPARE(request.rawHeader("Accept-Encoding"), Compression::acceptEncoding());
+	QCOMPARE(std::get<QByteArray>(body), testData());
+}
+
+QByteArray CompressionTest::testData()
+{
+	QByteArray data;
+	for (auto i = 0; i < 4096; ++i)
+		data += "line " + QByteArray::number(i) + " of the compressed test body\n";
+	return data;
+}
+
+QByteArray CompressionTest::encode(Compression::Encoding encoding, const QByteArray &data)
+{
+	const auto encoder = Codec::createEncoder(encoding);
+	if (!encoder || encoder->hasError())
+		return {};
+	QByteArray encoded;
+	if (!encoder->process(data.constData(), data.size(), encoded) || !encoder->finish(encoded))
+		return {};
+	return encoded;
+}
+
+void CompressionTest::addEncodings()
+{
+	QTest::addColumn<Compression::Encoding>("encoding");
+	for (const auto encoding : Compression::supportedEncodings())
+		QTest::newRow(Compression::encodingName(encoding).constData()) << encoding;
+}
+
+QTEST_GUILESS_MAIN(CompressionTest)
+
+#include "tst_compression.moc"
@@ -0,0 +1,11 @@
+TEMPLATE = app
+
+TARGET = tst_integration
+
+include(../tests.pri)
+include(../../shared/shared.pri)
+
+SOURCES += \
+	tst_integration.cpp
+
+!load(qdep):error("Failed to load qdep feature! Run 'qdep prfgen --qmake $$QMAKE_QMAKE' to create it.")
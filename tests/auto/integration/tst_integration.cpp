@@ -0,0 +1,804 @@
+#include <QtTest>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QTemporaryFile>
+#include <restbuilder.h>
+#include <jsoncontenthandler.h>
+#include <httptestserver.h>
+using namespace QtRest;
+using namespace std::chrono;
+using Response = HttpTestServer::Response;
+
+class IntegrationTest : public QObject
+{
+	Q_OBJECT
+
+private Q_SLOTS:
+	void initTestCase();
+	void init();
+
+	void testStreamedJson();
+	void testCacheFresh();
+	void testCacheRevalidate();
+	void testCacheVariants();
+	void testCoalescer();
+	void testRetry();
+	void testScheduler();
+	void testEngine();
+	void testMetrics();
+	void testTiming();
+	void testTracing();
+	void testEventSource();
+	void testEventSourceClose();
+	void testNdjson();
+	void testNdjsonRetry();
+	void testJsonSeq();
+	void testBodyPipe();
+	void testBodyFile();
+	void testDownloadResume();
+	void testPaginator();
+	void testSendAsync();
+	void testBodyAsyncMovedTarget();
+
+private:
+	HttpTestServer *_server = nullptr;
+	QNetworkAccessManager *_nam = nullptr;
+
+	RestBuilder builder(const QString &path) const;
+	static QJsonArray largeArray(int size);
+};
+
+void IntegrationTest::initTestCase()
+{
+	_server = new HttpTestServer{this};
+	QVERIFY(_server->start());
+	_nam = new QNetworkAccessManager{this};
+	_server->addRoute("/echo", [](const HttpTestServer::Request &request) {
+		Response response;
+		response.headers.insert("Content-Type", request.headers.value("content-type"));
+		response.body = request.body;
+		return response;
+	});
+}
+
+void IntegrationTest::init()
+{
+	_server->clearRequests();
+}
+
+void IntegrationTest::testStreamedJson()
+{
+	const auto data = largeArray(2000);
+	auto response = Response::json(data);
+	response.chunkSize = 7;
+	_server->addRoute("/streamed", response);
+
+	std::optional<RawRestReply> result;
+	builder(QStringLiteral("/streamed"))
+		.streamJsonBody()
+		.onResult([&](RawRestReply reply) {
+			result = reply;
+		})
+		.send();
+	QTRY_VERIFY(result);
+	QCOMPARE(result->statusCode(), 200);
+	QVERIFY(result->streamedJson());
+	QCOMPARE(*result->streamedJson(), QJsonValue{data});
+}
+
+void IntegrationTest::testCacheFresh()
+{
+	auto response = Response::json(QJsonObject{{QStringLiteral("fresh"), true}});
+	response.headers.insert("Cache-Control", "max-age=60");
+	_server->addRoute("/cache/fresh", response);
+
+	RestCache cache;
+	QByteArrayList bodies;
+	for (auto i = 0; i < 2; ++i) {
+		builder(QStringLiteral("/cache/fresh"))
+			.setCache(&cache)
+			.onResult([&](RawRestReply reply) {
+				QCOMPARE(reply.statusCode(), 200);
+				bodies.append(reply.bodyData());
+			})
+			.send();
+		QTRY_COMPARE(bodies.size(), i + 1);
+	}
+	QCOMPARE(bodies[0], response.body);
+	QCOMPARE(bodies[1], response.body);
+	QCOMPARE(_server->requestCount("/cache/fresh"), 1);
+}
+
+void IntegrationTest::testCacheRevalidate()
+{
+	const auto response = Response::json(QJsonObject{{QStringLiteral("etag"), true}});
+	_server->addRoute("/cache/etag", [response](const HttpTestServer::Request &request) {
+		auto result = request.headers.value("if-none-match") == "\"v1\"" ?
+			Response::status(304) :
+			response;
+		result.headers.insert("ETag", "\"v1\"");
+		result.headers.insert("Cache-Control", "no-cache");
+		return result;
+	});
+
+	RestCache cache;
+	QByteArrayList bodies;
+	for (auto i = 0; i < 2; ++i) {
+		builder(QStringLiteral("/cache/etag"))
+			.setCache(&cache)
+			.onResult([&](RawRestReply reply) {
+				QCOMPARE(reply.statusCode(), 200);
+				bodies.append(reply.bodyData());
+			})
+			.send();
+		QTRY_COMPARE(bodies.size(), i + 1);
+	}
+	QCOMPARE(bodies[1], response.body);
+	const auto requests = _server->requests("/cache/etag");
+	QCOMPARE(requests.size(), 2);
+	QVERIFY(!requests[0].headers.contains("if-none-match"));
+	QCOMPARE(requests[1].headers.value("if-none-match"), QByteArray{"\"v1\""});
+}
+
+void IntegrationTest::testCacheVariants()
+{
+	auto response = Response::json(QJsonObject{{QStringLiteral("variant"), true}});
+	response.headers.insert("Cache-Control", "max-age=60");
+	response.headers.insert("Vary", "Accept-Language");
+	_server->addRoute("/cache/vary", response);
+
+	RestCache cache;
+	auto finished = 0;
+	const auto send = [&](const QByteArray &language, const QByteArray &authorization) {
+		auto variantBuilder = builder(QStringLiteral("/cache/vary"))
+								  .setCache(&cache)
+								  .addHeader(QLatin1String{"Accept-Language"}, language);
+		if (!authorization.isEmpty())
+			variantBuilder.addHeader(QLatin1String{"Authorization"}, authorization);
+		variantBuilder.onResult([&](RawRestReply reply) {
+			QCOMPARE(reply.statusCode(), 200);
+			++finished;
+		}).send();
+	};
+
+	send("en", {});
+	QTRY_COMPARE(finished, 1);
+	send("en", {});
+	QTRY_COMPARE(finished, 2);
+	QCOMPARE(_server->requestCount("/cache/vary"), 1);
+	send("de", {});
+	QTRY_COMPARE(finished, 3);
+	QCOMPARE(_server->requestCount("/cache/vary"), 2);
+	send("de", "Bearer first");
+	QTRY_COMPARE(finished, 4);
+	send("de", "Bearer second");
+	QTRY_COMPARE(finished, 5);
+	QCOMPARE(_server->requestCount("/cache/vary"), 4);
+}
+
+void IntegrationTest::testCoalescer()
+{
+	auto response = Response::json(QJsonObject{{QStringLiteral("shared"), true}});
+	response.latency = milliseconds{100};
+	_server->addRoute("/coalesced", response);
+
+	RequestCoalescer coalescer;
+	QByteArrayList bodies;
+	for (auto i = 0; i < 3; ++i) {
+		builder(QStringLiteral("/coalesced"))
+			.setCoalescer(&coalescer)
+			.onResult([&](RawRestReply reply) {
+				QCOMPARE(reply.statusCode(), 200);
+				bodies.append(reply.bodyData());
+			})
+			.send();
+	}
+	QTRY_COMPARE(bodies.size(), 3);
+	for (const auto &body : qAsConst(bodies))
+		QCOMPARE(body, response.body);
+	QCOMPARE(_server->requestCount("/coalesced"), 1);
+	QCOMPARE(coalescer.inFlightCount(), 0);
+
+	// conditional requests get their own flight
+	bodies.clear();
+	for (const auto etag : {QByteArray{}, QByteArray{"\"v1\""}}) {
+		auto conditionalBuilder = builder(QStringLiteral("/coalesced")).setCoalescer(&coalescer);
+		if (!etag.isEmpty())
+			conditionalBuilder.addHeader(QLatin1String{"If-None-Match"}, etag);
+		conditionalBuilder.onResult([&](RawRestReply reply) {
+			bodies.append(reply.bodyData());
+		}).send();
+	}
+	QCOMPARE(coalescer.inFlightCount(), 2);
+	QTRY_COMPARE(bodies.size(), 2);
+	QCOMPARE(_server->requestCount("/coalesced"), 3);
+
+	// the request is aborted once every waiting reply was aborted
+	QList<QNetworkReply*> replies;
+	for (auto i = 0; i < 2; ++i)
+		replies.append(builder(QStringLiteral("/coalesced")).setCoalescer(&coalescer).send());
+	QCOMPARE(coalescer.inFlightCount(), 1);
+	replies[0]->abort();
+	QCOMPARE(coalescer.inFlightCount(), 1);
+	replies[1]->abort();
+	QCOMPARE(coalescer.inFlightCount(), 0);
+	qDeleteAll(replies);
+}
+
+void IntegrationTest::testRetry()
+{
+	_server->addRoute("/retry", Response::json(QJsonObject{{QStringLiteral("retried"), true}}));
+	_server->addFailureBurst("/retry", 2);
+
+	RetryPolicy policy;
+	policy.baseDelay = milliseconds{10};
+	policy.jitter = 0.0;
+	std::optional<int> statusCode;
+	builder(QStringLiteral("/retry"))
+		.setRetryPolicy(policy)
+		.onResult([&](RawRestReply reply) {
+			statusCode = reply.statusCode();
+		})
+		.send();
+	QTRY_VERIFY(statusCode);
+	QCOMPARE(*statusCode, 200);
+	QCOMPARE(_server->requestCount("/retry"), 3);
+}
+
+void IntegrationTest::testScheduler()
+{
+	auto response = Response::json(QJsonObject{{QStringLiteral("scheduled"), true}});
+	response.latency = milliseconds{50};
+	_server->addRoute("/scheduled", response);
+
+	RestScheduler scheduler;
+	scheduler.setHostBudget(1);
+	QList<int> order;
+	QList<QNetworkReply*> replies;
+	for (auto i = 0; i < 3; ++i) {
+		replies.append(builder(QStringLiteral("/scheduled"))
+						   .setScheduler(&scheduler)
+						   .onResult([&, i](RawRestReply reply) {
+							   QCOMPARE(reply.statusCode(), i == 1 ? 0 : 200);
+							   order.append(i);
+						   })
+						   .send());
+		QVERIFY(replies.last());
+	}
+	QCOMPARE(scheduler.activeCount(_server->url().host()), 1);
+	QCOMPARE(scheduler.queuedCount(), 2);
+
+	// aborting a queued request frees its place without reaching the server
+	replies[1]->abort();
+	QTRY_COMPARE(order.size(), 3);
+	QCOMPARE(order, (QList<int>{1, 0, 2}));
+	QCOMPARE(_server->requestCount("/scheduled"), 2);
+	QCOMPARE(scheduler.activeCount(_server->url().host()), 0);
+}
+
+void IntegrationTest::testEngine()
+{
+	RestEngine engine{2};
+	std::optional<QByteArray> echo;
+	std::optional<QNetworkAccessManager::Operation> operation;
+	QThread *callbackThread = nullptr;
+	const auto reply = builder(QStringLiteral("/echo"))
+		.setEngine(&engine)
+		.setVerb("POST")
+		.setBody(QByteArray{"engine"}, "text/plain", false)
+		.onResult([&](RawRestReply reply) {
+			callbackThread = QThread::currentThread();
+			operation = reply.reply().toStrongRef()->operation();
+			echo = reply.bodyData();
+		})
+		.send();
+	// the proxy is resolved on this thread, but already reports the operation of the request it stands for
+	QCOMPARE(reply->operation(), QNetworkAccessManager::PostOperation);
+	QTRY_VERIFY(echo);
+	QCOMPARE(*echo, QByteArray{"engine"});
+	QCOMPARE(*operation, QNetworkAccessManager::PostOperation);
+	QCOMPARE(callbackThread, QThread::currentThread());
+	QCOMPARE(_server->requests("/echo").last().method, QByteArray{"POST"});
+}
+
+void IntegrationTest::testMetrics()
+{
+	_server->addRoute("/metrics/items/1", Response::json(QJsonObject{}));
+	_server->addRoute("/metrics/items/2", Response::json(QJsonObject{}));
+	_server->addRoute("/metrics/items/3", Response::json(QJsonObject{}));
+	_server->addRoute("/metrics/missing", Response::status(404));
+
+	RestMetrics metrics;
+	auto finished = 0;
+	for (const auto path : {"/metrics/items/1", "/metrics/items/2", "/metrics/missing"}) {
+		builder(QString::fromUtf8(path))
+			.setMetrics(&metrics)
+			.onResult([&](RawRestReply) {
+				++finished;
+			})
+			.send();
+	}
+	QTRY_COMPARE(finished, 3);
+
+	// threads that tracked replies and finished keep their counts
+	const auto url = _server->url(QStringLiteral("/metrics/items/3"));
+	for (auto i = 0; i < 2; ++i) {
+		const QScopedPointer<QThread> thread{QThread::create([&]() {
+			QNetworkAccessManager nam;
+			QEventLoop loop;
+			RestBuilder{}
+				.setNetworkAccessManager(&nam)
+				.setBaseUrl(url)
+				.setMetrics(&metrics)
+				.onResult([&](RawRestReply) {
+					loop.quit();
+				})
+				.send();
+			loop.exec();
+		})};
+		thread->start();
+		QTRY_VERIFY(thread->isFinished());
+	}
+
+	const auto snapshot = metrics.snapshot();
+	QCOMPARE(snapshot.endpoints.size(), 2);
+	for (const auto &endpoint : snapshot.endpoints) {
+		QCOMPARE(endpoint.verb, QByteArray{"GET"});
+		QCOMPARE(endpoint.inFlight(), qint64{0});
+		if (endpoint.route == QStringLiteral("/metrics/items/{id}")) {
+			QCOMPARE(endpoint.requests, 4ull);
+			QCOMPARE(endpoint.statusClasses[2], 4ull);
+			QCOMPARE(endpoint.latency.count(), 4ull);
+			QVERIFY(endpoint.bytesReceived > 0);
+		} else {
+			QCOMPARE(endpoint.route, QStringLiteral("/metrics/missing"));
+			QCOMPARE(endpoint.requests, 1ull);
+			QCOMPARE(endpoint.statusClasses[4], 1ull);
+		}
+	}
+	QVERIFY(metrics.toPrometheus().contains(R"__(route="/metrics/items/{id}",status="2xx"} 4)__"));
+}
+
+void IntegrationTest::testTiming()
+{
+	const QJsonObject data{{QStringLiteral("timed"), true}};
+	_server->addRoute("/timing", Response::json(data));
+
+	std::optional<RequestTiming> timing;
+	std::optional<RequestTiming> parsedTiming;
+	builder(QStringLiteral("/timing"))
+		.addContentTypeHandler<JsonContentHandler>()
+		.recordTiming()
+		.onResult([&](GenericRestBuilder<JsonContentHandler>::RestReply reply) {
+			timing = reply.timing();
+			QCOMPARE(reply.body<QJsonObject>(), data);
+			parsedTiming = reply.timing();
+		})
+		.send();
+	QTRY_VERIFY(parsedTiming);
+
+	QVERIFY(timing);
+	QVERIFY(timing->sendStarted != RequestTiming::TimePoint{});
+	QVERIFY(timing->sendStarted <= timing->buildStarted);
+	QVERIFY(timing->buildStarted <= timing->buildFinished);
+	QVERIFY(timing->buildFinished <= timing->requestStarted);
+	QVERIFY(timing->requestStarted <= timing->headersReceived);
+	QVERIFY(timing->headersReceived <= timing->firstByte);
+	QVERIFY(timing->firstByte <= timing->finished);
+	QVERIFY(timing->totalTime() > nanoseconds::zero());
+	QVERIFY(timing->deserializeStarted == RequestTiming::TimePoint{});
+
+	// reading the body adds the deserialization phase
+	QVERIFY(parsedTiming->finished <= parsedTiming->deserializeStarted);
+	QVERIFY(parsedTiming->deserializeStarted <= parsedTiming->deserializeFinished);
+}
+
+void IntegrationTest::testTracing()
+{
+	_server->addRoute("/traced", Response::json(QJsonObject{}));
+	RestTracer::clear();
+	RestTracer::setEnabled(true);
+	const auto guard = qScopeGuard([]() {
+		RestTracer::setEnabled(false);
+	});
+
+	const QByteArray traceId{"4bf92f3577b34da6a3ce929d0e0e4736"};
+	auto finished = 0;
+	for (auto i = 0; i < 2; ++i) {
+		builder(QStringLiteral("/traced"))
+			.addExtender(new TraceContextExtender{traceId})
+			.onResult([&](RawRestReply) {
+				++finished;
+			})
+			.send();
+	}
+	QTRY_COMPARE(finished, 2);
+
+	// both requests share the trace, but are spans of their own
+	const auto requests = _server->requests("/traced");
+	QCOMPARE(requests.size(), 2);
+	QByteArrayList spanIds;
+	for (const auto &request : requests) {
+		const auto traceparent = request.headers.value("traceparent");
+		QCOMPARE(traceparent.size(), 55);
+		QVERIFY(traceparent.startsWith("00-" + traceId + '-'));
+		QVERIFY(traceparent.endsWith("-01"));
+		spanIds.append(traceparent.mid(36, 16));
+	}
+	QVERIFY(spanIds[0] != spanIds[1]);
+
+	// the recorded spans carry the span ids that were sent
+	const auto trace = QJsonDocument::fromJson(RestTracer::toChromeTrace()).object();
+	QByteArrayList finishedSpans;
+	for (const auto event : trace.value(QStringLiteral("traceEvents")).toArray()) {
+		const auto object = event.toObject();
+		if (object.value(QStringLiteral("name")).toString() == QStringLiteral("finished"))
+			finishedSpans.append(object.value(QStringLiteral("args")).toObject().value(QStringLiteral("span")).toString().toLatin1());
+	}
+	std::sort(spanIds.begin(), spanIds.end());
+	std::sort(finishedSpans.begin(), finishedSpans.end());
+	QCOMPARE(finishedSpans, spanIds);
+}
+
+void IntegrationTest::testEventSource()
+{
+	Response response;
+	response.headers.insert("Content-Type", "text/event-stream");
+	response.chunkInterval = milliseconds{10};
+	for (auto i = 0; i < 5; ++i)
+		response.chunks.append("id: " + QByteArray::number(i) + "\ndata: " + QByteArray::number(i * i) + "\n\n");
+	_server->addRoute("/events", response);
+
+	const auto source = builder(QStringLiteral("/events")).openEventStream(this);
+	source->setRetryInterval(milliseconds{50});
+	QSignalSpy eventSpy{source, &EventSource::eventReceived};
+	QTRY_COMPARE(eventSpy.size(), 5);
+	QCOMPARE(eventSpy.last().first().value<ServerSentEvent>().data, QByteArray{"16"});
+
+	// the server ends the stream, so the source reconnects where it left off
+	QTRY_COMPARE(_server->requestCount("/events"), 2);
+	QCOMPARE(_server->requests("/events").last().headers.value("last-event-id"), QByteArray{"4"});
+	source->close();
+	QCOMPARE(source->readyState(), EventSource::ReadyState::Closed);
+	delete source;
+}
+
+void IntegrationTest::testEventSourceClose()
+{
+	// all events arrive in one chunk, the bare data line carries no event
+	Response response;
+	response.headers.insert("Content-Type", "text/event-stream");
+	response.body = "data:\n\ndata: a\n\ndata: b\n\ndata: c\n\n";
+	_server->addRoute("/events-close", response);
+
+	const QScopedPointer<EventSource> source{builder(QStringLiteral("/events-close")).openEventStream()};
+	QList<QByteArray> events;
+	connect(source.data(), &EventSource::eventReceived, this, [&](const ServerSentEvent &event) {
+		events.append(event.data);
+		source->close();
+	});
+	QTRY_COMPARE(events.size(), 1);
+	QCOMPARE(events.first(), QByteArray{"a"});
+	QCOMPARE(source->readyState(), EventSource::ReadyState::Closed);
+	QTest::qWait(100);
+	QCOMPARE(events.size(), 1);
+}
+
+void IntegrationTest::testNdjson()
+{
+	Response response;
+	response.headers.insert("Content-Type", "application/x-ndjson");
+	for (auto i = 0; i < 100; ++i)
+		response.chunks.append("{\"index\":" + QByteArray::number(i) + "}\n");
+	_server->addRoute("/ndjson", response);
+
+	QList<int> items;
+	auto finished = false;
+	builder(QStringLiteral("/ndjson"))
+		.onItem([&](const QJsonValue &item) {
+			items.append(item[QStringLiteral("index")].toInt());
+		})
+		.onResult([&](RawRestReply reply) {
+			QCOMPARE(reply.statusCode(), 200);
+			finished = true;
+		})
+		.send();
+	QTRY_VERIFY(finished);
+	QCOMPARE(items.size(), 100);
+	for (auto i = 0; i < items.size(); ++i)
+		QCOMPARE(items[i], i);
+}
+
+void IntegrationTest::testNdjsonRetry()
+{
+	// the failed attempt carries items as well, they must not reach the handler
+	const auto calls = QSharedPointer<int>::create(0);
+	_server->addRoute("/ndjson-retry", [calls](const HttpTestServer::Request &) {
+		Response response;
+		response.statusCode = (*calls)++ == 0 ? 503 : 200;
+		response.headers.insert("Content-Type", "application/x-ndjson");
+		for (auto i = 0; i < 5; ++i)
+			response.chunks.append("{\"index\":" + QByteArray::number(i) + "}\n");
+		return response;
+	});
+
+	RetryPolicy policy;
+	policy.baseDelay = milliseconds{10};
+	policy.jitter = 0.0;
+	QList<int> items;
+	std::optional<qint64> streamed;
+	builder(QStringLiteral("/ndjson-retry"))
+		.setRetryPolicy(policy)
+		.onItem([&](const QJsonValue &item) {
+			items.append(item[QStringLiteral("index")].toInt());
+		})
+		.onResult([&](RawRestReply reply) {
+			QCOMPARE(reply.statusCode(), 200);
+			streamed = reply.streamedItems();
+		})
+		.send();
+	QTRY_VERIFY(streamed);
+	QCOMPARE(*streamed, 5);
+	QCOMPARE(items, (QList<int>{0, 1, 2, 3, 4}));
+	QCOMPARE(_server->requestCount("/ndjson-retry"), 2);
+}
+
+void IntegrationTest::testJsonSeq()
+{
+	// records split across chunks and a last record without newline are carried over in owned buffers
+	Response response;
+	response.headers.insert("Content-Type", "application/json-seq");
+	response.chunks = QByteArrayList{
+		"\x1e{\"index\":0}\n\x1e{\"ind",
+		"ex\":1}\n",
+		"\x1e{\"index\":2}"
+	};
+	response.chunkInterval = milliseconds{20};
+	_server->addRoute("/json-seq", response);
+
+	QList<int> items;
+	std::optional<qint64> streamed;
+	builder(QStringLiteral("/json-seq"))
+		.onItem([&](const QJsonValue &item) {
+			items.append(item[QStringLiteral("index")].toInt());
+		})
+		.onResult([&](RawRestReply reply) {
+			streamed = reply.streamedItems();
+		})
+		.send();
+	QTRY_VERIFY(streamed);
+	QCOMPARE(*streamed, 3);
+	QCOMPARE(items, (QList<int>{0, 1, 2}));
+}
+
+void IntegrationTest::testBodyPipe()
+{
+	auto pipeBuilder = builder(QStringLiteral("/echo"));
+	const auto device = pipeBuilder.createBodyDevice("application/octet-stream", false, -1, 4096);
+	QByteArray data;
+	for (auto i = 0; i < 1024; ++i)
+		data += QByteArray::number(i) + ';';
+
+	std::optional<QByteArray> echo;
+	pipeBuilder.setVerb("POST")
+		.onResult([&](RawRestReply reply) {
+			echo = reply.bodyData();
+		})
+		.send();
+
+	// the pipe only takes as much as fits, the rest waits for the upload to drain it
+	auto written = 0;
+	const auto writeMore = [&]() {
+		if (!device->isOpen())
+			return;
+		while (written < data.size()) {
+			const auto size = device->write(data.constData() + written, data.size() - written);
+			if (size <= 0)
+				return;
+			written += static_cast<int>(size);
+		}
+		device->close();
+	};
+	QObject context;
+	connect(device, &QIODevice::bytesWritten, &context, writeMore);
+	writeMore();
+	QTRY_VERIFY(echo);
+	QCOMPARE(*echo, data);
+	QCOMPARE(_server->requests("/echo").first().body, data);
+
+	// a pipe cannot be rewound for another attempt
+	auto retryBuilder = builder(QStringLiteral("/echo"));
+	QScopedPointer<BodyPipeWriter> retryDevice{retryBuilder.createBodyDevice("application/octet-stream", false)};
+	QVERIFY_EXCEPTION_THROWN(retryBuilder.setVerb("PUT")
+								 .setRetryPolicy(RetryPolicy{})
+								 .send(),
+							 UnretryableBodyException);
+}
+
+void IntegrationTest::testBodyFile()
+{
+	QTemporaryFile file;
+	QVERIFY(file.open());
+	QByteArray content;
+	for (auto i = 0; i < 20000; ++i)
+		content += "mapped line " + QByteArray::number(i) + '\n';
+	QCOMPARE(file.write(content), static_cast<qint64>(content.size()));
+	QVERIFY(file.flush());
+
+	QByteArrayList echoes;
+	// the whole file and a range in the middle of it, which does not start at a page boundary
+	const QVector<QPair<qint64, qint64>> ranges {{0, -1}, {4099, 70000}};
+	for (const auto &range : ranges) {
+		builder(QStringLiteral("/echo"))
+			.setVerb("POST")
+			.setBodyFile(file.fileName(), "application/octet-stream", range.first, range.second, false)
+			.onResult([&](RawRestReply reply) {
+				QCOMPARE(reply.statusCode(), 200);
+				echoes.append(reply.bodyData());
+			})
+			.send();
+	}
+	QTRY_COMPARE_WITH_TIMEOUT(echoes.size(), 2, 10000);
+	QVERIFY(echoes.contains(content));
+	QVERIFY(echoes.contains(content.mid(4099, 70000)));
+
+	QVERIFY_EXCEPTION_THROWN(builder(QStringLiteral("/echo")).setBodyFile(file.fileName(), "application/octet-stream", content.size(), 1),
+							 FileMappingException);
+}
+
+void IntegrationTest::testDownloadResume()
+{
+	const auto content = QJsonDocument{largeArray(5000)}.toJson();
+	_server->addRoute("/download", [content](const HttpTestServer::Request &request) {
+		Response response;
+		response.headers.insert("ETag", "\"file\"");
+		response.headers.insert("Content-Type", "application/octet-stream");
+		if (const auto range = request.headers.value("range"); range.startsWith("bytes=") &&
+			request.headers.value("if-range") == "\"file\"") {
+			const auto offset = range.mid(6, range.indexOf('-') - 6).toInt();
+			response.statusCode = 206;
+			response.headers.insert("Content-Range", "bytes " + QByteArray::number(offset) + '-' +
+									QByteArray::number(content.size() - 1) + '/' +
+									QByteArray::number(content.size()));
+			response.body = content.mid(offset);
+		} else {
+			response.body = content;
+			response.fault = Response::Fault::ResetMidBody;
+		}
+		return response;
+	});
+
+	QTemporaryDir dir;
+	QVERIFY(dir.isValid());
+	FileDownload download;
+	download.filePath = dir.filePath(QStringLiteral("download.json"));
+	download.expectedSize = content.size();
+	download.expectedHash = QCryptographicHash::hash(content, QCryptographicHash::Sha256);
+
+	std::optional<QNetworkReply::NetworkError> error;
+	std::optional<RequestTiming> timing;
+	const auto reply = builder(QStringLiteral("/download"))
+		.downloadTo(download)
+		.recordTiming()
+		.onResult([&](RawRestReply reply) {
+			error = reply.error();
+			timing = reply.timing();
+		})
+		.send();
+	QSignalSpy progressSpy{reply, &QNetworkReply::downloadProgress};
+	QTRY_VERIFY_WITH_TIMEOUT(error, 10000);
+	QCOMPARE(*error, QNetworkReply::NoError);
+	QVERIFY(!progressSpy.isEmpty());
+	QCOMPARE(progressSpy.last().first().toLongLong(), static_cast<qint64>(content.size()));
+	QVERIFY(timing);
+	QVERIFY(timing->totalTime() > nanoseconds::zero());
+
+	QFile file{download.filePath};
+	QVERIFY(file.open(QIODevice::ReadOnly));
+	QCOMPARE(file.readAll(), content);
+	QVERIFY(!QFile::exists(download.partFilePath()));
+	const auto requests = _server->requests("/download");
+	QCOMPARE(requests.size(), 2);
+	QVERIFY(requests[1].headers.value("range").startsWith("bytes="));
+}
+
+void IntegrationTest::testPaginator()
+{
+	_server->addRoute("/pages", [this](const HttpTestServer::Request &request) {
+		const auto page = request.query.queryItemValue(QStringLiteral("page")).toInt();
+		auto response = Response::json(QJsonArray{page * 2, page * 2 + 1});
+		if (page < 4) {
+			auto next = _server->url(QStringLiteral("/pages"));
+			next.setQuery(QStringLiteral("page=%1").arg(page + 1));
+			response.headers.insert("Link", '<' + next.toEncoded() + ">; rel=\"next\"");
+		}
+		return response;
+	});
+
+	QByteArrayList pages;
+	const auto paginator = paginate(builder(QStringLiteral("/pages")).addParameter(QStringLiteral("page"), 0),
+									Pagination{},
+									std::function<bool(RawRestReply)>{[&](RawRestReply reply) {
+										pages.append(reply.bodyData());
+										return true;
+									}});
+	QPointer<Paginator> guard{paginator};
+	QSignalSpy finishedSpy{paginator, &Paginator::finished};
+	QTRY_COMPARE(finishedSpy.size(), 1);
+	QCOMPARE(pages.size(), 5);
+	QCOMPARE(pages.last(), QByteArray{"[8,9]"});
+	QCOMPARE(_server->requestCount("/pages"), 5);
+	// finished paginators clean up after themselves
+	QTRY_VERIFY(!guard);
+}
+
+void IntegrationTest::testSendAsync()
+{
+	const auto data = largeArray(20000);
+	_server->addRoute("/async", Response::json(data));
+
+	auto future = builder(QStringLiteral("/async")).getAsync();
+	QTRY_VERIFY_WITH_TIMEOUT(future.isFinished(), 10000);
+	auto reply = future.result();
+	QCOMPARE(reply.statusCode(), 200);
+	QCOMPARE(QJsonDocument::fromJson(reply.bodyData()).array(), data);
+}
+
+void IntegrationTest::testBodyAsyncMovedTarget()
+{
+	const QJsonObject data{{QStringLiteral("async"), true}};
+	_server->addRoute("/body-async", Response::json(data));
+
+	QThread thread;
+	thread.start();
+	QObject target;
+	QMutex mutex;
+	std::optional<QJsonObject> result;
+	QThread *callbackThread = nullptr;
+	auto asyncBuilder = builder(QStringLiteral("/body-async"))
+		.addContentTypeHandler<JsonContentHandler>()
+		.onBodyAsync<QJsonObject>(&target, [&](auto, std::optional<QJsonObject> body) {
+			QMutexLocker lock{&mutex};
+			callbackThread = QThread::currentThread();
+			result = body.value_or(QJsonObject{});
+		});
+	// the target changes its thread after the callback was set up, deliveries follow it
+	target.moveToThread(&thread);
+	asyncBuilder.send();
+
+	QTRY_VERIFY([&]() {
+		QMutexLocker lock{&mutex};
+		return result.has_value();
+	}());
+	QCOMPARE(*result, data);
+	QCOMPARE(callbackThread, &thread);
+
+	QMetaObject::invokeMethod(&target, [&]() {
+		target.moveToThread(QCoreApplication::instance()->thread());
+	}, Qt::BlockingQueuedConnection);
+	thread.quit();
+	QVERIFY(thread.wait());
+}
+
+RestBuilder IntegrationTest::builder(const QString &path) const
+{
+	return RestBuilder{}
+		.setNetworkAccessManager(_nam)
+		.setBaseUrl(_server->url(path));
+}
+
+QJsonArray IntegrationTest::largeArray(int size)
+{
+	QJsonArray array;
+	for (auto i = 0; i < size; ++i) {
+		array.append(QJsonObject{
+			{QStringLiteral("id"), i},
+			{QStringLiteral("name"), QStringLiteral("item %1").arg(i)},
+			{QStringLiteral("active"), i % 2 == 0}
+		});
+	}
+	return array;
+}
+
+QTEST_GUILESS_MAIN(IntegrationTest)
+
+#include "tst_integration.moc"
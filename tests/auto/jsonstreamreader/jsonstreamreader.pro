@@ -0,0 +1,10 @@
+TEMPLATE = app
+
+TARGET = tst_jsonstreamreader
+
+include(../tests.pri)
+
+SOURCES += \
+	tst_jsonstreamreader.cpp
+
+!load(qdep):error("Failed to load qdep feature! Run 'qdep prfgen --qmake $$QMAKE_QMAKE' to create it.")
@@ -0,0 +1,191 @@
+#include <QtTest>
+#include <jsonstreamreader.h>
+using namespace QtRest;
+
+class JsonStreamReaderTest : public QObject
+{
+	Q_OBJECT
+
+private Q_SLOTS:
+	void testParse_data();
+	void testParse();
+	void testErrors_data();
+	void testErrors();
+	void testReset();
+
+private:
+	static JsonStreamReader readChunked(const QByteArray &data, int chunkSize);
+	static JsonStreamReader readSplit(const QByteArray &data, int split);
+};
+
+void JsonStreamReaderTest::testParse_data()
+{
+	QTest::addColumn<QByteArray>("data");
+	QTest::addColumn<QJsonValue>("result");
+
+	QTest::newRow("object") << QByteArray{R"({"a": 1, "b": [true, false, null], "c": {"d": "e"}})"}
+							<< QJsonValue{QJsonObject{
+								   {QStringLiteral("a"), 1},
+								   {QStringLiteral("b"), QJsonArray{true, false, QJsonValue::Null}},
+								   {QStringLiteral("c"), QJsonObject{{QStringLiteral("d"), QStringLiteral("e")}}}
+							   }};
+	QTest::newRow("array") << QByteArray{R"([1, -2.5, 1e3, "x"])"}
+						   << QJsonValue{QJsonArray{1, -2.5, 1000.0, QStringLiteral("x")}};
+	QTest::newRow("empty") << QByteArray{R"({"a": {}, "b": []})"}
+						   << QJsonValue{QJsonObject{
+								  {QStringLiteral("a"), QJsonObject{}},
+								  {QStringLiteral("b"), QJsonArray{}}
+							  }};
+	QTest::newRow("whitespace") << QByteArray{" \n\t[ 1 ,\r\n 2 ] \n"}
+								<< QJsonValue{QJsonArray{1, 2}};
+	QTest::newRow("number") << QByteArray{"42"}
+							<< QJsonValue{42};
+	QTest::newRow("literal") << QByteArray{"false"}
+							 << QJsonValue{false};
+	QTest::newRow("escapes") << QByteArray{R"("\"\\\/\b\f\n\r\t")"}
+							 << QJsonValue{QStringLiteral("\"\\/\b\f\n\r\t")};
+	QTest::newRow("unicodeEscape") << QByteArray{R"("\u00e4\u20AC")"}
+								   << QJsonValue{QString::fromUtf8("\xc3\xa4\xe2\x82\xac")};
+	QTest::newRow("surrogatePair") << QByteArray{R"("a\ud83d\ude00b")"}
+								   << QJsonValue{QString::fromUtf8("a\xf0\x9f\x98\x80" "b")};
+	QTest::newRow("utf8") << QByteArray{"\"\xc3\xa4\xe2\x82\xac\xf0\x9f\x98\x80\""}
+						  << QJsonValue{QString::fromUtf8("\xc3\xa4\xe2\x82\xac\xf0\x9f\x98\x80")};
+	QTest::newRow("escapedKey") << QByteArray{R"({"a\"b": "\\"})"}
+								<< QJsonValue{QJsonObject{{QStringLiteral("a\"b"), QStringLiteral("\\")}}};
+}
+
+void JsonStreamReaderTest::testParse()
+{
+	QFETCH(QByteArray, data);
+	QFETCH(QJsonValue, result);
+
+	for (auto chunkSize = 1; chunkSize <= data.size(); ++chunkSize) {
+		const auto reader = readChunked(data, chunkSize);
+		QVERIFY2(!reader.hasError(), qUtf8Printable(reader.errorString()));
+		QVERIFY(reader.isComplete());
+		QCOMPARE(reader.result(), result);
+	}
+
+	// a split at every byte hits every escape sequence and multibyte character boundary
+	for (auto split = 0; split <= data.size(); ++split) {
+		const auto reader = readSplit(data, split);
+		QVERIFY2(!reader.hasError(), qUtf8Printable(reader.errorString()));
+		QVERIFY(reader.isComplete());
+		QCOMPARE(reader.result(), result);
+	}
+}
+
+void JsonStreamReaderTest::testErrors_data()
+{
+	QTest::addColumn<QByteArray>("data");
+	QTest::addColumn<QString>("error");
+
+	QTest::newRow("missingColon") << QByteArray{R"({"a" 1})"}
+								  << QStringLiteral("expected ':' at offset 5");
+	QTest::newRow("missingComma") << QByteArray{"[1 2]"}
+								  << QStringLiteral("expected ',' or ']' at offset 3");
+	QTest::newRow("trailingComma") << QByteArray{"[1,]"}
+								   << QStringLiteral("unexpected character ']' at offset 3");
+	QTest::newRow("trailingData") << QByteArray{"1 2"}
+								  << QStringLiteral("unexpected data after the JSON value at offset 2");
+	QTest::newRow("invalidLiteral") << QByteArray{"nul!"}
+									<< QStringLiteral("invalid literal, expected \"null\" at offset 0");
+	QTest::newRow("truncatedLiteral") << QByteArray{"tru"}
+									  << QStringLiteral("unexpected end of data at offset 3");
+	QTest::newRow("truncatedObject") << QByteArray{R"({"a":)"}
+									 << QStringLiteral("unexpected end of data at offset 5");
+	QTest::newRow("invalidEscape") << QByteArray{R"(["a\qb"])"}
+								   << QStringLiteral("invalid escape sequence \"\\q\" at offset 3");
+	QTest::newRow("invalidUnicodeEscape") << QByteArray{R"("\u12g4")"}
+										  << QStringLiteral("invalid unicode escape sequence at offset 1");
+	QTest::newRow("loneHighSurrogate") << QByteArray{R"(["x\ud800"])"}
+									   << QStringLiteral("unpaired high surrogate in unicode escape sequence at offset 3");
+	QTest::newRow("highSurrogatePair") << QByteArray{R"("\ud800\u0041")"}
+									   << QStringLiteral("unpaired high surrogate in unicode escape sequence at offset 1");
+	QTest::newRow("loneLowSurrogate") << QByteArray{R"("\udc00")"}
+									  << QStringLiteral("unpaired low surrogate in unicode escape sequence at offset 1");
+	QTest::newRow("leadingZero") << QByteArray{"[01]"}
+								 << QStringLiteral("invalid number \"01\" at offset 1");
+	QTest::newRow("negativeLeadingZero") << QByteArray{"-00"}
+										 << QStringLiteral("invalid number \"-00\" at offset 0");
+	QTest::newRow("trailingDot") << QByteArray{"1."}
+								 << QStringLiteral("invalid number \"1.\" at offset 0");
+	QTest::newRow("dotExponent") << QByteArray{"[1.e3]"}
+								 << QStringLiteral("invalid number \"1.e3\" at offset 1");
+	QTest::newRow("emptyExponent") << QByteArray{"1e+"}
+								   << QStringLiteral("invalid number \"1e+\" at offset 0");
+	QTest::newRow("loneMinus") << QByteArray{"[-]"}
+							   << QStringLiteral("invalid number \"-\" at offset 1");
+	QTest::newRow("signedNumber") << QByteArray{"[-+1]"}
+								  << QStringLiteral("invalid number \"-+1\" at offset 1");
+	QTest::newRow("plusSign") << QByteArray{"+1"}
+							  << QStringLiteral("unexpected character '+' at offset 0");
+	QTest::newRow("controlCharacter") << QByteArray{"\"ab\x01\""}
+									  << QStringLiteral("unescaped control character in string at offset 3");
+	QTest::newRow("rawNewline") << QByteArray{"{\"a\": \"b\nc\"}"}
+								<< QStringLiteral("unescaped control character in string at offset 8");
+	QTest::newRow("invalidUtf8") << QByteArray{"\"a\xff\""}
+								 << QStringLiteral("invalid UTF-8 sequence in string at offset 2");
+	QTest::newRow("truncatedUtf8") << QByteArray{"\"a\xe2\x82\""}
+								   << QStringLiteral("invalid UTF-8 sequence in string at offset 2");
+	QTest::newRow("overlongUtf8") << QByteArray{"\"\xc0\x80\""}
+								  << QStringLiteral("invalid UTF-8 sequence in string at offset 1");
+	QTest::newRow("encodedSurrogate") << QByteArray{"\"\xed\xa0\x80\""}
+									  << QStringLiteral("invalid UTF-8 sequence in string at offset 1");
+}
+
+void JsonStreamReaderTest::testErrors()
+{
+	QFETCH(QByteArray, data);
+	QFETCH(QString, error);
+
+	for (auto chunkSize : {1, 2, 3, data.size()}) {
+		const auto reader = readChunked(data, chunkSize);
+		QVERIFY(reader.hasError());
+		QVERIFY(!reader.isComplete());
+		QCOMPARE(reader.errorString(), error);
+	}
+}
+
+void JsonStreamReaderTest::testReset()
+{
+	JsonStreamReader reader;
+	reader.addData("[1,");
+	reader.addData("}");
+	QVERIFY(reader.hasError());
+
+	// data after an error is ignored until the reader is reset
+	reader.addData("2]");
+	reader.finish();
+	QVERIFY(reader.hasError());
+
+	reader.reset();
+	QVERIFY(!reader.hasError());
+	reader.addData("[1,");
+	reader.addData("2]");
+	reader.finish();
+	QVERIFY(reader.isComplete());
+	QCOMPARE(reader.result(), QJsonValue{QJsonArray{1, 2}});
+}
+
+JsonStreamReader JsonStreamReaderTest::readChunked(const QByteArray &data, int chunkSize)
+{
+	JsonStreamReader reader;
+	for (auto i = 0; i < data.size(); i += chunkSize)
+		reader.addData(data.mid(i, chunkSize));
+	reader.finish();
+	return reader;
+}
+
+JsonStreamReader JsonStreamReaderTest::readSplit(const QByteArray &data, int split)
+{
+	JsonStreamReader reader;
+	reader.addData(data.left(split));
+	reader.addData(data.mid(split));
+	reader.finish();
+	return reader;
+}
+
+QTEST_GUILESS_MAIN(JsonStreamReaderTest)
+
+#include "tst_jsonstreamreader.moc"
@@ -0,0 +1,5 @@
+QT = core network testlib
+CONFIG += console testcase benchmark
+CONFIG -= app_bundle
+
+include($$PWD/../../qt-rest.pri)
@@ -0,0 +1,53 @@
+#include <cstdlib>
+#include <atomic>
+#include "allocationcounter.h"
+
+namespace {
+
+std::atomic<quint64> allocations{0};
+
+}
+
+#if defined(Q_OS_LINUX) && defined(__GLIBC__)
+extern "C" {
+
+void *__libc_malloc(std::size_t size);
+void *__libc_calloc(std::size_t count, std::size_t size);
+void *__libc_realloc(void *ptr, std::size_t size);
+
+// glibc lets the executable interpose the allocator, so allocations made inside Qt are counted as well
+void *malloc(std::size_t size) noexcept
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	return __libc_malloc(size);
+}
+
+void *calloc(std::size_t count, std::size_t size) noexcept
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, std::size_t size) noexcept
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	return __libc_realloc(ptr, size);
+}
+
+}
+
+bool AllocationCounter::isSupported()
+{
+	return true;
+}
+#else
+bool AllocationCounter::isSupported()
+{
+	return false;
+}
+#endif
+
+quint64 AllocationCounter::count()
+{
+	return allocations.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <QtCore/QtGlobal>
+
+namespace AllocationCounter {
+
+bool isSupported();
+quint64 count();
+
+}
@@ -0,0 +1,82 @@
+#include "fakenetworkaccessmanager.h"
+#include <algorithm>
+#include <cstring>
+
+FakeNetworkAccessManager::FakeNetworkAccessManager(QObject *parent) :
+	QNetworkAccessManager{parent}
+{}
+
+void FakeNetworkAccessManager::setResponse(const QString &path, Response response)
+{
+	_responses.insert(path, std::move(response));
+}
+
+QNetworkReply *FakeNetworkAccessManager::createRequest(Operation op, const QNetworkRequest &request, QIODevice *outgoingData)
+{
+	// uploads are drained synchronously, only their cost on the sending side is of interest
+	if (outgoingData)
+		outgoingData->readAll();
+
+	static const Response notFound {404, {}, {}};
+	const auto it = _responses.constFind(request.url().path());
+	return new FakeNetworkReply{op, request, it != _responses.constEnd() ? *it : notFound, this};
+}
+
+
+
+FakeNetworkReply::FakeNetworkReply(QNetworkAccessManager::Operation op, const QNetworkRequest &request, const FakeNetworkAccessManager::Response &response, QObject *parent) :
+	QNetworkReply{parent},
+	_body{response.body}
+{
+	setOperation(op);
+	setRequest(request);
+	setUrl(request.url());
+	setAttribute(QNetworkRequest::HttpStatusCodeAttribute, response.statusCode);
+	for (auto it = response.headers.constBegin(); it != response.headers.constEnd(); ++it)
+		setRawHeader(it.key(), it.value());
+	setHeader(QNetworkRequest::ContentLengthHeader, _body.size());
+	open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+
+	QMetaObject::invokeMethod(this, "deliver", Qt::QueuedConnection);
+}
+
+void FakeNetworkReply::abort()
+{
+	if (isFinished())
+		return;
+	setError(QNetworkReply::OperationCanceledError, QStringLiteral("Operation canceled"));
+	setFinished(true);
+	emit errorOccurred(QNetworkReply::OperationCanceledError);
+	emit finished();
+}
+
+bool FakeNetworkReply::isSequential() const
+{
+	return true;
+}
+
+qint64 FakeNetworkReply::bytesAvailable() const
+{
+	return _body.size() - _offset + QNetworkReply::bytesAvailable();
+}
+
+qint64 FakeNetworkReply::readData(char *data, qint64 maxSize)
+{
+	const auto size = std::min(maxSize, _body.size() - _offset);
+	if (size == 0)
+		return isFinished() ? -1 : 0;
+	std::memcpy(data, _body.constData() + _offset, static_cast<size_t>(size));
+	_offset += size;
+	return size;
+}
+
+void FakeNetworkReply::deliver()
+{
+	if (isFinished())
+		return;
+	emit metaDataChanged();
+	if (!_body.isEmpty())
+		emit readyRead();
+	setFinished(true);
+	emit finished();
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <qtrest_global.h>
+
+#include <QtCore/QHash>
+
+#include <QtNetwork/QNetworkAccessManager>
+#include <QtNetwork/QNetworkReply>
+
+// serves canned replies from memory, so the pipeline can be measured without sockets
+class FakeNetworkAccessManager : public QNetworkAccessManager
+{
+	Q_OBJECT
+
+public:
+	struct Response {
+		int statusCode = 200;
+		QtRest::HeaderMap headers;
+		QByteArray body;
+	};
+
+	explicit FakeNetworkAccessManager(QObject *parent = nullptr);
+
+	void setResponse(const QString &path, Response response);
+
+protected:
+	QNetworkReply *createRequest(Operation op, const QNetworkRequest &request, QIODevice *outgoingData) override;
+
+private:
+	QHash<QString, Response> _responses;
+};
+
+class FakeNetworkReply : public QNetworkReply
+{
+	Q_OBJECT
+
+public:
+	FakeNetworkReply(QNetworkAccessManager::Operation op,
+					 const QNetworkRequest &request,
+					 const FakeNetworkAccessManager::Response &response,
+					 QObject *parent = nullptr);
+
+	void abort() override;
+	bool isSequential() const override;
+	qint64 bytesAvailable() const override;
+
+protected:
+	qint64 readData(char *data, qint64 maxSize) override;
+
+private Q_SLOTS:
+	void deliver();
+
+private:
+	QByteArray _body;
+	qint64 _offset = 0;
+};
@@ -0,0 +1,16 @@
+TEMPLATE = app
+
+TARGET = tst_restpipeline
+
+include(../benchmarks.pri)
+
+HEADERS += \
+	allocationcounter.h \
+	fakenetworkaccessmanager.h
+
+SOURCES += \
+	allocationcounter.cpp \
+	fakenetworkaccessmanager.cpp \
+	tst_restpipeline.cpp
+
+!load(qdep):error("Failed to load qdep feature! Run 'qdep prfgen --qmake $$QMAKE_QMAKE' to create it.")
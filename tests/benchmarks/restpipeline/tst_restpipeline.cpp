@@ -0,0 +1,395 @@
+#include <QtTest>
+#include <restbuilder.h>
+#include <jsoncontenthandler.h>
+#include <cborcontenthandler.h>
+#include "allocationcounter.h"
+#include "fakenetworkaccessmanager.h"
+using namespace QtRest;
+
+template <typename T>
+class DummyContentHandler;
+
+template <>
+struct ContentHandlerArgs<DummyContentHandler> {
+	static const QByteArray ContentType;
+};
+
+const QByteArray ContentHandlerArgs<DummyContentHandler>::ContentType = "application/x-dummy";
+
+// does no parsing at all, so only the cost of finding the handler is measured
+template <typename T>
+class DummyContentHandler : public IByteArrayContentHandler<T>
+{
+public:
+	using WriteResult = typename IByteArrayContentHandler<T>::WriteResult;
+
+	DummyContentHandler(ContentHandlerArgs<DummyContentHandler>) {}
+
+	QByteArrayList contentTypes() const override {
+		return {ContentHandlerArgs<DummyContentHandler>::ContentType, "application/x-dummy-alias"};
+	}
+
+	WriteResult write(const T &) override {
+		return {};
+	}
+
+	T read(const QByteArray &, const QByteArray &, QTextCodec *) override {
+		return T{};
+	}
+};
+
+class RestPipelineBenchmark : public QObject
+{
+	Q_OBJECT
+
+private Q_SLOTS:
+	void initTestCase();
+
+	void benchBuild_data();
+	void benchBuild();
+	void benchSend_data();
+	void benchSend();
+	void benchReplyMetadata_data();
+	void benchReplyMetadata();
+	void benchJsonBody_data();
+	void benchJsonBody();
+	void benchCborBody_data();
+	void benchCborBody();
+	void benchFindHandler_data();
+	void benchFindHandler();
+	void benchReadJson_data();
+	void benchReadJson();
+	void benchWriteJson_data();
+	void benchWriteJson();
+
+private:
+	static const QUrl BaseUrl;
+	// about 10 MB of compact JSON
+	static constexpr int LargeArraySize = 125000;
+
+	FakeNetworkAccessManager *_nam = nullptr;
+	QHash<QString, FakeNetworkAccessManager::Response> _responses;
+	QJsonObject _smallObject;
+	QJsonArray _largeArray;
+	HeaderMap _manyHeaders;
+
+	RestBuilder builder(const QString &path) const;
+	QNetworkReply *finishedReply(const QString &path);
+	void addPayloadRows();
+
+	static int iterationsFor(qint64 bytes);
+	static void report(const std::function<void()> &operation, int iterations);
+};
+
+const QUrl RestPipelineBenchmark::BaseUrl {QStringLiteral("http://bench.local")};
+
+void RestPipelineBenchmark::initTestCase()
+{
+	if (!AllocationCounter::isSupported())
+		qWarning() << "Allocations can only be counted on glibc based systems";
+
+	_smallObject = QJsonObject {
+		{QStringLiteral("id"), 42},
+		{QStringLiteral("name"), QStringLiteral("qt-rest")},
+		{QStringLiteral("active"), true},
+		{QStringLiteral("score"), 4.5},
+		{QStringLiteral("tags"), QJsonArray{QStringLiteral("json"), QStringLiteral("cbor"), QStringLiteral("rest")}}
+	};
+	for (auto i = 0; i < LargeArraySize; ++i) {
+		auto object = _smallObject;
+		object[QStringLiteral("id")] = i;
+		_largeArray.append(object);
+	}
+	for (auto i = 0; i < 50; ++i)
+		_manyHeaders.insert("X-Header-" + QByteArray::number(i), "value-" + QByteArray::number(i));
+
+	const HeaderMap jsonHeaders {{"Content-Type", ContentHandlerArgs<JsonContentHandler>::ContentType}};
+	const HeaderMap cborHeaders {{"Content-Type", ContentHandlerArgs<CborContentHandler>::ContentType}};
+	auto manyHeaders = _manyHeaders;
+	manyHeaders.insert("Content-Type", ContentHandlerArgs<JsonContentHandler>::ContentType);
+	_responses.insert(QStringLiteral("small.json"), {200, jsonHeaders, QJsonDocument{_smallObject}.toJson(QJsonDocument::Compact)});
+	_responses.insert(QStringLiteral("large.json"), {200, jsonHeaders, QJsonDocument{_largeArray}.toJson(QJsonDocument::Compact)});
+	_responses.insert(QStringLiteral("small.cbor"), {200, cborHeaders, QCborValue::fromJsonValue(_smallObject).toCbor()});
+	_responses.insert(QStringLiteral("large.cbor"), {200, cborHeaders, QCborValue::fromJsonValue(_largeArray).toCbor()});
+	_responses.insert(QStringLiteral("headers"), {200, manyHeaders, QJsonDocument{_smallObject}.toJson(QJsonDocument::Compact)});
+
+	_nam = new FakeNetworkAccessManager{this};
+	for (auto it = _responses.constBegin(); it != _responses.constEnd(); ++it)
+		_nam->setResponse(QLatin1Char('/') + it.key(), *it);
+}
+
+void RestPipelineBenchmark::benchBuild_data()
+{
+	QTest::addColumn<bool>("prepared");
+	QTest::addColumn<bool>("manyHeaders");
+
+	QTest::newRow("plain") << false << false;
+	QTest::newRow("prepared") << true << false;
+	QTest::newRow("manyHeaders") << false << true;
+	QTest::newRow("preparedManyHeaders") << true << true;
+}
+
+void RestPipelineBenchmark::benchBuild()
+{
+	QFETCH(bool, prepared);
+	QFETCH(bool, manyHeaders);
+
+	auto restBuilder = builder(QStringLiteral("items"));
+	if (manyHeaders)
+		restBuilder.addHeaders(_manyHeaders);
+	if (prepared)
+		restBuilder.prepare();
+	restBuilder.addPath(QStringLiteral("42"))
+		.addParameter(QStringLiteral("expand"), QStringLiteral("all"));
+
+	QBENCHMARK {
+		restBuilder.build();
+	}
+	report([&]() {
+		restBuilder.build();
+	}, 1000);
+}
+
+void RestPipelineBenchmark::benchSend_data()
+{
+	addPayloadRows();
+	QTest::newRow("manyHeaders") << QStringLiteral("headers");
+}
+
+void RestPipelineBenchmark::benchSend()
+{
+	QFETCH(QString, path);
+
+	const auto restBuilder = builder(path);
+	const auto roundTrip = [&]() {
+		const auto reply = restBuilder.send();
+		while (!reply->isFinished())
+			QCoreApplication::processEvents();
+		reply->readAll();
+		delete reply;
+	};
+
+	QBENCHMARK {
+		roundTrip();
+	}
+	report(roundTrip, iterationsFor(_responses[path].body.size()));
+}
+
+void RestPipelineBenchmark::benchReplyMetadata_data()
+{
+	QTest::addColumn<QString>("path");
+
+	QTest::newRow("small") << QStringLiteral("small.json");
+	QTest::newRow("manyHeaders") << QStringLiteral("headers");
+}
+
+void RestPipelineBenchmark::benchReplyMetadata()
+{
+	QFETCH(QString, path);
+
+	// every iteration needs a fresh reply, as the parsed metadata is cached per reply
+	const QNetworkRequest request{BaseUrl.resolved(QUrl{path})};
+	const auto response = _responses[path];
+	const auto parseMetadata = [&]() {
+		RawRestReply reply{new FakeNetworkReply{QNetworkAccessManager::GetOperation, request, response}};
+		reply.statusCode();
+		reply.contentType();
+		reply.contentCodec();
+		reply.contentLength();
+		reply.header(QLatin1String{"X-Header-42"});
+	};
+
+	QBENCHMARK {
+		parseMetadata();
+	}
+	report(parseMetadata, 1000);
+	QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+}
+
+void RestPipelineBenchmark::benchJsonBody_data()
+{
+	QTest::addColumn<QString>("path");
+
+	QTest::newRow("small") << QStringLiteral("small.json");
+	QTest::newRow("large") << QStringLiteral("large.json");
+}
+
+void RestPipelineBenchmark::benchJsonBody()
+{
+	QFETCH(QString, path);
+
+	RestReply<JsonContentHandler> reply{std::make_tuple(ContentHandlerArgs<JsonContentHandler>{}), finishedReply(path)};
+	reply.bufferBody();
+
+	QBENCHMARK {
+		reply.body<QJsonValue>();
+	}
+	report([&]() {
+		reply.body<QJsonValue>();
+	}, iterationsFor(_responses[path].body.size()));
+}
+
+void RestPipelineBenchmark::benchCborBody_data()
+{
+	QTest::addColumn<QString>("path");
+
+	QTest::newRow("small") << QStringLiteral("small.cbor");
+	QTest::newRow("large") << QStringLiteral("large.cbor");
+}
+
+void RestPipelineBenchmark::benchCborBody()
+{
+	QFETCH(QString, path);
+
+	RestReply<CborContentHandler> reply{std::make_tuple(ContentHandlerArgs<CborContentHandler>{}), finishedReply(path)};
+	reply.bufferBody();
+
+	QBENCHMARK {
+		reply.body<QCborValue>();
+	}
+	report([&]() {
+		reply.body<QCborValue>();
+	}, iterationsFor(_responses[path].body.size()));
+}
+
+void RestPipelineBenchmark::benchFindHandler_data()
+{
+	QTest::addColumn<QByteArray>("contentType");
+
+	QTest::newRow("table") << ContentHandlerArgs<DummyContentHandler>::ContentType;
+	QTest::newRow("fallback") << QByteArray{"application/x-dummy-alias"};
+}
+
+void RestPipelineBenchmark::benchFindHandler()
+{
+	QFETCH(QByteArray, contentType);
+
+	const RestReply<JsonContentHandler, DummyContentHandler> reply{std::make_tuple(
+		ContentHandlerArgs<JsonContentHandler>{},
+		ContentHandlerArgs<DummyContentHandler>{}
+	)};
+
+	QBENCHMARK {
+		reply.decode<QJsonValue>(QByteArray{}, contentType);
+	}
+	report([&]() {
+		reply.decode<QJsonValue>(QByteArray{}, contentType);
+	}, 1000);
+}
+
+void RestPipelineBenchmark::benchReadJson_data()
+{
+	QTest::addColumn<QString>("path");
+	QTest::addColumn<bool>("viaString");
+
+	// the string rows replay the former QString round trip of the JSON handler
+	QTest::newRow("small/bytes") << QStringLiteral("small.json") << false;
+	QTest::newRow("small/string") << QStringLiteral("small.json") << true;
+	QTest::newRow("large/bytes") << QStringLiteral("large.json") << false;
+	QTest::newRow("large/string") << QStringLiteral("large.json") << true;
+}
+
+void RestPipelineBenchmark::benchReadJson()
+{
+	QFETCH(QString, path);
+	QFETCH(bool, viaString);
+
+	const auto data = _responses[path].body;
+	const auto read = [&]() {
+		if (viaString)
+			QtJson::readJson(QString::fromUtf8(data));
+		else
+			__private::readJsonData(data, ContentHandlerArgs<JsonContentHandler>::ContentType, nullptr);
+	};
+
+	QBENCHMARK {
+		read();
+	}
+	report(read, iterationsFor(data.size()));
+}
+
+void RestPipelineBenchmark::benchWriteJson_data()
+{
+	QTest::addColumn<bool>("large");
+	QTest::addColumn<bool>("viaString");
+
+	QTest::newRow("small/bytes") << false << false;
+	QTest::newRow("small/string") << false << true;
+	QTest::newRow("large/bytes") << true << false;
+	QTest::newRow("large/string") << true << true;
+}
+
+void RestPipelineBenchmark::benchWriteJson()
+{
+	QFETCH(bool, large);
+	QFETCH(bool, viaString);
+
+	const auto value = large ? QJsonValue{_largeArray} : QJsonValue{_smallObject};
+	const auto write = [&]() {
+		if (viaString)
+			QtJson::writeJson(value, QJsonDocument::Compact).toUtf8();
+		else
+			__private::writeJsonData(value, QJsonDocument::Compact);
+	};
+
+	QBENCHMARK {
+		write();
+	}
+	report(write, large ? 3 : 1000);
+}
+
+RestBuilder RestPipelineBenchmark::builder(const QString &path) const
+{
+	return RestBuilder{}
+		.setBaseUrl(BaseUrl)
+		.setNetworkAccessManager(_nam)
+		.addPath(path);
+}
+
+QNetworkReply *RestPipelineBenchmark::finishedReply(const QString &path)
+{
+	const auto reply = _nam->get(QNetworkRequest{BaseUrl.resolved(QUrl{path})});
+	while (!reply->isFinished())
+		QCoreApplication::processEvents();
+	return reply;
+}
+
+void RestPipelineBenchmark::addPayloadRows()
+{
+	QTest::addColumn<QString>("path");
+
+	QTest::newRow("json/small") << QStringLiteral("small.json");
+	QTest::newRow("json/large") << QStringLiteral("large.json");
+	QTest::newRow("cbor/small") << QStringLiteral("small.cbor");
+	QTest::newRow("cbor/large") << QStringLiteral("large.cbor");
+}
+
+int RestPipelineBenchmark::iterationsFor(qint64 bytes)
+{
+	return static_cast<int>(qBound<qint64>(3, 10000000 / qMax<qint64>(bytes, 1), 1000));
+}
+
+void RestPipelineBenchmark::report(const std::function<void()> &operation, int iterations)
+{
+	// QBENCHMARK only reports the time, allocations and throughput are measured in a second pass
+	QElapsedTimer timer;
+	const auto allocations = AllocationCounter::count();
+	timer.start();
+	for (auto i = 0; i < iterations; ++i)
+		operation();
+	const auto elapsed = static_cast<double>(timer.nsecsElapsed());
+	const auto allocated = static_cast<double>(AllocationCounter::count() - allocations);
+
+	const auto nsPerOp = elapsed / iterations;
+	qInfo().noquote() << QStringLiteral("%1: %2 ns/op, %3 allocations/op, %4 ops/sec")
+						 .arg(QString::fromUtf8(QTest::currentDataTag()))
+						 .arg(nsPerOp, 0, 'f', 0)
+						 .arg(AllocationCounter::isSupported() ?
+								  QString::number(allocated / iterations, 'f', 1) :
+								  QStringLiteral("n/a"))
+						 .arg(1e9 / nsPerOp, 0, 'f', 1);
+}
+
+QTEST_GUILESS_MAIN(RestPipelineBenchmark)
+
+#include "tst_restpipeline.moc"
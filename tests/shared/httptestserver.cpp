@@ -0,0 +1,407 @@
+#include "httptestserver.h"
+#include <algorithm>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonArray>
+#include <QtCore/QTimer>
+#ifndef QT_NO_SSL
+#include <QtNetwork/QSslSocket>
+#endif
+using namespace std::chrono;
+
+namespace {
+
+QByteArray reasonPhrase(int statusCode)
+{
+	switch (statusCode) {
+	case 200:
+		return "OK";
+	case 204:
+		return "No Content";
+	case 206:
+		return "Partial Content";
+	case 304:
+		return "Not Modified";
+	case 400:
+		return "Bad Request";
+	case 404:
+		return "Not Found";
+	case 416:
+		return "Range Not Satisfiable";
+	case 429:
+		return "Too Many Requests";
+	case 500:
+		return "Internal Server Error";
+	case 502:
+		return "Bad Gateway";
+	case 503:
+		return "Service Unavailable";
+	case 504:
+		return "Gateway Timeout";
+	default:
+		return "Unknown";
+	}
+}
+
+}
+
+HttpTestServer::Response HttpTestServer::Response::json(const QJsonValue &value, int statusCode)
+{
+	Response response;
+	response.statusCode = statusCode;
+	response.headers.insert("Content-Type", "application/json");
+	switch (value.type()) {
+	case QJsonValue::Object:
+		response.body = QJsonDocument{value.toObject()}.toJson(QJsonDocument::Compact);
+		break;
+	case QJsonValue::Array:
+		response.body = QJsonDocument{value.toArray()}.toJson(QJsonDocument::Compact);
+		break;
+	default: {
+		// QJsonDocument cannot hold scalars, so they are written as a single element array
+		const auto array = QJsonDocument{QJsonArray{value}}.toJson(QJsonDocument::Compact);
+		response.body = array.mid(1, array.size() - 2);
+		break;
+	}
+	}
+	return response;
+}
+
+HttpTestServer::Response HttpTestServer::Response::cbor(const QCborValue &value, int statusCode)
+{
+	Response response;
+	response.statusCode = statusCode;
+	response.headers.insert("Content-Type", "application/cbor");
+	response.body = value.toCbor();
+	return response;
+}
+
+HttpTestServer::Response HttpTestServer::Response::status(int statusCode)
+{
+	Response response;
+	response.statusCode = statusCode;
+	return response;
+}
+
+HttpTestServer::HttpTestServer(QObject *parent) :
+	QTcpServer{parent}
+{}
+
+#ifndef QT_NO_SSL
+void HttpTestServer::setSslConfiguration(const QSslConfiguration &sslConfiguration)
+{
+	_sslConfiguration = sslConfiguration;
+}
+#endif
+
+bool HttpTestServer::start(quint16 port)
+{
+	return listen(QHostAddress::LocalHost, port);
+}
+
+QUrl HttpTestServer::url(const QString &path) const
+{
+	QUrl url;
+#ifndef QT_NO_SSL
+	url.setScheme(_sslConfiguration ? QStringLiteral("https") : QStringLiteral("http"));
+#else
+	url.setScheme(QStringLiteral("http"));
+#endif
+	url.setHost(serverAddress().toString());
+	url.setPort(serverPort());
+	url.setPath(path.startsWith(QLatin1Char('/')) ? path : QLatin1Char('/') + path);
+	return url;
+}
+
+void HttpTestServer::addRoute(const QByteArray &path, Response response)
+{
+	addRoute(path, [response](const Request &) {
+		return response;
+	});
+}
+
+void HttpTestServer::addRoute(const QByteArray &path, Handler handler)
+{
+	_routes.insert(path, std::move(handler));
+}
+
+void HttpTestServer::addFailureBurst(const QByteArray &path, int count, int statusCode)
+{
+	_failureBursts.insert(path, FailureBurst{count, statusCode});
+}
+
+void HttpTestServer::setDefaultLatency(milliseconds latency)
+{
+	_defaultLatency = latency;
+}
+
+void HttpTestServer::setDefaultBytesPerSecond(qint64 bytesPerSecond)
+{
+	_defaultBytesPerSecond = bytesPerSecond;
+}
+
+int HttpTestServer::requestCount(const QByteArray &path) const
+{
+	return _requests.value(path).size();
+}
+
+QList<HttpTestServer::Request> HttpTestServer::requests(const QByteArray &path) const
+{
+	return _requests.value(path);
+}
+
+int HttpTestServer::connectionCount() const
+{
+	return _connectionCount;
+}
+
+void HttpTestServer::clearRequests()
+{
+	_requests.clear();
+	_connectionCount = 0;
+}
+
+HttpTestServer::Response HttpTestServer::respond(const Request &request)
+{
+	_requests[request.path].append(request);
+	emit requestReceived(request.path);
+
+	Response response;
+	if (auto burst = _failureBursts.find(request.path); burst != _failureBursts.end() && burst->remaining > 0) {
+		--burst->remaining;
+		response = Response::status(burst->statusCode);
+	} else if (const auto route = _routes.constFind(request.path); route != _routes.constEnd())
+		response = (*route)(request);
+	else
+		response = Response::status(404);
+
+	if (response.latency == milliseconds::zero())
+		response.latency = _defaultLatency;
+	if (response.bytesPerSecond == 0)
+		response.bytesPerSecond = _defaultBytesPerSecond;
+	return response;
+}
+
+void HttpTestServer::incomingConnection(qintptr socketDescriptor)
+{
+	QTcpSocket *socket = nullptr;
+#ifndef QT_NO_SSL
+	if (_sslConfiguration) {
+		const auto sslSocket = new QSslSocket{};
+		if (!sslSocket->setSocketDescriptor(socketDescriptor)) {
+			delete sslSocket;
+			return;
+		}
+		sslSocket->setSslConfiguration(*_sslConfiguration);
+		sslSocket->startServerEncryption();
+		socket = sslSocket;
+	} else
+#endif
+	{
+		socket = new QTcpSocket{};
+		if (!socket->setSocketDescriptor(socketDescriptor)) {
+			delete socket;
+			return;
+		}
+	}
+
+	++_connectionCount;
+	new HttpTestConnection{socket, this};
+}
+
+
+
+HttpTestConnection::HttpTestConnection(QTcpSocket *socket, HttpTestServer *server) :
+	QObject{server},
+	_socket{socket},
+	_server{server}
+{
+	_socket->setParent(this);
+	connect(_socket, &QTcpSocket::readyRead,
+			this, &HttpTestConnection::readRequest);
+	connect(_socket, &QTcpSocket::disconnected,
+			this, &HttpTestConnection::deleteLater);
+}
+
+void HttpTestConnection::readRequest()
+{
+	_buffer.append(_socket->readAll());
+	// requests are answered in order, pipelined ones wait until the current response is done
+	while (!_responding) {
+		if (!_request && !parseHead())
+			return;
+		if (!parseBody())
+			return;
+
+		const auto request = std::move(*_request);
+		_request.reset();
+		_responding = true;
+		_closeAfterResponse = request.headers.value("connection").toLower() == "close";
+		const auto response = _server->respond(request);
+		QTimer::singleShot(response.latency, this, [this, response, isHead = request.method == "HEAD"]() {
+			startResponse(response, isHead);
+		});
+	}
+}
+
+bool HttpTestConnection::parseHead()
+{
+	const auto end = _buffer.indexOf("\r\n\r\n");
+	if (end < 0)
+		return false;
+	const auto lines = _buffer.left(end).split('\n');
+	_buffer.remove(0, end + 4);
+
+	HttpTestServer::Request request;
+	const auto requestLine = lines.first().trimmed().split(' ');
+	request.method = requestLine.value(0);
+	const QUrl target{QString::fromLatin1(requestLine.value(1))};
+	request.path = target.path(QUrl::FullyEncoded).toLatin1();
+	request.query = QUrlQuery{target};
+	for (auto i = 1; i < lines.size(); ++i) {
+		const auto &line = lines[i];
+		if (const auto colon = line.indexOf(':'); colon > 0)
+			request.headers.insert(line.left(colon).trimmed().toLower(), line.mid(colon + 1).trimmed());
+	}
+
+	_chunkedBody = request.headers.value("transfer-encoding").toLower() == "chunked";
+	_bodyLength = request.headers.value("content-length").toLongLong();
+	_request = std::move(request);
+	return true;
+}
+
+bool HttpTestConnection::parseBody()
+{
+	if (_chunkedBody)
+		return parseChunkedBody();
+	if (_buffer.size() < _bodyLength)
+		return false;
+
+	_request->body = _buffer.left(static_cast<int>(_bodyLength));
+	_buffer.remove(0, static_cast<int>(_bodyLength));
+	return true;
+}
+
+bool HttpTestConnection::parseChunkedBody()
+{
+	forever {
+		const auto lineEnd = _buffer.indexOf("\r\n");
+		if (lineEnd < 0)
+			return false;
+		auto ok = false;
+		const auto size = static_cast<int>(_buffer.left(lineEnd).split(';').first().trimmed().toLongLong(&ok, 16));
+		if (!ok) {
+			_socket->abort();
+			return false;
+		}
+
+		// trailers are not supported, the last chunk is followed by an empty line
+		if (size == 0) {
+			if (_buffer.size() < lineEnd + 4)
+				return false;
+			_buffer.remove(0, lineEnd + 4);
+			return true;
+		}
+		if (_buffer.size() < lineEnd + 2 + size + 2)
+			return false;
+		_request->body.append(_buffer.mid(lineEnd + 2, size));
+		_buffer.remove(0, lineEnd + 2 + size + 2);
+	}
+}
+
+void HttpTestConnection::startResponse(const HttpTestServer::Response &response, bool isHead)
+{
+	using Fault = HttpTestServer::Response::Fault;
+	if (response.fault == Fault::Reset) {
+		_socket->abort();
+		deleteLater();
+		return;
+	}
+
+	const auto chunked = response.chunkSize > 0 || !response.chunks.isEmpty();
+	QByteArray head = "HTTP/1.1 " + QByteArray::number(response.statusCode) + ' ' + reasonPhrase(response.statusCode) + "\r\n";
+	for (auto it = response.headers.constBegin(); it != response.headers.constEnd(); ++it)
+		head += it.key() + ": " + it.value() + "\r\n";
+	if (chunked)
+		head += "Transfer-Encoding: chunked\r\n";
+	else if (!response.headers.contains("Content-Length"))
+		head += "Content-Length: " + QByteArray::number(response.body.size()) + "\r\n";
+	if (_closeAfterResponse)
+		head += "Connection: close\r\n";
+	head += "\r\n";
+
+	_segments = QByteArrayList{head};
+	_segmentInterval = response.chunkInterval;
+	_abortAfterSegments = response.fault != Fault::None;
+	_keepOpen = response.keepOpen;
+	const auto hasBody = !isHead && response.statusCode != 204 && response.statusCode != 304;
+	if (hasBody && response.fault != Fault::ResetAfterHeaders) {
+		auto pieces = response.chunks;
+		if (pieces.isEmpty()) {
+			auto sliceSize = response.body.size();
+			if (response.chunkSize > 0)
+				sliceSize = response.chunkSize;
+			else if (response.bytesPerSecond > 0)
+				sliceSize = static_cast<int>(std::max<qint64>(1, response.bytesPerSecond / 20));
+			for (auto i = 0; i < response.body.size(); i += sliceSize)
+				pieces.append(response.body.mid(i, sliceSize));
+		}
+		if (response.bytesPerSecond > 0 && !pieces.isEmpty()) {
+			const milliseconds pieceTime(pieces.first().size() * 1000 / response.bytesPerSecond);
+			_segmentInterval = std::max(_segmentInterval, pieceTime);
+		}
+
+		if (response.fault == Fault::ResetMidBody) {
+			auto remaining = response.body.size() / 2;
+			for (auto it = pieces.begin(); it != pieces.end(); ++it) {
+				if (remaining <= 0) {
+					pieces.erase(it, pieces.end());
+					break;
+				}
+				if (it->size() > remaining)
+					it->truncate(remaining);
+				remaining -= it->size();
+			}
+		}
+
+		for (const auto &piece : qAsConst(pieces)) {
+			if (piece.isEmpty())
+				continue;
+			_segments.append(chunked ?
+								 QByteArray::number(piece.size(), 16) + "\r\n" + piece + "\r\n" :
+								 piece);
+		}
+		if (chunked && !_keepOpen && response.fault == Fault::None)
+			_segments.append("0\r\n\r\n");
+	}
+
+	writeNext();
+}
+
+void HttpTestConnection::writeNext()
+{
+	if (!_segments.isEmpty())
+		_socket->write(_segments.takeFirst());
+	if (_segments.isEmpty())
+		finishResponse();
+	else
+		QTimer::singleShot(_segmentInterval, this, &HttpTestConnection::writeNext);
+}
+
+void HttpTestConnection::finishResponse()
+{
+	if (_abortAfterSegments) {
+		_socket->flush();
+		_socket->abort();
+		deleteLater();
+		return;
+	} else if (_keepOpen)
+		return;
+	else if (_closeAfterResponse) {
+		_socket->disconnectFromHost();
+		return;
+	}
+
+	_responding = false;
+	if (!_buffer.isEmpty())
+		QMetaObject::invokeMethod(this, &HttpTestConnection::readRequest, Qt::QueuedConnection);
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <optional>
+
+#include <QtCore/QHash>
+#include <QtCore/QJsonValue>
+#include <QtCore/QCborValue>
+#include <QtCore/QUrl>
+#include <QtCore/QUrlQuery>
+
+#include <QtNetwork/QTcpServer>
+#include <QtNetwork/QTcpSocket>
+#ifndef QT_NO_SSL
+#include <QtNetwork/QSslConfiguration>
+#endif
+
+// a minimal HTTP/1.1 server on the loopback interface with latency and fault injection
+class HttpTestServer : public QTcpServer
+{
+	Q_OBJECT
+
+public:
+	using HeaderMap = QHash<QByteArray, QByteArray>;
+
+	struct Request {
+		QByteArray method;
+		QByteArray path;
+		QUrlQuery query;
+		// header names are lower case
+		HeaderMap headers;
+		QByteArray body;
+	};
+
+	struct Response {
+		enum class Fault {
+			None,
+			// closes the connection without answering
+			Reset,
+			// sends the headers, then closes the connection
+			ResetAfterHeaders,
+			// sends half of the body, then closes the connection
+			ResetMidBody
+		};
+
+		int statusCode = 200;
+		HeaderMap headers;
+		QByteArray body;
+		// the body is sent with chunked transfer encoding when set
+		int chunkSize = 0;
+		// explicit chunks, sent one by one with chunked transfer encoding
+		QByteArrayList chunks;
+		std::chrono::milliseconds latency {0};
+		std::chrono::milliseconds chunkInterval {0};
+		// limits the body transfer rate, 0 is unlimited
+		qint64 bytesPerSecond = 0;
+		// the stream is never terminated, the client has to close it
+		bool keepOpen = false;
+		Fault fault = Fault::None;
+
+		static Response json(const QJsonValue &value, int statusCode = 200);
+		static Response cbor(const QCborValue &value, int statusCode = 200);
+		static Response status(int statusCode);
+	};
+
+	using Handler = std::function<Response(const Request &)>;
+
+	explicit HttpTestServer(QObject *parent = nullptr);
+
+#ifndef QT_NO_SSL
+	void setSslConfiguration(const QSslConfiguration &sslConfiguration);
+#endif
+	bool start(quint16 port = 0);
+	QUrl url(const QString &path = {}) const;
+
+	void addRoute(const QByteArray &path, Response response);
+	void addRoute(const QByteArray &path, Handler handler);
+	void addFailureBurst(const QByteArray &path, int count, int statusCode = 503);
+	void setDefaultLatency(std::chrono::milliseconds latency);
+	void setDefaultBytesPerSecond(qint64 bytesPerSecond);
+
+	int requestCount(const QByteArray &path) const;
+	QList<Request> requests(const QByteArray &path) const;
+	int connectionCount() const;
+	void clearRequests();
+
+	Response respond(const Request &request);
+
+Q_SIGNALS:
+	void requestReceived(const QByteArray &path);
+
+protected:
+	void incomingConnection(qintptr socketDescriptor) override;
+
+private:
+	struct FailureBurst {
+		int remaining = 0;
+		int statusCode = 503;
+	};
+
+	QHash<QByteArray, Handler> _routes;
+	QHash<QByteArray, FailureBurst> _failureBursts;
+	QHash<QByteArray, QList<Request>> _requests;
+	std::chrono::milliseconds _defaultLatency {0};
+	qint64 _defaultBytesPerSecond = 0;
+	int _connectionCount = 0;
+#ifndef QT_NO_SSL
+	std::optional<QSslConfiguration> _sslConfiguration;
+#endif
+};
+
+class HttpTestConnection : public QObject
+{
+	Q_OBJECT
+
+public:
+	HttpTestConnection(QTcpSocket *socket, HttpTestServer *server);
+
+private Q_SLOTS:
+	void readRequest();
+
+private:
+	QTcpSocket *_socket;
+	HttpTestServer *_server;
+	QByteArray _buffer;
+	std::optional<HttpTestServer::Request> _request;
+	qint64 _bodyLength = 0;
+	bool _chunkedBody = false;
+	bool _closeAfterResponse = false;
+	bool _responding = false;
+	QByteArrayList _segments;
+	std::chrono::milliseconds _segmentInterval {0};
+	bool _abortAfterSegments = false;
+	bool _keepOpen = false;
+
+	bool parseHead();
+	bool parseBody();
+	bool parseChunkedBody();
+	void startResponse(const HttpTestServer::Response &response, bool isHead);
+	void writeNext();
+	void finishResponse();
+};
@@ -0,0 +1,7 @@
+HEADERS += \
+	$$PWD/httptestserver.h
+
+SOURCES += \
+	$$PWD/httptestserver.cpp
+
+INCLUDEPATH += $$PWD
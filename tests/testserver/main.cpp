@@ -0,0 +1,199 @@
+#include <QtCore/QCoreApplication>
+#include <QtCore/QCommandLineParser>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonObject>
+#include <QtCore/QJsonDocument>
+#ifndef QT_NO_SSL
+#include <QtNetwork/QSslCertificate>
+#include <QtNetwork/QSslKey>
+#endif
+#include "httptestserver.h"
+using namespace std::chrono;
+using Response = HttpTestServer::Response;
+
+namespace {
+
+QJsonObject smallObject(int id = 42)
+{
+	return QJsonObject {
+		{QStringLiteral("id"), id},
+		{QStringLiteral("name"), QStringLiteral("qt-rest")},
+		{QStringLiteral("active"), true},
+		{QStringLiteral("score"), 4.5},
+		{QStringLiteral("tags"), QJsonArray{QStringLiteral("json"), QStringLiteral("cbor"), QStringLiteral("rest")}}
+	};
+}
+
+QJsonArray largeArray()
+{
+	// about 10 MB of compact JSON
+	QJsonArray array;
+	for (auto i = 0; i < 125000; ++i)
+		array.append(smallObject(i));
+	return array;
+}
+
+bool addFixtures(HttpTestServer &server, const QString &directory)
+{
+	const QDir dir{directory};
+	if (!dir.exists())
+		return false;
+
+	for (const auto &info : dir.entryInfoList(QDir::Files)) {
+		QFile file{info.absoluteFilePath()};
+		if (!file.open(QIODevice::ReadOnly)) {
+			qWarning().noquote() << "Skipping fixture" << file.fileName() << "-" << file.errorString();
+			continue;
+		}
+
+		Response response;
+		response.body = file.readAll();
+		if (info.suffix() == QStringLiteral("json"))
+			response.headers.insert("Content-Type", "application/json");
+		else if (info.suffix() == QStringLiteral("cbor"))
+			response.headers.insert("Content-Type", "application/cbor");
+		else
+			response.headers.insert("Content-Type", "application/octet-stream");
+		server.addRoute("/fixtures/" + info.fileName().toUtf8(), response);
+	}
+	return true;
+}
+
+void addRoutes(HttpTestServer &server, int failureRate)
+{
+	const auto small = smallObject();
+	const auto large = largeArray();
+
+	server.addRoute("/json/small", Response::json(small));
+	server.addRoute("/json/large", Response::json(large));
+	server.addRoute("/cbor/small", Response::cbor(QCborValue::fromJsonValue(small)));
+	server.addRoute("/cbor/large", Response::cbor(QCborValue::fromJsonValue(large)));
+
+	auto chunked = Response::json(large);
+	chunked.chunkSize = 16 * 1024;
+	server.addRoute("/json/chunked", chunked);
+
+	auto slow = Response::json(small);
+	slow.latency = milliseconds{500};
+	server.addRoute("/slow", slow);
+
+	auto throttled = Response::json(large);
+	throttled.bytesPerSecond = 1024 * 1024;
+	server.addRoute("/throttled", throttled);
+
+	auto reset = Response::json(small);
+	reset.fault = Response::Fault::Reset;
+	server.addRoute("/reset", reset);
+
+	auto resetMidBody = Response::json(large);
+	resetMidBody.fault = Response::Fault::ResetMidBody;
+	server.addRoute("/reset-mid-body", resetMidBody);
+
+	// every n-th request fails
+	server.addRoute("/flaky", [small, failureRate, counter = 0](const HttpTestServer::Request &) mutable {
+		return ++counter % failureRate == 0 ?
+			Response::status(503) :
+			Response::json(small);
+	});
+
+	// the first 5 of every 20 requests fail
+	server.addRoute("/burst", [small, counter = 0](const HttpTestServer::Request &) mutable {
+		return counter++ % 20 < 5 ?
+			Response::status(503) :
+			Response::json(small);
+	});
+
+	Response events;
+	events.headers.insert("Content-Type", "text/event-stream");
+	events.chunkInterval = milliseconds{100};
+	for (auto i = 0; i < 10; ++i) {
+		events.chunks.append("id: " + QByteArray::number(i) + "\ndata: " +
+							 QJsonDocument{smallObject(i)}.toJson(QJsonDocument::Compact) + "\n\n");
+	}
+	server.addRoute("/events", events);
+
+	Response ndjson;
+	ndjson.headers.insert("Content-Type", "application/x-ndjson");
+	ndjson.chunkInterval = milliseconds{10};
+	for (auto i = 0; i < 1000; ++i)
+		ndjson.chunks.append(QJsonDocument{smallObject(i)}.toJson(QJsonDocument::Compact) + '\n');
+	server.addRoute("/ndjson", ndjson);
+
+	server.addRoute("/echo", [](const HttpTestServer::Request &request) {
+		Response response;
+		response.headers.insert("Content-Type", request.headers.value("content-type", "application/octet-stream"));
+		response.body = request.body;
+		return response;
+	});
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication app{argc, argv};
+	QCoreApplication::setApplicationName(QStringLiteral("qtrest-testserver"));
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription(QStringLiteral("Loopback HTTP server with latency and fault injection for qt-rest load tests."));
+	parser.addHelpOption();
+	parser.addOptions({
+		{{QStringLiteral("p"), QStringLiteral("port")},
+		 QStringLiteral("Listen on <port>, 0 picks a free one."),
+		 QStringLiteral("port"), QStringLiteral("8080")},
+		{{QStringLiteral("f"), QStringLiteral("fixtures")},
+		 QStringLiteral("Serve every file in <directory> as /fixtures/<name>."),
+		 QStringLiteral("directory")},
+		{{QStringLiteral("l"), QStringLiteral("latency")},
+		 QStringLiteral("Delay every response by <ms> milliseconds."),
+		 QStringLiteral("ms"), QStringLiteral("0")},
+		{{QStringLiteral("b"), QStringLiteral("bandwidth")},
+		 QStringLiteral("Limit every response to <bytes> per second."),
+		 QStringLiteral("bytes"), QStringLiteral("0")},
+		{QStringLiteral("failure-rate"),
+		 QStringLiteral("Answer every <n>-th request to /flaky with 503."),
+		 QStringLiteral("n"), QStringLiteral("4")},
+#ifndef QT_NO_SSL
+		{QStringLiteral("ssl-cert"),
+		 QStringLiteral("Serve HTTPS with the PEM certificate in <file>, requires --ssl-key."),
+		 QStringLiteral("file")},
+		{QStringLiteral("ssl-key"),
+		 QStringLiteral("The PEM encoded RSA private key for --ssl-cert."),
+		 QStringLiteral("file")},
+#endif
+	});
+	parser.process(app);
+
+	HttpTestServer server;
+	server.setDefaultLatency(milliseconds{parser.value(QStringLiteral("latency")).toInt()});
+	server.setDefaultBytesPerSecond(parser.value(QStringLiteral("bandwidth")).toLongLong());
+	addRoutes(server, std::max(1, parser.value(QStringLiteral("failure-rate")).toInt()));
+	if (parser.isSet(QStringLiteral("fixtures")) && !addFixtures(server, parser.value(QStringLiteral("fixtures")))) {
+		qCritical().noquote() << "Fixture directory" << parser.value(QStringLiteral("fixtures")) << "does not exist";
+		return EXIT_FAILURE;
+	}
+
+#ifndef QT_NO_SSL
+	if (parser.isSet(QStringLiteral("ssl-cert"))) {
+		QFile certificateFile{parser.value(QStringLiteral("ssl-cert"))};
+		QFile keyFile{parser.value(QStringLiteral("ssl-key"))};
+		if (!certificateFile.open(QIODevice::ReadOnly) || !keyFile.open(QIODevice::ReadOnly)) {
+			qCritical() << "Failed to read the TLS certificate or key";
+			return EXIT_FAILURE;
+		}
+		auto sslConfiguration = QSslConfiguration::defaultConfiguration();
+		sslConfiguration.setLocalCertificate(QSslCertificate{&certificateFile, QSsl::Pem});
+		sslConfiguration.setPrivateKey(QSslKey{&keyFile, QSsl::Rsa, QSsl::Pem});
+		server.setSslConfiguration(sslConfiguration);
+	}
+#endif
+
+	if (!server.start(static_cast<quint16>(parser.value(QStringLiteral("port")).toUInt()))) {
+		qCritical().noquote() << "Failed to listen:" << server.errorString();
+		return EXIT_FAILURE;
+	}
+	qInfo().noquote() << "Listening on" << server.url().toString();
+	return app.exec();
+}
@@ -0,0 +1,12 @@
+TEMPLATE = app
+
+QT = core network
+CONFIG += console
+CONFIG -= app_bundle
+
+TARGET = qtrest-testserver
+
+include(../shared/shared.pri)
+
+SOURCES += \
+	main.cpp